@@ -0,0 +1,71 @@
+/**
+ * Cold start of a feed tree: built item by item with Add, as when parsing a
+ * JSON cache, against TreeSerializer::Restore of a binary snapshot with raw
+ * (trivially copyable) items.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "pandora/tree_serializer.h"
+
+using namespace pandora;
+
+namespace
+{
+    constexpr int kSections = 8;
+
+    struct Row
+    {
+        int64_t id;
+        int64_t timestamp;
+        int32_t version;
+        int32_t flags;
+
+        bool operator==(const Row& other) const { return id == other.id; }
+    };
+
+    // Arguments are {items per section}
+    std::unique_ptr<PandoraBoxAdapter<Row>> BuildByAdd(int items_per_section)
+    {
+        auto root = std::make_unique<WrapperDataSet<Row>>();
+        std::vector<PandoraBoxAdapter<Row>*> sections;
+        for (int s = 0; s < kSections; ++s)
+        {
+            auto section = std::make_unique<RealDataSet<Row>>();
+            sections.push_back(section.get());
+            root->AddChild(std::move(section));
+        }
+        int64_t id = 0;
+        for (auto* section : sections)
+        {
+            for (int i = 0; i < items_per_section; ++i, ++id) section->Add(Row{id, id * 1000, 0, 0});
+        }
+        return root;
+    }
+
+    void BM_BuildByAdd(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(BuildByAdd(static_cast<int>(state.range(0))));
+        }
+        state.SetItemsProcessed(state.iterations() * kSections * state.range(0));
+    }
+
+    void BM_Restore(benchmark::State& state)
+    {
+        const auto tree = BuildByAdd(static_cast<int>(state.range(0)));
+        const std::vector<uint8_t> snapshot = TreeSerializer<Row>::Save(*tree);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(TreeSerializer<Row>::Restore(snapshot));
+        }
+        state.SetItemsProcessed(state.iterations() * kSections * state.range(0));
+        state.counters["snapshot_bytes"] = static_cast<double>(snapshot.size());
+    }
+} // namespace
+
+BENCHMARK(BM_BuildByAdd)->ArgName("items_per_section")->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Restore)->ArgName("items_per_section")->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
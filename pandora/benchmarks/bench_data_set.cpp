@@ -0,0 +1,261 @@
+/**
+ * End-to-end mutation benchmarks: a single mutation on a RealDataSet, alone or
+ * as a leaf of a WrapperDataSet tree, through snapshot, diff and dispatch to a
+ * counting ListUpdateCallback attached to the root.
+ *
+ * Arguments are {fan-out, depth}; depth 0 is a bare RealDataSet. Every tree
+ * holds about kTotalItems items spread over its leaves, and mutations go to
+ * the middle leaf. The time of each phase is reported per mutation through
+ * PANDORA_TIME_PHASE, which the benchmark target enables.
+ */
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "benchmark_support.h"
+#include "pandora/phase_timing.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+
+using namespace pandora;
+using namespace pandora::bench;
+
+namespace
+{
+    constexpr int kTotalItems = 10000;
+    constexpr int kTransactionSize = 10;
+
+    struct Item
+    {
+        int id;
+        int version;
+
+        bool operator==(const Item& other) const { return id == other.id; }
+
+        size_t Hash() const
+        {
+            size_t seed = 0;
+            HashCombine(seed, id);
+            HashCombine(seed, version);
+            return seed;
+        }
+    };
+
+    enum class Mutation
+    {
+        ADD,
+        ADD_AT,
+        REMOVE_AT,
+        REPLACE,
+        SET_DATA,
+        SET_SAME_DATA,
+        TRANSACTION,
+    };
+
+    class Tree
+    {
+    public:
+        Tree(int fan_out, int depth)
+        {
+            int leaves = 1;
+            for (int i = 0; i < depth; ++i) leaves *= fan_out;
+            leaf_size_ = std::max(1, kTotalItems / leaves);
+            target_leaf_index_ = leaves / 2;
+
+            root_ = Build(fan_out, depth);
+            auto callback = std::make_unique<CountingListUpdateCallback>();
+            callback_ = callback.get();
+            root_->SetListUpdateCallback(std::move(callback));
+        }
+
+        PandoraBoxAdapter<Item>& Root() { return *root_; }
+        RealDataSet<Item>& Target() { return *target_; }
+        const CountingListUpdateCallback& Callback() const { return *callback_; }
+
+        int NextId() { return next_id_++; }
+
+        std::vector<Item> TargetItems()
+        {
+            std::vector<Item> items;
+            for (int i = 0; i < target_->GetDataCount(); ++i) items.push_back(*target_->GetDataByIndex(i));
+            return items;
+        }
+
+    private:
+        std::unique_ptr<PandoraBoxAdapter<Item>> Build(int fan_out, int depth)
+        {
+            if (depth == 0)
+            {
+                auto leaf = std::make_unique<RealDataSet<Item>>();
+                std::vector<Item> items;
+                for (int i = 0; i < leaf_size_; ++i) items.push_back(Item{NextId(), 0});
+                leaf->SetData(items);
+                if (leaf_count_++ == target_leaf_index_) target_ = leaf.get();
+                return leaf;
+            }
+
+            auto wrapper = std::make_unique<WrapperDataSet<Item>>();
+            for (int i = 0; i < fan_out; ++i)
+            {
+                wrapper->AddChild(Build(fan_out, depth - 1));
+            }
+            return wrapper;
+        }
+
+        std::unique_ptr<PandoraBoxAdapter<Item>> root_;
+        RealDataSet<Item>* target_ = nullptr;
+        CountingListUpdateCallback* callback_ = nullptr;
+        int leaf_size_ = 0;
+        int leaf_count_ = 0;
+        int target_leaf_index_ = 0;
+        int next_id_ = 0;
+    };
+
+    // Runs one mutation and sets undo to what restores the tree, run untimed
+    void Mutate(Tree& tree, Mutation mutation, const std::vector<Item>& alternate, std::function<void()>& undo)
+    {
+        RealDataSet<Item>& target = tree.Target();
+        const int middle = target.GetDataCount() / 2;
+        switch (mutation)
+        {
+        case Mutation::ADD:
+            target.Add(Item{tree.NextId(), 0});
+            undo = [&target] { target.RemoveAtPos(target.GetDataCount() - 1); };
+            break;
+        case Mutation::ADD_AT:
+            target.Add(middle, Item{tree.NextId(), 0});
+            undo = [&target, middle] { target.RemoveAtPos(middle); };
+            break;
+        case Mutation::REMOVE_AT:
+        {
+            const Item removed = *target.GetDataByIndex(middle);
+            target.RemoveAtPos(middle);
+            undo = [&target, middle, removed] { target.Add(middle, removed); };
+            break;
+        }
+        case Mutation::REPLACE:
+        {
+            Item item = *target.GetDataByIndex(middle);
+            item.version++;
+            target.ReplaceAtPosIfExist(middle, item);
+            undo = nullptr;
+            break;
+        }
+        case Mutation::SET_DATA:
+        {
+            const std::vector<Item> previous = tree.TargetItems();
+            target.SetData(alternate);
+            undo = [&target, previous] { target.SetData(previous); };
+            break;
+        }
+        case Mutation::SET_SAME_DATA:
+            // A refresh that brings nothing new
+            target.SetData(alternate);
+            undo = nullptr;
+            break;
+        case Mutation::TRANSACTION:
+            tree.Root().StartTransaction();
+            for (int i = 0; i < kTransactionSize; ++i)
+            {
+                target.Add(middle, Item{tree.NextId(), 0});
+            }
+            tree.Root().EndTransaction();
+            undo = [&target, middle]
+            {
+                for (int i = 0; i < kTransactionSize; ++i) target.RemoveAtPos(middle);
+            };
+            break;
+        }
+    }
+
+    // The target leaf with every tenth item changed, one in ten removed and a few new ones
+    std::vector<Item> MakeAlternate(Tree& tree)
+    {
+        std::vector<Item> items;
+        const std::vector<Item> current = tree.TargetItems();
+        for (size_t i = 0; i < current.size(); ++i)
+        {
+            Item item = current[i];
+            if (i % 10 == 3) continue;
+            if (i % 10 == 7) item.version++;
+            items.push_back(item);
+            if (i % 50 == 0) items.push_back(Item{tree.NextId(), 0});
+        }
+        return items;
+    }
+
+    void BM_Mutation(benchmark::State& state, Mutation mutation)
+    {
+        Tree tree(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+        const std::vector<Item> alternate =
+            mutation == Mutation::SET_SAME_DATA ? tree.TargetItems() : MakeAlternate(tree);
+
+        PhaseTimes phases;
+        uint64_t callbacks = 0;
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+        std::function<void()> undo;
+
+        for (auto _ : state)
+        {
+            const PhaseTimes phases_before = ThreadPhaseTimes();
+            const uint64_t callbacks_before = tree.Callback().GetInvocations();
+            const uint64_t allocations_before = AllocationCount();
+            const uint64_t bytes_before = AllocatedBytes();
+
+            Mutate(tree, mutation, alternate, undo);
+
+            allocations += AllocationCount() - allocations_before;
+            allocated_bytes += AllocatedBytes() - bytes_before;
+            callbacks += tree.Callback().GetInvocations() - callbacks_before;
+            const PhaseTimes delta = ThreadPhaseTimes() - phases_before;
+            for (int i = 0; i < static_cast<int>(Phase::COUNT); ++i)
+            {
+                phases.nanos[i] += delta.nanos[i];
+                phases.calls[i] += delta.calls[i];
+            }
+
+            if (undo)
+            {
+                state.PauseTiming();
+                undo();
+                state.ResumeTiming();
+            }
+        }
+
+        const auto per_op = benchmark::Counter::kAvgIterations;
+        state.counters["snapshot_us"] = benchmark::Counter(phases.GetNanos(Phase::SNAPSHOT) / 1e3, per_op);
+        state.counters["diff_us"] = benchmark::Counter(phases.GetNanos(Phase::DIFF) / 1e3, per_op);
+        state.counters["dispatch_us"] = benchmark::Counter(phases.GetNanos(Phase::DISPATCH) / 1e3, per_op);
+        state.counters["snapshots/op"] = benchmark::Counter(static_cast<double>(phases.GetCalls(Phase::SNAPSHOT)), per_op);
+        state.counters["callbacks/op"] = benchmark::Counter(static_cast<double>(callbacks), per_op);
+        state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(allocations), per_op);
+        state.counters["alloc_bytes/op"] = benchmark::Counter(static_cast<double>(allocated_bytes), per_op);
+    }
+
+    void TreeShapes(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({"fan_out", "depth"});
+        benchmark->Args({1, 0});   // Bare RealDataSet
+        benchmark->Args({4, 1});
+        benchmark->Args({16, 1});
+        benchmark->Args({64, 1});
+        benchmark->Args({4, 3});
+        benchmark->Args({8, 3});
+        benchmark->Args({4, 6});
+        benchmark->Args({2, 8});
+    }
+} // namespace
+
+#define PANDORA_MUTATION_BENCHMARK(mutation) \
+    BENCHMARK_CAPTURE(BM_Mutation, mutation, Mutation::mutation)->Apply(TreeShapes)->Unit(benchmark::kMicrosecond)
+
+PANDORA_MUTATION_BENCHMARK(ADD);
+PANDORA_MUTATION_BENCHMARK(ADD_AT);
+PANDORA_MUTATION_BENCHMARK(REMOVE_AT);
+PANDORA_MUTATION_BENCHMARK(REPLACE);
+PANDORA_MUTATION_BENCHMARK(SET_DATA);
+PANDORA_MUTATION_BENCHMARK(SET_SAME_DATA);
+PANDORA_MUTATION_BENCHMARK(TRANSACTION);
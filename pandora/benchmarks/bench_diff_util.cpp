@@ -0,0 +1,234 @@
+/**
+ * DiffUtil benchmarks: CalculateDiff and DispatchUpdatesTo over typical list
+ * updates, with and without move detection.
+ *
+ * Arguments are {list size, detect moves}. Workloads with a bounded edit count
+ * (append, prepend, random edits) run up to 10M items; shuffle, reverse and
+ * full replacement have an edit distance proportional to the size, which makes
+ * the diff quadratic, so they stop at 10K.
+ */
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "benchmark_support.h"
+#include "pandora/diff_util.h"
+
+using namespace pandora;
+using namespace pandora::bench;
+
+namespace
+{
+    struct Item
+    {
+        int id;
+        int version;
+    };
+
+    enum class Workload
+    {
+        APPEND,
+        PREPEND,
+        RANDOM_EDITS,
+        SHUFFLE,
+        REVERSE,
+        REPLACE,
+    };
+
+    struct ListPair
+    {
+        std::vector<Item> old_list;
+        std::vector<Item> new_list;
+    };
+
+    class ItemDiffCallback : public DiffCallback
+    {
+    public:
+        explicit ItemDiffCallback(const ListPair& lists) : lists_(lists) {}
+
+        int GetOldListSize() const override { return static_cast<int>(lists_.old_list.size()); }
+
+        int GetNewListSize() const override { return static_cast<int>(lists_.new_list.size()); }
+
+        bool AreItemsTheSame(int old_item_position, int new_item_position) const override
+        {
+            return lists_.old_list[old_item_position].id == lists_.new_list[new_item_position].id;
+        }
+
+        bool AreContentsTheSame(int old_item_position, int new_item_position) const override
+        {
+            return lists_.old_list[old_item_position].version == lists_.new_list[new_item_position].version;
+        }
+
+    private:
+        const ListPair& lists_;
+    };
+
+    // Edits applied by the bounded workloads
+    int EditCount(int size)
+    {
+        return std::max(1, std::min(size / 10, 100));
+    }
+
+    ListPair MakeLists(Workload workload, int size)
+    {
+        ListPair lists;
+        lists.old_list.reserve(size);
+        for (int i = 0; i < size; ++i)
+        {
+            lists.old_list.push_back(Item{i, 0});
+        }
+
+        std::mt19937 random(42);
+        int next_id = size;
+        std::vector<Item>& new_list = lists.new_list;
+        new_list = lists.old_list;
+
+        switch (workload)
+        {
+        case Workload::APPEND:
+            for (int i = 0; i < EditCount(size); ++i) new_list.push_back(Item{next_id++, 0});
+            break;
+        case Workload::PREPEND:
+            for (int i = 0; i < EditCount(size); ++i) new_list.insert(new_list.begin(), Item{next_id++, 0});
+            break;
+        case Workload::RANDOM_EDITS:
+            for (int i = 0; i < EditCount(size); ++i)
+            {
+                const int position = static_cast<int>(random() % new_list.size());
+                switch (random() % 3)
+                {
+                case 0:
+                    new_list.insert(new_list.begin() + position, Item{next_id++, 0});
+                    break;
+                case 1:
+                    if (new_list.size() > 1) new_list.erase(new_list.begin() + position);
+                    break;
+                default:
+                    new_list[position].version++;
+                    break;
+                }
+            }
+            break;
+        case Workload::SHUFFLE:
+            std::shuffle(new_list.begin(), new_list.end(), random);
+            break;
+        case Workload::REVERSE:
+            std::reverse(new_list.begin(), new_list.end());
+            break;
+        case Workload::REPLACE:
+            for (auto& item : new_list) item.id = next_id++;
+            break;
+        }
+        return lists;
+    }
+
+    void BM_CalculateDiff(benchmark::State& state, Workload workload)
+    {
+        const ListPair lists = MakeLists(workload, static_cast<int>(state.range(0)));
+        const bool detect_moves = state.range(1) != 0;
+        ItemDiffCallback callback(lists);
+
+        AllocationReporter allocations(state);
+        for (auto _ : state)
+        {
+            auto result = DiffUtil::CalculateDiff(&callback, detect_moves);
+            benchmark::DoNotOptimize(result.get());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_DispatchUpdatesTo(benchmark::State& state, Workload workload)
+    {
+        const ListPair lists = MakeLists(workload, static_cast<int>(state.range(0)));
+        ItemDiffCallback callback(lists);
+        auto result = DiffUtil::CalculateDiff(&callback, state.range(1) != 0);
+        CountingListUpdateCallback updates;
+
+        AllocationReporter allocations(state);
+        for (auto _ : state)
+        {
+            result->DispatchUpdatesTo(&updates);
+        }
+        updates.Report(state);
+    }
+
+    // CalculateDiff followed by DispatchUpdatesTo, as a data set runs them
+    void BM_DiffAndDispatch(benchmark::State& state, Workload workload)
+    {
+        const ListPair lists = MakeLists(workload, static_cast<int>(state.range(0)));
+        const bool detect_moves = state.range(1) != 0;
+        ItemDiffCallback callback(lists);
+        CountingListUpdateCallback updates;
+
+        AllocationReporter allocations(state);
+        for (auto _ : state)
+        {
+            DiffUtil::CalculateDiff(&callback, detect_moves)->DispatchUpdatesTo(&updates);
+        }
+        updates.Report(state);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // Remaps every old position, as when restoring a large selection after a diff
+    void BM_RemapPositions(benchmark::State& state)
+    {
+        const ListPair lists = MakeLists(Workload::RANDOM_EDITS, static_cast<int>(state.range(0)));
+        const bool batch = state.range(1) != 0;
+        ItemDiffCallback callback(lists);
+        const auto result = DiffUtil::CalculateDiff(&callback, true);
+        std::vector<int> positions(lists.old_list.size());
+
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < positions.size(); ++i) positions[i] = static_cast<int>(i);
+            if (batch)
+            {
+                result->ConvertOldPositionsToNew(positions);
+            }
+            else
+            {
+                for (int& position : positions) position = result->ConvertOldPositionToNew(position);
+            }
+            benchmark::DoNotOptimize(positions.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void UpTo10M(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({"size", "moves"});
+        for (int64_t size = 10; size <= 10000000; size *= 10)
+        {
+            benchmark->Args({size, 0})->Args({size, 1});
+        }
+    }
+
+    void UpTo10K(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({"size", "moves"});
+        for (int64_t size = 10; size <= 10000; size *= 10)
+        {
+            benchmark->Args({size, 0})->Args({size, 1});
+        }
+    }
+} // namespace
+
+#define PANDORA_DIFF_BENCHMARK(function, workload, sizes) \
+    BENCHMARK_CAPTURE(function, workload, Workload::workload)->Apply(sizes)->Unit(benchmark::kMicrosecond)
+
+#define PANDORA_DIFF_BENCHMARKS(workload, sizes)                 \
+    PANDORA_DIFF_BENCHMARK(BM_CalculateDiff, workload, sizes);    \
+    PANDORA_DIFF_BENCHMARK(BM_DispatchUpdatesTo, workload, sizes); \
+    PANDORA_DIFF_BENCHMARK(BM_DiffAndDispatch, workload, sizes)
+
+PANDORA_DIFF_BENCHMARKS(APPEND, UpTo10M);
+PANDORA_DIFF_BENCHMARKS(PREPEND, UpTo10M);
+PANDORA_DIFF_BENCHMARKS(RANDOM_EDITS, UpTo10M);
+PANDORA_DIFF_BENCHMARKS(SHUFFLE, UpTo10K);
+PANDORA_DIFF_BENCHMARKS(REVERSE, UpTo10K);
+PANDORA_DIFF_BENCHMARKS(REPLACE, UpTo10K);
+
+BENCHMARK(BM_RemapPositions)->ArgNames({"size", "batch"})->Args({100000, 0})->Args({100000, 1})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,85 @@
+/**
+ * Snapshot hashing of plain rows: a Hash() member chaining HashCombine field
+ * by field against the built-in bytewise hasher, one item at a time and
+ * through HashRange as Snapshot() calls it.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+#include "pandora/pandora_traits.h"
+
+using namespace pandora;
+
+namespace
+{
+    constexpr int kRows = 10000;
+
+    struct PodRow
+    {
+        int64_t id;
+        int64_t timestamp;
+        int32_t version;
+        int32_t flags;
+        int64_t author_id;
+    };
+
+    struct CombinedRow
+    {
+        int64_t id;
+        int64_t timestamp;
+        int32_t version;
+        int32_t flags;
+        int64_t author_id;
+
+        size_t Hash() const
+        {
+            size_t seed = 0;
+            HashCombine(seed, id);
+            HashCombine(seed, timestamp);
+            HashCombine(seed, version);
+            HashCombine(seed, flags);
+            HashCombine(seed, author_id);
+            return seed;
+        }
+    };
+
+    template <typename Row>
+    std::vector<Row> MakeRows()
+    {
+        std::vector<Row> rows;
+        for (int i = 0; i < kRows; ++i) rows.push_back(Row{i, i * 1000LL, i % 7, 0, i * 31LL});
+        return rows;
+    }
+
+    template <typename Row>
+    void BM_HashEach(benchmark::State& state)
+    {
+        const std::vector<Row> rows = MakeRows<Row>();
+        std::vector<size_t> hashes(rows.size());
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < rows.size(); ++i) hashes[i] = Pandora::Hash(rows[i]);
+            benchmark::DoNotOptimize(hashes.data());
+        }
+        state.SetItemsProcessed(state.iterations() * kRows);
+    }
+
+    template <typename Row>
+    void BM_HashRange(benchmark::State& state)
+    {
+        const std::vector<Row> rows = MakeRows<Row>();
+        std::vector<size_t> hashes(rows.size());
+        for (auto _ : state)
+        {
+            Pandora::HashRange(rows.data(), rows.size(), hashes.data());
+            benchmark::DoNotOptimize(hashes.data());
+        }
+        state.SetItemsProcessed(state.iterations() * kRows);
+    }
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_HashEach, CombinedRow);
+BENCHMARK_TEMPLATE(BM_HashEach, PodRow);
+BENCHMARK_TEMPLATE(BM_HashRange, CombinedRow);
+BENCHMARK_TEMPLATE(BM_HashRange, PodRow);
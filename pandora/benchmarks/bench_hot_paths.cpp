@@ -0,0 +1,133 @@
+/**
+ * Indexed reads as issued by a list while binding rows: GetDataByIndex on a
+ * leaf and through a wrapper tree, and the rv GetItem / GetItemViewTypeV2
+ * pair. Each reports allocs/op and alloc_bytes/op, which should stay at zero.
+ */
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "benchmark_support.h"
+#include "pandora/pandora_rv.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+
+using namespace pandora;
+using namespace pandora::bench;
+using namespace pandora::rv;
+
+namespace
+{
+    constexpr int kItems = 10000;
+
+    struct Item
+    {
+        int id;
+
+        bool operator==(const Item& other) const { return id == other.id; }
+        size_t Hash() const { return static_cast<size_t>(id); }
+    };
+
+    class Row final : public DataSet<Row>::Data
+    {
+    public:
+        explicit Row(int v) : value(v) {}
+
+        void SetToViewHolder(const std::shared_ptr<IViewHolder<Data>> view_holder) override {}
+
+        size_t Hash() const { return static_cast<size_t>(value); }
+        bool operator==(const Row& other) const { return value == other.value; }
+
+        int value;
+    };
+
+    class RowViewHolder : public IViewHolder<Row>
+    {
+    public:
+        void SetData(std::shared_ptr<Row> data) override {}
+        void OnViewAttachedToWindow() override {}
+        void OnViewDetachedFromWindow() override {}
+        void accept(IViewHolderVisitor& visitor) override {}
+    };
+
+    std::vector<Item> MakeItems(int first, int count)
+    {
+        std::vector<Item> items;
+        for (int i = 0; i < count; ++i) items.push_back(Item{first + i});
+        return items;
+    }
+
+    // Arguments are {fan_out}: a root wrapper over fan_out leaves holding kItems in total
+    std::unique_ptr<PandoraBoxAdapter<Item>> MakeTree(int fan_out)
+    {
+        if (fan_out == 0)
+        {
+            auto leaf = std::make_unique<RealDataSet<Item>>();
+            leaf->SetData(MakeItems(0, kItems));
+            return leaf;
+        }
+        auto root = std::make_unique<WrapperDataSet<Item>>();
+        for (int i = 0; i < fan_out; ++i)
+        {
+            auto leaf = std::make_unique<RealDataSet<Item>>();
+            leaf->SetData(MakeItems(i * (kItems / fan_out), kItems / fan_out));
+            root->AddChild(std::move(leaf));
+        }
+        return root;
+    }
+
+    void BM_GetDataByIndex(benchmark::State& state)
+    {
+        auto root = MakeTree(static_cast<int>(state.range(0)));
+        const int count = root->GetDataCount();
+        int index = 0;
+        AllocationReporter allocations(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(root->GetDataByIndex(index));
+            index = index + 7919 < count ? index + 7919 : index + 7919 - count;
+        }
+    }
+
+    std::shared_ptr<PandoraRealRvDataSet<Row>> MakeRvDataSet()
+    {
+        auto rv_data_set = std::make_shared<PandoraRealRvDataSet<Row>>(std::make_shared<RealDataSet<Row>>());
+        rv_data_set->RegisterDvRelation<Row>(make_lambda_creator<Row>([](void*)
+        {
+            return std::make_shared<RowViewHolder>();
+        }));
+        rv_data_set->StartTransaction();
+        for (int i = 0; i < kItems; ++i) rv_data_set->Add(Row(i));
+        rv_data_set->EndTransaction();
+        rv_data_set->GetItemViewTypeV2(0);
+        return rv_data_set;
+    }
+
+    void BM_RvGetItem(benchmark::State& state)
+    {
+        auto rv_data_set = MakeRvDataSet();
+        int index = 0;
+        AllocationReporter allocations(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(rv_data_set->GetItem(index));
+            index = (index + 1) % kItems;
+        }
+    }
+
+    void BM_RvGetItemViewTypeV2(benchmark::State& state)
+    {
+        auto rv_data_set = MakeRvDataSet();
+        int index = 0;
+        AllocationReporter allocations(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(rv_data_set->GetItemViewTypeV2(index));
+            index = (index + 1) % kItems;
+        }
+    }
+} // namespace
+
+BENCHMARK(BM_GetDataByIndex)->ArgName("fan_out")->Arg(0)->Arg(4)->Arg(64);
+BENCHMARK(BM_RvGetItem);
+BENCHMARK(BM_RvGetItemViewTypeV2);
@@ -0,0 +1,201 @@
+/**
+ * Replays a mutation trace (see MutationRecorder) against different leaf
+ * storages and reports throughput and per-mutation latency.
+ *
+ * The trace is read from the file named by PANDORA_REPLAY_TRACE, e.g. one
+ * recorded in production; without it a synthetic feed session is recorded
+ * once at startup. Items are rebuilt as ReplayItem from their recorded id and
+ * content hash, which is all the diff looks at, so a trace of any item type
+ * can be replayed here.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "benchmark_support.h"
+#include "pandora/mapped_storage.h"
+#include "pandora/metrics.h"
+#include "pandora/mutation_recorder.h"
+#include "pandora/mutation_replay.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+
+using namespace pandora;
+using namespace pandora::bench;
+
+namespace
+{
+    constexpr int kSections = 8;
+    constexpr int kLeavesPerSection = 4;
+    constexpr int kItemsPerLeaf = 250;
+    constexpr int kSessionMutations = 2000;
+
+    struct ReplayItem
+    {
+        uint64_t id;
+        uint64_t content_hash;
+
+        bool operator==(const ReplayItem& other) const { return id == other.id; }
+        size_t Hash() const { return static_cast<size_t>(content_hash); }
+    };
+
+    ReplayItem MakeItem(uint64_t id, uint64_t content_hash) { return ReplayItem{id, content_hash}; }
+
+    // A feed: sections of pages, mostly in-place updates, some appends, removals and refreshes
+    std::vector<uint8_t> RecordSyntheticSession()
+    {
+        std::mt19937_64 random(42);
+        uint64_t next_id = 0;
+        auto new_item = [&] { return ReplayItem{next_id++, random()}; };
+
+        WrapperDataSet<ReplayItem> root;
+        std::vector<RealDataSet<ReplayItem>*> leaves;
+        for (int s = 0; s < kSections; ++s)
+        {
+            auto section = std::make_unique<WrapperDataSet<ReplayItem>>();
+            for (int l = 0; l < kLeavesPerSection; ++l)
+            {
+                auto leaf = std::make_unique<RealDataSet<ReplayItem>>();
+                std::vector<ReplayItem> items;
+                for (int i = 0; i < kItemsPerLeaf; ++i) items.push_back(new_item());
+                leaf->SetData(items);
+                leaves.push_back(leaf.get());
+                section->AddChild(std::move(leaf));
+            }
+            root.AddChild(std::move(section));
+        }
+
+        MutationRecorder<ReplayItem> recorder(&root, [](const ReplayItem& item) { return item.id; });
+        auto random_index = [&](int bound) { return static_cast<int>(random() % static_cast<uint64_t>(bound)); };
+        for (int m = 0; m < kSessionMutations; ++m)
+        {
+            const int kind = random_index(100);
+            const int count = root.GetDataCount();
+            if (kind < 40 && count > 0)
+            {
+                const int position = random_index(count);
+                root.ReplaceAtPosIfExist(position, ReplayItem{root.GetDataByIndex(position)->id, random()});
+            }
+            else if (kind < 60)
+            {
+                leaves[random_index(kSections) * kLeavesPerSection + kLeavesPerSection - 1]->Add(new_item());
+            }
+            else if (kind < 75 && count > 0)
+            {
+                root.RemoveAtPos(random_index(count));
+            }
+            else if (kind < 85)
+            {
+                root.Add(random_index(count + 1), new_item());
+            }
+            else if (kind < 95 && count > 0)
+            {
+                root.StartTransaction();
+                for (int i = 0; i < 5; ++i)
+                {
+                    const int position = random_index(count);
+                    root.ReplaceAtPosIfExist(position, ReplayItem{root.GetDataByIndex(position)->id, random()});
+                }
+                root.EndTransaction();
+            }
+            else
+            {
+                RealDataSet<ReplayItem>* leaf = leaves[random_index(static_cast<int>(leaves.size()))];
+                std::vector<ReplayItem> items;
+                for (int i = 0; i < leaf->GetDataCount(); ++i)
+                {
+                    if (random_index(10) == 0) continue;
+                    items.push_back(*leaf->GetDataByIndex(i));
+                }
+                for (int i = 0; i < 10; ++i) items.insert(items.begin() + random_index(static_cast<int>(items.size()) + 1), new_item());
+                leaf->SetData(items);
+            }
+        }
+        recorder.Stop();
+        return recorder.GetTrace();
+    }
+
+    const std::vector<uint8_t>& Trace()
+    {
+        static const std::vector<uint8_t> trace = []
+        {
+            const char* path = std::getenv("PANDORA_REPLAY_TRACE");
+            if (path == nullptr) return RecordSyntheticSession();
+            std::ifstream in(path, std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }();
+        return trace;
+    }
+
+    void RunReplay(benchmark::State& state, const MutationReplayer<ReplayItem>::MakeLeaf& make_leaf,
+                   const std::function<void()>& after_iteration)
+    {
+        const MutationReplayer<ReplayItem> replayer(Trace(), MakeItem);
+        LatencyHistogram latency;
+        uint64_t mutations = 0;
+        uint64_t callbacks = 0;
+        ReplayStats stats;
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto root = replayer.BuildTree(make_leaf);
+            auto callback = std::make_unique<CountingListUpdateCallback>();
+            const CountingListUpdateCallback* counting = callback.get();
+            root->SetListUpdateCallback(std::move(callback));
+            state.ResumeTiming();
+
+            stats = replayer.Replay(*root, &latency);
+
+            state.PauseTiming();
+            mutations += stats.mutations;
+            callbacks += counting->GetInvocations();
+            root.reset();
+            if (after_iteration) after_iteration();
+            state.ResumeTiming();
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(mutations));
+        state.counters["mutations"] = static_cast<double>(stats.mutations);
+        state.counters["recorded_ms"] = static_cast<double>(stats.recorded_nanos) / 1e6;
+        state.counters["p50_us"] = static_cast<double>(latency.GetPercentile(50)) / 1e3;
+        state.counters["p99_us"] = static_cast<double>(latency.GetPercentile(99)) / 1e3;
+        state.counters["max_us"] = static_cast<double>(latency.GetMax()) / 1e3;
+        state.counters["callbacks/op"] = benchmark::Counter(static_cast<double>(callbacks), benchmark::Counter::kAvgIterations);
+    }
+
+    void BM_ReplayVectorStorage(benchmark::State& state)
+    {
+        RunReplay(state, nullptr, nullptr);
+    }
+
+    void BM_ReplayMappedStorage(benchmark::State& state)
+    {
+        const std::string prefix = (std::filesystem::temp_directory_path() / "pandora_replay_").string();
+        std::vector<std::string> paths;
+        auto make_leaf = [&paths, &prefix]
+        {
+            paths.push_back(prefix + std::to_string(paths.size()) + ".bin");
+            std::remove(paths.back().c_str());
+            return std::unique_ptr<PandoraBoxAdapter<ReplayItem>>(
+                new RealDataSet<ReplayItem, MappedStorage<ReplayItem>>(MappedStorage<ReplayItem>::Open(paths.back())));
+        };
+        auto remove_files = [&paths]
+        {
+            for (const auto& path : paths) std::remove(path.c_str());
+            paths.clear();
+        };
+        RunReplay(state, make_leaf, remove_files);
+    }
+} // namespace
+
+BENCHMARK(BM_ReplayVectorStorage)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReplayMappedStorage)->Unit(benchmark::kMillisecond);
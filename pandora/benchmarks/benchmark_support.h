@@ -0,0 +1,85 @@
+#ifndef PANDORA_BENCHMARK_SUPPORT_H
+#define PANDORA_BENCHMARK_SUPPORT_H
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include "allocation_counter.h"
+#include "pandora/list_update_callback.h"
+
+namespace pandora
+{
+namespace bench
+{
+    /**
+     * @brief Number of global operator new calls since the process started
+     *
+     * Counted by the replacement operators in testing/allocation_counter.cpp.
+     */
+    inline uint64_t AllocationCount()
+    {
+        return alloc_counter::ProcessAllocationCount();
+    }
+
+    /**
+     * @brief Bytes requested from global operator new since the process started
+     */
+    inline uint64_t AllocatedBytes()
+    {
+        return alloc_counter::ProcessAllocatedBytes();
+    }
+
+    /**
+     * @brief Reports allocations per iteration for the code inside its lifetime
+     *
+     * Create it right before the benchmark loop; the destructor adds the
+     * "allocs/op" and "alloc_bytes/op" counters.
+     */
+    class AllocationReporter
+    {
+    public:
+        explicit AllocationReporter(benchmark::State& state)
+            : state_(state), start_(AllocationCount()), start_bytes_(AllocatedBytes()) {}
+
+        ~AllocationReporter()
+        {
+            state_.counters["allocs/op"] = benchmark::Counter(
+                static_cast<double>(AllocationCount() - start_), benchmark::Counter::kAvgIterations);
+            state_.counters["alloc_bytes/op"] = benchmark::Counter(
+                static_cast<double>(AllocatedBytes() - start_bytes_), benchmark::Counter::kAvgIterations);
+        }
+
+        AllocationReporter(const AllocationReporter&) = delete;
+        AllocationReporter& operator=(const AllocationReporter&) = delete;
+
+    private:
+        benchmark::State& state_;
+        uint64_t start_;
+        uint64_t start_bytes_;
+    };
+
+    /**
+     * @brief ListUpdateCallback counting invocations, reported as "callbacks/op"
+     */
+    class CountingListUpdateCallback : public ListUpdateCallback
+    {
+    public:
+        void OnInserted(int /*position*/, int /*count*/) override { ++invocations_; }
+        void OnRemoved(int /*position*/, int /*count*/) override { ++invocations_; }
+        void OnMoved(int /*from_position*/, int /*to_position*/) override { ++invocations_; }
+        void OnChanged(int /*position*/, int /*count*/, void* /*payload*/) override { ++invocations_; }
+
+        [[nodiscard]] uint64_t GetInvocations() const { return invocations_; }
+
+        void Report(benchmark::State& state) const
+        {
+            state.counters["callbacks/op"] = benchmark::Counter(
+                static_cast<double>(invocations_), benchmark::Counter::kAvgIterations);
+        }
+
+    private:
+        uint64_t invocations_ = 0;
+    };
+} // namespace bench
+} // namespace pandora
+
+#endif // PANDORA_BENCHMARK_SUPPORT_H
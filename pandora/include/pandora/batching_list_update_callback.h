@@ -0,0 +1,112 @@
+#ifndef PANDORA_BATCHING_LIST_UPDATE_CALLBACK_H_
+#define PANDORA_BATCHING_LIST_UPDATE_CALLBACK_H_
+
+#include <algorithm>
+
+#include "list_update_callback.h"
+#include "payload.h"
+
+namespace pandora {
+
+/**
+ * Wraps a ListUpdateCallback and joins consecutive updates of the same kind
+ * that touch adjacent ranges, like RecyclerView's BatchingListUpdateCallback.
+ *
+ * Changes are joined when their payloads merge (see Payload::Merge): both
+ * empty, or of the same type with a Merge member, such as FieldChangeMask.
+ * The pending update is dispatched when a different update arrives, on
+ * OnUpdatesDispatched, or on DispatchLastEvent; a borrowed void* payload has
+ * to stay valid until then.
+ */
+class BatchingListUpdateCallback : public ListUpdateCallback {
+ public:
+  explicit BatchingListUpdateCallback(ListUpdateCallback* wrapped) : wrapped_(wrapped) {}
+
+  void OnInserted(int position, int count) override {
+    if (last_type_ == kAdd && position >= last_position_ && position <= last_position_ + last_count_) {
+      last_count_ += count;
+      last_position_ = std::min(position, last_position_);
+      return;
+    }
+    DispatchLastEvent();
+    Start(kAdd, position, count);
+  }
+
+  void OnRemoved(int position, int count) override {
+    if (last_type_ == kRemove && last_position_ >= position && last_position_ <= position + count) {
+      last_count_ += count;
+      last_position_ = position;
+      return;
+    }
+    DispatchLastEvent();
+    Start(kRemove, position, count);
+  }
+
+  void OnMoved(int from_position, int to_position) override {
+    DispatchLastEvent();
+    wrapped_->OnMoved(from_position, to_position);
+  }
+
+  // A raw pointer payload is only joined with a change carrying the same pointer
+  void OnChanged(int position, int count, void* payload) override {
+    OnChangedWithPayload(position, count, Payload::Borrow(payload));
+  }
+
+  void OnChangedWithPayload(int position, int count, const Payload& payload) override {
+    if (last_type_ == kChange && position <= last_position_ + last_count_ &&
+        position + count >= last_position_ && last_payload_.Merge(payload)) {
+      const int end = std::max(last_position_ + last_count_, position + count);
+      last_position_ = std::min(position, last_position_);
+      last_count_ = end - last_position_;
+      return;
+    }
+    DispatchLastEvent();
+    Start(kChange, position, count);
+    last_payload_ = payload;
+  }
+
+  void OnUpdatesDispatched() override {
+    DispatchLastEvent();
+    wrapped_->OnUpdatesDispatched();
+  }
+
+  /**
+   * Dispatches the pending update, if any, to the wrapped callback.
+   */
+  void DispatchLastEvent() {
+    switch (last_type_) {
+      case kAdd:
+        wrapped_->OnInserted(last_position_, last_count_);
+        break;
+      case kRemove:
+        wrapped_->OnRemoved(last_position_, last_count_);
+        break;
+      case kChange:
+        wrapped_->OnChangedWithPayload(last_position_, last_count_, last_payload_);
+        last_payload_ = Payload();
+        break;
+      case kNone:
+        break;
+    }
+    last_type_ = kNone;
+  }
+
+ private:
+  enum Type { kNone, kAdd, kRemove, kChange };
+
+  void Start(Type type, int position, int count) {
+    last_type_ = type;
+    last_position_ = position;
+    last_count_ = count;
+  }
+
+  ListUpdateCallback* wrapped_;
+  Type last_type_ = kNone;
+  int last_position_ = -1;
+  int last_count_ = -1;
+  Payload last_payload_;
+};
+
+}  // namespace pandora
+
+#endif  // PANDORA_BATCHING_LIST_UPDATE_CALLBACK_H_
@@ -0,0 +1,154 @@
+#ifndef PANDORA_BINARY_IO_H_
+#define PANDORA_BINARY_IO_H_
+
+#include "pandora_exception.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Appends little-endian and LEB128 varint encoded values to a byte buffer
+     */
+    class BinaryWriter
+    {
+    public:
+        explicit BinaryWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+        void WriteU8(uint8_t value) { out_.push_back(value); }
+
+        void WriteVarint(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out_.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out_.push_back(static_cast<uint8_t>(value));
+        }
+
+        /// Zigzag encoded, so small negative values stay short
+        void WriteSignedVarint(int64_t value)
+        {
+            WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        void WriteFixed32(uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i) out_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+
+        void WriteFixed64(uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i) out_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+
+        void WriteString(const std::string& value)
+        {
+            WriteVarint(value.size());
+            out_.insert(out_.end(), value.begin(), value.end());
+        }
+
+        /// Raw bytes, without a length prefix
+        void WriteBytes(const void* data, size_t size)
+        {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            out_.insert(out_.end(), bytes, bytes + size);
+        }
+
+    private:
+        std::vector<uint8_t>& out_;
+    };
+
+    /**
+     * @brief Reads values written by BinaryWriter
+     *
+     * @throws PandoraException on truncated or malformed input
+     */
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+        explicit BinaryReader(const std::vector<uint8_t>& data) : BinaryReader(data.data(), data.size()) {}
+
+        [[nodiscard]] bool AtEnd() const { return position_ == size_; }
+
+        [[nodiscard]] size_t GetPosition() const { return position_; }
+
+        uint8_t ReadU8()
+        {
+            Require(1);
+            return data_[position_++];
+        }
+
+        uint64_t ReadVarint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                const uint8_t byte = ReadU8();
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+            throw PandoraException("BinaryReader: varint too long at " + std::to_string(position_));
+        }
+
+        int64_t ReadSignedVarint()
+        {
+            const uint64_t value = ReadVarint();
+            return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+
+        uint32_t ReadFixed32()
+        {
+            Require(4);
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(data_[position_++]) << (8 * i);
+            return value;
+        }
+
+        uint64_t ReadFixed64()
+        {
+            Require(8);
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(data_[position_++]) << (8 * i);
+            return value;
+        }
+
+        std::string ReadString()
+        {
+            const uint64_t length = ReadVarint();
+            Require(length);
+            std::string value(reinterpret_cast<const char*>(data_ + position_), static_cast<size_t>(length));
+            position_ += static_cast<size_t>(length);
+            return value;
+        }
+
+        /// The next size raw bytes, in place; valid as long as the input is
+        const uint8_t* ReadBytes(uint64_t size)
+        {
+            Require(size);
+            const uint8_t* bytes = data_ + position_;
+            position_ += static_cast<size_t>(size);
+            return bytes;
+        }
+
+    private:
+        void Require(uint64_t bytes) const
+        {
+            if (bytes > size_ - position_)
+            {
+                throw PandoraException("BinaryReader: unexpected end of input at " + std::to_string(position_));
+            }
+        }
+
+        const uint8_t* data_;
+        size_t size_;
+        size_t position_ = 0;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_BINARY_IO_H_
@@ -1,6 +1,8 @@
 #ifndef PANDORA_DIFF_CALLBACK_H_
 #define PANDORA_DIFF_CALLBACK_H_
 
+#include "payload.h"
+
 namespace pandora {
 
 /**
@@ -45,6 +47,43 @@ class DiffCallback {
    */
   virtual bool AreContentsTheSame(int old_item_position, int new_item_position) const = 0;
 
+  /**
+   * Counts the items that are the same, in the sense of AreItemsTheSame, in a run
+   * starting at the given positions. DiffUtil extends each snake with one call.
+   *
+   * The default calls AreItemsTheSame item by item. Override it to compare a whole
+   * run at once, e.g. with Pandora::MismatchLength over contiguous storage.
+   *
+   * @param old_item_position The first position in the old list
+   * @param new_item_position The first position in the new list
+   * @param max_count The run length to check at most, within both lists
+   * @return The number of leading pairs that are the same, at most max_count.
+   */
+  virtual int CountItemsTheSame(int old_item_position, int new_item_position, int max_count) const {
+    int count = 0;
+    while (count < max_count && AreItemsTheSame(old_item_position + count, new_item_position + count)) {
+      ++count;
+    }
+    return count;
+  }
+
+  /**
+   * Like CountItemsTheSame, but for the run that ends just before the given
+   * positions and is walked backwards.
+   *
+   * @param old_item_end One past the last position of the run in the old list
+   * @param new_item_end One past the last position of the run in the new list
+   * @param max_count The run length to check at most, within both lists
+   * @return The number of trailing pairs that are the same, at most max_count.
+   */
+  virtual int CountItemsTheSameBackward(int old_item_end, int new_item_end, int max_count) const {
+    int count = 0;
+    while (count < max_count && AreItemsTheSame(old_item_end - count - 1, new_item_end - count - 1)) {
+      ++count;
+    }
+    return count;
+  }
+
   /**
    * When AreItemsTheSame returns true for two items and AreContentsTheSame returns false
    * for them, DiffUtil calls this method to get a payload about the change.
@@ -59,6 +98,20 @@ class DiffCallback {
     return nullptr;
   }
 
+  /**
+   * The typed form of GetChangePayload, which DiffUtil calls. Override it to hand
+   * over a payload by value, e.g. a small trivially copyable struct stored inline.
+   *
+   * Default implementation borrows the pointer returned by GetChangePayload.
+   *
+   * @param old_item_position The position of the item in the old list
+   * @param new_item_position The position of the item in the new list
+   * @return A payload that represents the change, empty when there is none.
+   */
+  virtual Payload GetTypedChangePayload(int old_item_position, int new_item_position) const {
+    return Payload::Borrow(GetChangePayload(old_item_position, new_item_position));
+  }
+
   virtual ~DiffCallback() = default;
 };
 
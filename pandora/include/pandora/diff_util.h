@@ -3,6 +3,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -56,13 +58,34 @@ class DiffUtil {
           new_list_start(nls), new_list_end(nle) {}
   };
 
+  /**
+   * One update of a DiffResult, as produced by DiffResult::UpdateStream.
+   *
+   * Positions are those DispatchUpdatesTo reports: each one accounts for the
+   * updates before it.
+   */
+  struct UpdateOp {
+    enum Type { INSERTED, REMOVED, MOVED, CHANGED };
+
+    Type type = INSERTED;
+    int position = 0;     // First position, or the from position of a move
+    int count = 1;        // Number of items; 1 for moves
+    int to_position = 0;  // MOVED: the position the item moved to
+    // CHANGED: the item in both lists, see DiffResult::GetChangePayload
+    int old_item_position = 0;
+    int new_item_position = 0;
+  };
+
   /**
    * This class holds the information about the result of a CalculateDiff call.
    *
-   * You can consume the updates in a DiffResult via DispatchUpdatesTo.
+   * You can consume the updates in a DiffResult via DispatchUpdatesTo, or pull
+   * them one at a time from GetUpdates.
    */
   class DiffResult {
    public:
+    class UpdateStream;
+
     static constexpr int NO_POSITION = -1;
 
     // Flag constants
@@ -75,7 +98,7 @@ class DiffUtil {
     static constexpr int FLAG_MASK = (1 << FLAG_OFFSET) - 1;
 
     DiffResult(const DiffCallback* callback,
-               const std::vector<Snake>& snakes,
+               std::vector<Snake> snakes,
                std::vector<int> old_item_statuses,
                std::vector<int> new_item_statuses,
                bool detect_moves);
@@ -92,6 +115,56 @@ class DiffUtil {
      */
     int ConvertNewPositionToOld(int new_list_position) const;
 
+    /**
+     * Converts positions in the old list to positions in the new list, in place.
+     *
+     * Unlike ConvertOldPositionToNew this never throws: removed and out of range
+     * positions become NO_POSITION. The loop has no branches or calls, so large
+     * selection sets convert at memory speed.
+     */
+    void ConvertOldPositionsToNew(int* positions, size_t count) const;
+    void ConvertOldPositionsToNew(std::vector<int>& positions) const {
+      ConvertOldPositionsToNew(positions.data(), positions.size());
+    }
+
+    /**
+     * Converts positions in the new list to positions in the old list, in place.
+     * Added and out of range positions become NO_POSITION; never throws.
+     */
+    void ConvertNewPositionsToOld(int* positions, size_t count) const;
+    void ConvertNewPositionsToOld(std::vector<int>& positions) const {
+      ConvertNewPositionsToOld(positions.data(), positions.size());
+    }
+
+    /**
+     * Like ConvertOldPositionToNew, but a removed item maps to the new position of
+     * the nearest item that survived: the first one after it in the old list, else
+     * the last one before it. Meant to keep a scroll anchor in place.
+     *
+     * @return NO_POSITION if old_list_position is out of range or no item survived
+     */
+    int ConvertOldPositionToNearestNew(int old_list_position) const;
+
+    void ConvertOldPositionsToNearestNew(int* positions, size_t count) const;
+
+    /**
+     * The per item statuses, one int per position: the matching position in the
+     * other list shifted by FLAG_OFFSET, or'ed with FLAG_* bits; 0 for removed or
+     * added items. Decode an entry with StatusToPosition.
+     */
+    const std::vector<int>& GetOldItemStatuses() const { return old_item_statuses_; }
+    const std::vector<int>& GetNewItemStatuses() const { return new_item_statuses_; }
+
+    static constexpr int StatusToPosition(int status) {
+      return (status & FLAG_MASK) == 0 ? NO_POSITION : status >> FLAG_OFFSET;
+    }
+
+    /**
+     * Returns the number of removed plus inserted items, the D of Myers' algorithm.
+     * Moves count as a removal and an insertion.
+     */
+    int GetEditDistance() const;
+
     /**
      * Dispatches update operations to the given Callback.
      * These updates are atomic such that the first update call affects every update call that
@@ -99,8 +172,27 @@ class DiffUtil {
      */
     void DispatchUpdatesTo(ListUpdateCallback* update_callback);
 
+    /**
+     * Returns a stream producing the updates of DispatchUpdatesTo lazily, in the
+     * same order and without virtual calls. Consume part of them and resume later,
+     * e.g. to spread a huge diff over several frames. This result must outlive the
+     * stream.
+     */
+    UpdateStream GetUpdates() const;
+
+    /**
+     * The payload of a CHANGED update, from the DiffCallback's GetTypedChangePayload.
+     */
+    Payload GetChangePayload(const UpdateOp& op) const {
+      return callback_->GetTypedChangePayload(op.old_item_position, op.new_item_position);
+    }
+
     const std::vector<Snake>& GetSnakes() const { return snakes_; }
 
+    int GetOldListSize() const { return old_list_size_; }
+
+    int GetNewListSize() const { return new_list_size_; }
+
    private:
     struct PostponedUpdate {
       int pos_in_owner_list;
@@ -117,15 +209,34 @@ class DiffUtil {
     void FindRemoval(int x, int y, int snake_index);
     bool FindMatchingItem(int x, int y, int snake_index, bool removal);
 
-    void DispatchAdditions(std::vector<PostponedUpdate>& postponed_updates,
-                          ListUpdateCallback* update_callback,
-                          int start, int count, int global_index);
+    static UpdateOp MakeUpdate(UpdateOp::Type type, int position, int count) {
+      UpdateOp op;
+      op.type = type;
+      op.position = position;
+      op.count = count;
+      return op;
+    }
+
+    static UpdateOp MakeChange(int position, int old_item_position, int new_item_position) {
+      UpdateOp op = MakeUpdate(UpdateOp::CHANGED, position, 1);
+      op.old_item_position = old_item_position;
+      op.new_item_position = new_item_position;
+      return op;
+    }
 
-    void DispatchRemovals(std::vector<PostponedUpdate>& postponed_updates,
-                         ListUpdateCallback* update_callback,
-                         int start, int count, int global_index);
+    // Reports the updates of removing old item global_index + i, or of adding new
+    // item global_index + i, to sink: none when the item is postponed, a move and a
+    // change for a moved and changed item. Shared by DispatchUpdatesTo and
+    // UpdateStream, whose sinks have Removed, Inserted, Moved and Changed members.
+    template <typename Sink>
+    void VisitRemoval(std::vector<PostponedUpdate>& postponed_updates,
+                      int start, int i, int global_index, Sink& sink) const;
 
-    static PostponedUpdate* RemovePostponedUpdate(
+    template <typename Sink>
+    void VisitAddition(std::vector<PostponedUpdate>& postponed_updates,
+                       int start, int i, int global_index, Sink& sink) const;
+
+    static PostponedUpdate RemovePostponedUpdate(
         std::vector<PostponedUpdate>& updates, int pos, bool removal);
 
     std::vector<Snake> snakes_;
@@ -160,18 +271,130 @@ class DiffUtil {
  private:
   DiffUtil() = default;  // Utility class, no instances
 
-  static Snake* DiffPartial(const DiffCallback* cb,
-                           int start_old, int end_old,
-                           int start_new, int end_new,
-                           std::vector<int>& forward,
-                           std::vector<int>& backward,
-                           int k_offset);
+  // Finds the middle snake of a range into out_snake; false if the range is empty
+  static bool DiffPartial(const DiffCallback* cb,
+                          int start_old, int end_old,
+                          int start_new, int end_new,
+                          std::vector<int>& forward,
+                          std::vector<int>& backward,
+                          int k_offset,
+                          Snake& out_snake);
 };
 
 // ============================================================================
 // Implementation
 // ============================================================================
 
+/**
+ * Pulls the updates of a DiffResult one at a time, see DiffResult::GetUpdates.
+ *
+ * Next walks the snakes from the end, as DispatchUpdatesTo does, keeping its
+ * place between calls. begin() and end() make the stream a single pass range:
+ * breaking out of a range-for and iterating again resumes after the last
+ * update seen.
+ */
+class DiffUtil::DiffResult::UpdateStream {
+ public:
+  explicit UpdateStream(const DiffResult* result)
+      : result_(result),
+        snake_index_(static_cast<int>(result->snakes_.size()) - 1),
+        pos_old_(result->old_list_size_),
+        pos_new_(result->new_list_size_) {}
+
+  /**
+   * Produces the next update into op.
+   *
+   * @return false once every update has been produced
+   */
+  bool Next(UpdateOp& op);
+
+  /**
+   * Produces up to capacity updates into ops, fewer only at the end.
+   *
+   * @return The number of updates produced, 0 once every update has been produced
+   */
+  size_t Next(UpdateOp* ops, size_t capacity) {
+    size_t count = 0;
+    while (count < capacity && Next(ops[count])) count++;
+    return count;
+  }
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = UpdateOp;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const UpdateOp*;
+    using reference = const UpdateOp&;
+
+    Iterator() = default;
+    explicit Iterator(UpdateStream* stream) : stream_(stream) { ++*this; }
+
+    reference operator*() const { return op_; }
+    pointer operator->() const { return &op_; }
+
+    Iterator& operator++() {
+      if (!stream_->Next(op_)) stream_ = nullptr;
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const { return stream_ == other.stream_; }
+    bool operator!=(const Iterator& other) const { return stream_ != other.stream_; }
+
+   private:
+    UpdateStream* stream_ = nullptr;
+    UpdateOp op_;
+  };
+
+  Iterator begin() { return Done() ? end() : Iterator(this); }
+  Iterator end() { return Iterator(); }
+
+  bool Done() const { return phase_ == Phase::DONE && !has_pending_; }
+
+ private:
+  enum class Phase { SNAKE, REMOVALS, ADDITIONS, CHANGES, DONE };
+
+  // Takes the updates of one item: the first into op, a second one into pending_
+  struct Collector {
+    UpdateStream* stream;
+    UpdateOp* op;
+    bool produced = false;
+
+    void Removed(int position) { Take(MakeUpdate(UpdateOp::REMOVED, position, 1)); }
+    void Inserted(int position) { Take(MakeUpdate(UpdateOp::INSERTED, position, 1)); }
+    void Moved(int from_position, int to_position) {
+      UpdateOp update = MakeUpdate(UpdateOp::MOVED, from_position, 1);
+      update.to_position = to_position;
+      Take(update);
+    }
+    void Changed(int position, int old_item_position, int new_item_position) {
+      Take(MakeChange(position, old_item_position, new_item_position));
+    }
+
+    void Take(const UpdateOp& update) {
+      if (produced) {
+        stream->pending_ = update;
+        stream->has_pending_ = true;
+      } else {
+        *op = update;
+        produced = true;
+      }
+    }
+  };
+
+  const DiffResult* result_;
+  std::vector<PostponedUpdate> postponed_updates_;
+  Phase phase_ = Phase::SNAKE;
+  int snake_index_;
+  int pos_old_;
+  int pos_new_;
+  int end_x_ = 0;     // End of the current snake in the old list
+  int end_y_ = 0;     // End of the current snake in the new list
+  int remaining_ = 0; // Items of the current phase still to visit, from the last one
+  bool has_pending_ = false;
+  UpdateOp pending_;  // The change following a moved and changed item
+};
+
 inline std::unique_ptr<DiffUtil::DiffResult> DiffUtil::CalculateDiff(
     const DiffCallback* cb, bool detect_moves) {
   const int old_size = cb->GetOldListSize();
@@ -186,61 +409,56 @@ inline std::unique_ptr<DiffUtil::DiffResult> DiffUtil::CalculateDiff(
   std::vector<int> forward(max * 2, 0);
   std::vector<int> backward(max * 2, 0);
 
-  std::vector<Range> range_pool;
-
   while (!stack.empty()) {
     Range range = stack.back();
     stack.pop_back();
 
-    Snake* snake = DiffPartial(cb, range.old_list_start, range.old_list_end,
-                               range.new_list_start, range.new_list_end,
-                               forward, backward, max);
+    Snake snake;
+    if (DiffPartial(cb, range.old_list_start, range.old_list_end,
+                    range.new_list_start, range.new_list_end,
+                    forward, backward, max, snake)) {
+      // Offset the snake to convert its coordinates from the Range's area to global
+      snake.x += range.old_list_start;
+      snake.y += range.new_list_start;
 
-    if (snake != nullptr) {
-      if (snake->size > 0) {
-        snakes.push_back(*snake);
+      if (snake.size > 0) {
+        snakes.push_back(snake);
       }
 
-      // Offset the snake to convert its coordinates from the Range's area to global
-      snake->x += range.old_list_start;
-      snake->y += range.new_list_start;
-
       // Add new ranges for left and right
       Range left;
       left.old_list_start = range.old_list_start;
       left.new_list_start = range.new_list_start;
 
-      if (snake->reverse) {
-        left.old_list_end = snake->x;
-        left.new_list_end = snake->y;
+      if (snake.reverse) {
+        left.old_list_end = snake.x;
+        left.new_list_end = snake.y;
       } else {
-        if (snake->removal) {
-          left.old_list_end = snake->x - 1;
-          left.new_list_end = snake->y;
+        if (snake.removal) {
+          left.old_list_end = snake.x - 1;
+          left.new_list_end = snake.y;
         } else {
-          left.old_list_end = snake->x;
-          left.new_list_end = snake->y - 1;
+          left.old_list_end = snake.x;
+          left.new_list_end = snake.y - 1;
         }
       }
       stack.push_back(left);
 
       // Re-use range for right
       Range& right = range;
-      if (snake->reverse) {
-        if (snake->removal) {
-          right.old_list_start = snake->x + snake->size + 1;
-          right.new_list_start = snake->y + snake->size;
+      if (snake.reverse) {
+        if (snake.removal) {
+          right.old_list_start = snake.x + snake.size + 1;
+          right.new_list_start = snake.y + snake.size;
         } else {
-          right.old_list_start = snake->x + snake->size;
-          right.new_list_start = snake->y + snake->size + 1;
+          right.old_list_start = snake.x + snake.size;
+          right.new_list_start = snake.y + snake.size + 1;
         }
       } else {
-        right.old_list_start = snake->x + snake->size;
-        right.new_list_start = snake->y + snake->size;
+        right.old_list_start = snake.x + snake.size;
+        right.new_list_start = snake.y + snake.size;
       }
       stack.push_back(right);
-
-      delete snake;
     }
   }
 
@@ -253,20 +471,20 @@ inline std::unique_ptr<DiffUtil::DiffResult> DiffUtil::CalculateDiff(
   std::vector<int> old_item_statuses(old_size, 0);
   std::vector<int> new_item_statuses(new_size, 0);
 
-  return std::make_unique<DiffResult>(cb, snakes, std::move(old_item_statuses),
+  return std::make_unique<DiffResult>(cb, std::move(snakes), std::move(old_item_statuses),
                                       std::move(new_item_statuses), detect_moves);
 }
 
-inline DiffUtil::Snake* DiffUtil::DiffPartial(
+inline bool DiffUtil::DiffPartial(
     const DiffCallback* cb, int start_old, int end_old,
     int start_new, int end_new, std::vector<int>& forward,
-    std::vector<int>& backward, int k_offset) {
+    std::vector<int>& backward, int k_offset, Snake& out_snake) {
 
   const int old_size = end_old - start_old;
   const int new_size = end_new - start_new;
 
   if (end_old - start_old < 1 || end_new - start_new < 1) {
-    return nullptr;
+    return false;
   }
 
   const int delta = old_size - new_size;
@@ -296,23 +514,23 @@ inline DiffUtil::Snake* DiffUtil::DiffPartial(
       int y = x - k;
 
       // Move diagonal as long as items match
-      while (x < old_size && y < new_size &&
-             cb->AreItemsTheSame(start_old + x, start_new + y)) {
-        x++;
-        y++;
+      if (x < old_size && y < new_size) {
+        const int run = cb->CountItemsTheSame(start_old + x, start_new + y,
+                                              std::min(old_size - x, new_size - y));
+        x += run;
+        y += run;
       }
 
       forward[k_offset + k] = x;
 
       if (check_in_fwd && k >= delta - d + 1 && k <= delta + d - 1) {
         if (forward[k_offset + k] >= backward[k_offset + k]) {
-          Snake* out_snake = new Snake();
-          out_snake->x = backward[k_offset + k];
-          out_snake->y = out_snake->x - k;
-          out_snake->size = forward[k_offset + k] - backward[k_offset + k];
-          out_snake->removal = removal;
-          out_snake->reverse = false;
-          return out_snake;
+          out_snake.x = backward[k_offset + k];
+          out_snake.y = out_snake.x - k;
+          out_snake.size = forward[k_offset + k] - backward[k_offset + k];
+          out_snake.removal = removal;
+          out_snake.reverse = false;
+          return true;
         }
       }
     }
@@ -336,23 +554,22 @@ inline DiffUtil::Snake* DiffUtil::DiffPartial(
       int y = x - backward_k;
 
       // Move diagonal as long as items match
-      while (x > 0 && y > 0 &&
-             cb->AreItemsTheSame(start_old + x - 1, start_new + y - 1)) {
-        x--;
-        y--;
+      if (x > 0 && y > 0) {
+        const int run = cb->CountItemsTheSameBackward(start_old + x, start_new + y, std::min(x, y));
+        x -= run;
+        y -= run;
       }
 
       backward[k_offset + backward_k] = x;
 
       if (!check_in_fwd && k + delta >= -d && k + delta <= d) {
         if (forward[k_offset + backward_k] >= backward[k_offset + backward_k]) {
-          Snake* out_snake = new Snake();
-          out_snake->x = backward[k_offset + backward_k];
-          out_snake->y = out_snake->x - backward_k;
-          out_snake->size = forward[k_offset + backward_k] - backward[k_offset + backward_k];
-          out_snake->removal = removal;
-          out_snake->reverse = true;
-          return out_snake;
+          out_snake.x = backward[k_offset + backward_k];
+          out_snake.y = out_snake.x - backward_k;
+          out_snake.size = forward[k_offset + backward_k] - backward[k_offset + backward_k];
+          out_snake.removal = removal;
+          out_snake.reverse = true;
+          return true;
         }
       }
     }
@@ -367,11 +584,11 @@ inline DiffUtil::Snake* DiffUtil::DiffPartial(
 // DiffResult implementation
 inline DiffUtil::DiffResult::DiffResult(
     const DiffCallback* callback,
-    const std::vector<Snake>& snakes,
+    std::vector<Snake> snakes,
     std::vector<int> old_item_statuses,
     std::vector<int> new_item_statuses,
     bool detect_moves)
-    : snakes_(snakes),
+    : snakes_(std::move(snakes)),
       old_item_statuses_(std::move(old_item_statuses)),
       new_item_statuses_(std::move(new_item_statuses)),
       callback_(callback),
@@ -496,6 +713,14 @@ inline int DiffUtil::DiffResult::ConvertOldPositionToNew(int old_list_position)
   return status >> FLAG_OFFSET;
 }
 
+inline int DiffUtil::DiffResult::GetEditDistance() const {
+  int matched = 0;
+  for (const Snake& snake : snakes_) {
+    matched += snake.size;
+  }
+  return old_list_size_ + new_list_size_ - 2 * matched;
+}
+
 inline int DiffUtil::DiffResult::ConvertNewPositionToOld(int new_list_position) const {
   if (new_list_position < 0 || new_list_position >= new_list_size_) {
     throw std::out_of_range("Index out of bounds - passed position = " +
@@ -509,139 +734,282 @@ inline int DiffUtil::DiffResult::ConvertNewPositionToOld(int new_list_position)
   return status >> FLAG_OFFSET;
 }
 
-inline DiffUtil::DiffResult::PostponedUpdate* DiffUtil::DiffResult::RemovePostponedUpdate(
+namespace detail {
+
+// Out of range positions read a zero status, so the loop stays branch free
+inline void ConvertPositions(const std::vector<int>& statuses, int* positions, size_t count) {
+  const int* status_data = statuses.data();
+  const auto size = static_cast<unsigned>(statuses.size());
+  for (size_t i = 0; i < count; i++) {
+    const auto position = static_cast<unsigned>(positions[i]);
+    const bool in_range = position < size;
+    const int status = status_data[in_range ? position : 0] & -static_cast<int>(in_range);
+    positions[i] = DiffUtil::DiffResult::StatusToPosition(status);
+  }
+}
+
+}  // namespace detail
+
+inline void DiffUtil::DiffResult::ConvertOldPositionsToNew(int* positions, size_t count) const {
+  if (old_item_statuses_.empty()) {
+    std::fill(positions, positions + count, NO_POSITION);
+    return;
+  }
+  detail::ConvertPositions(old_item_statuses_, positions, count);
+}
+
+inline void DiffUtil::DiffResult::ConvertNewPositionsToOld(int* positions, size_t count) const {
+  if (new_item_statuses_.empty()) {
+    std::fill(positions, positions + count, NO_POSITION);
+    return;
+  }
+  detail::ConvertPositions(new_item_statuses_, positions, count);
+}
+
+inline int DiffUtil::DiffResult::ConvertOldPositionToNearestNew(int old_list_position) const {
+  if (old_list_position < 0 || old_list_position >= old_list_size_) {
+    return NO_POSITION;
+  }
+  for (int pos = old_list_position; pos < old_list_size_; pos++) {
+    const int new_position = StatusToPosition(old_item_statuses_[pos]);
+    if (new_position != NO_POSITION) return new_position;
+  }
+  for (int pos = old_list_position - 1; pos >= 0; pos--) {
+    const int new_position = StatusToPosition(old_item_statuses_[pos]);
+    if (new_position != NO_POSITION) return new_position;
+  }
+  return NO_POSITION;
+}
+
+inline void DiffUtil::DiffResult::ConvertOldPositionsToNearestNew(int* positions, size_t count) const {
+  for (size_t i = 0; i < count; i++) {
+    positions[i] = ConvertOldPositionToNearestNew(positions[i]);
+  }
+}
+
+inline DiffUtil::DiffResult::PostponedUpdate DiffUtil::DiffResult::RemovePostponedUpdate(
     std::vector<PostponedUpdate>& updates, int pos, bool removal) {
   for (int i = static_cast<int>(updates.size()) - 1; i >= 0; i--) {
-    PostponedUpdate& update = updates[i];
+    const PostponedUpdate update = updates[i];
     if (update.pos_in_owner_list == pos && update.removal == removal) {
-      PostponedUpdate* result = new PostponedUpdate(update);
       updates.erase(updates.begin() + i);
       for (size_t j = i; j < updates.size(); j++) {
         updates[j].current_pos += removal ? 1 : -1;
       }
-      return result;
+      return update;
     }
   }
-  return nullptr;
+  throw std::runtime_error("no postponed update for pos " + std::to_string(pos));
 }
 
-inline void DiffUtil::DiffResult::DispatchAdditions(
-    std::vector<PostponedUpdate>& postponed_updates,
-    ListUpdateCallback* update_callback,
-    int start, int count, int global_index) {
+inline DiffUtil::DiffResult::UpdateStream DiffUtil::DiffResult::GetUpdates() const {
+  return UpdateStream(this);
+}
 
-  if (!detect_moves_) {
-    update_callback->OnInserted(start, count);
-    return;
+inline bool DiffUtil::DiffResult::UpdateStream::Next(UpdateOp& op) {
+  if (has_pending_) {
+    op = pending_;
+    has_pending_ = false;
+    return true;
   }
 
-  for (int i = count - 1; i >= 0; i--) {
-    int status = new_item_statuses_[global_index + i] & FLAG_MASK;
-    switch (status) {
-      case 0:  // Real addition
-        update_callback->OnInserted(start, 1);
-        for (auto& update : postponed_updates) {
-          update.current_pos += 1;
+  for (;;) {
+    switch (phase_) {
+      case Phase::SNAKE: {
+        if (snake_index_ < 0) {
+          phase_ = Phase::DONE;
+          return false;
+        }
+        const Snake& snake = result_->snakes_[snake_index_];
+        end_x_ = snake.x + snake.size;
+        end_y_ = snake.y + snake.size;
+        phase_ = Phase::REMOVALS;
+        remaining_ = pos_old_ - end_x_;
+        if (remaining_ > 0 && !result_->detect_moves_) {
+          op = MakeUpdate(UpdateOp::REMOVED, end_x_, remaining_);
+          remaining_ = 0;
+          return true;
         }
         break;
+      }
 
-      case FLAG_MOVED_CHANGED:
-      case FLAG_MOVED_NOT_CHANGED: {
-        const int pos = new_item_statuses_[global_index + i] >> FLAG_OFFSET;
-        PostponedUpdate* update = RemovePostponedUpdate(postponed_updates, pos, true);
-        update_callback->OnMoved(update->current_pos, start);
-        if (status == FLAG_MOVED_CHANGED) {
-          update_callback->OnChanged(start, 1,
-              callback_->GetChangePayload(pos, global_index + i));
+      case Phase::REMOVALS:
+        while (remaining_ > 0) {
+          Collector collect{this, &op};
+          remaining_--;
+          result_->VisitRemoval(postponed_updates_, end_x_, remaining_, end_x_, collect);
+          if (collect.produced) return true;
+        }
+        phase_ = Phase::ADDITIONS;
+        remaining_ = pos_new_ - end_y_;
+        if (remaining_ > 0 && !result_->detect_moves_) {
+          op = MakeUpdate(UpdateOp::INSERTED, end_x_, remaining_);
+          remaining_ = 0;
+          return true;
         }
-        delete update;
         break;
-      }
 
-      case FLAG_IGNORE:
-        postponed_updates.emplace_back(global_index + i, start, false);
+      case Phase::ADDITIONS:
+        while (remaining_ > 0) {
+          Collector collect{this, &op};
+          remaining_--;
+          result_->VisitAddition(postponed_updates_, end_x_, remaining_, end_y_, collect);
+          if (collect.produced) return true;
+        }
+        phase_ = Phase::CHANGES;
+        remaining_ = result_->snakes_[snake_index_].size;
+        break;
+
+      case Phase::CHANGES: {
+        const Snake& snake = result_->snakes_[snake_index_];
+        // A local count, as the statuses are ints too and would alias remaining_
+        const int* statuses = result_->old_item_statuses_.data() + snake.x;
+        for (int i = remaining_ - 1; i >= 0; i--) {
+          if ((statuses[i] & FLAG_MASK) == FLAG_CHANGED) {
+            remaining_ = i;
+            op = MakeChange(snake.x + i, snake.x + i, snake.y + i);
+            return true;
+          }
+        }
+        remaining_ = 0;
+        pos_old_ = snake.x;
+        pos_new_ = snake.y;
+        snake_index_--;
+        phase_ = Phase::SNAKE;
         break;
+      }
 
-      default:
-        throw std::runtime_error("unknown flag for pos " +
-            std::to_string(global_index + i));
+      case Phase::DONE:
+        return false;
     }
   }
 }
 
-inline void DiffUtil::DiffResult::DispatchRemovals(
+template <typename Sink>
+inline void DiffUtil::DiffResult::VisitRemoval(
     std::vector<PostponedUpdate>& postponed_updates,
-    ListUpdateCallback* update_callback,
-    int start, int count, int global_index) {
+    int start, int i, int global_index, Sink& sink) const {
+  const int status = old_item_statuses_[global_index + i] & FLAG_MASK;
+  switch (status) {
+    case 0:  // Real removal
+      sink.Removed(start + i);
+      for (auto& update : postponed_updates) {
+        update.current_pos -= 1;
+      }
+      break;
+
+    case FLAG_MOVED_CHANGED:
+    case FLAG_MOVED_NOT_CHANGED: {
+      const int pos = old_item_statuses_[global_index + i] >> FLAG_OFFSET;
+      const PostponedUpdate update = RemovePostponedUpdate(postponed_updates, pos, false);
+      sink.Moved(start + i, update.current_pos - 1);
+      if (status == FLAG_MOVED_CHANGED) {
+        sink.Changed(update.current_pos - 1, global_index + i, pos);
+      }
+      break;
+    }
 
-  if (!detect_moves_) {
-    update_callback->OnRemoved(start, count);
-    return;
-  }
+    case FLAG_IGNORE:
+      postponed_updates.emplace_back(global_index + i, start + i, true);
+      break;
 
-  for (int i = count - 1; i >= 0; i--) {
-    const int status = old_item_statuses_[global_index + i] & FLAG_MASK;
-    switch (status) {
-      case 0:  // Real removal
-        update_callback->OnRemoved(start + i, 1);
-        for (auto& update : postponed_updates) {
-          update.current_pos -= 1;
-        }
-        break;
+    default:
+      throw std::runtime_error("unknown flag for pos " +
+          std::to_string(global_index + i));
+  }
+}
 
-      case FLAG_MOVED_CHANGED:
-      case FLAG_MOVED_NOT_CHANGED: {
-        const int pos = old_item_statuses_[global_index + i] >> FLAG_OFFSET;
-        PostponedUpdate* update = RemovePostponedUpdate(postponed_updates, pos, false);
-        update_callback->OnMoved(start + i, update->current_pos - 1);
-        if (status == FLAG_MOVED_CHANGED) {
-          update_callback->OnChanged(update->current_pos - 1, 1,
-              callback_->GetChangePayload(global_index + i, pos));
-        }
-        delete update;
-        break;
+template <typename Sink>
+inline void DiffUtil::DiffResult::VisitAddition(
+    std::vector<PostponedUpdate>& postponed_updates,
+    int start, int i, int global_index, Sink& sink) const {
+  const int status = new_item_statuses_[global_index + i] & FLAG_MASK;
+  switch (status) {
+    case 0:  // Real addition
+      sink.Inserted(start);
+      for (auto& update : postponed_updates) {
+        update.current_pos += 1;
+      }
+      break;
+
+    case FLAG_MOVED_CHANGED:
+    case FLAG_MOVED_NOT_CHANGED: {
+      const int pos = new_item_statuses_[global_index + i] >> FLAG_OFFSET;
+      const PostponedUpdate update = RemovePostponedUpdate(postponed_updates, pos, true);
+      sink.Moved(update.current_pos, start);
+      if (status == FLAG_MOVED_CHANGED) {
+        sink.Changed(start, pos, global_index + i);
       }
+      break;
+    }
 
-      case FLAG_IGNORE:
-        postponed_updates.emplace_back(global_index + i, start + i, true);
-        break;
+    case FLAG_IGNORE:
+      postponed_updates.emplace_back(global_index + i, start, false);
+      break;
 
-      default:
-        throw std::runtime_error("unknown flag for pos " +
-            std::to_string(global_index + i));
-    }
+    default:
+      throw std::runtime_error("unknown flag for pos " +
+          std::to_string(global_index + i));
   }
 }
 
+// The walk of UpdateStream::Next without its resumable state
 inline void DiffUtil::DiffResult::DispatchUpdatesTo(ListUpdateCallback* update_callback) {
+  struct CallbackSink {
+    const DiffResult* result;
+    ListUpdateCallback* callback;
+
+    void Removed(int position) { callback->OnRemoved(position, 1); }
+    void Inserted(int position) { callback->OnInserted(position, 1); }
+    void Moved(int from_position, int to_position) { callback->OnMoved(from_position, to_position); }
+    void Changed(int position, int old_item_position, int new_item_position) {
+      callback->OnChangedWithPayload(position, 1,
+          result->callback_->GetTypedChangePayload(old_item_position, new_item_position));
+    }
+  };
+
   std::vector<PostponedUpdate> postponed_updates;
+  CallbackSink sink{this, update_callback};
   int pos_old = old_list_size_;
   int pos_new = new_list_size_;
 
   for (int snake_index = static_cast<int>(snakes_.size()) - 1; snake_index >= 0; snake_index--) {
     const Snake& snake = snakes_[snake_index];
-    const int snake_size = snake.size;
-    const int end_x = snake.x + snake_size;
-    const int end_y = snake.y + snake_size;
+    const int end_x = snake.x + snake.size;
+    const int end_y = snake.y + snake.size;
 
     if (end_x < pos_old) {
-      DispatchRemovals(postponed_updates, update_callback, end_x, pos_old - end_x, end_x);
+      if (!detect_moves_) {
+        update_callback->OnRemoved(end_x, pos_old - end_x);
+      } else {
+        for (int i = pos_old - end_x - 1; i >= 0; i--) {
+          VisitRemoval(postponed_updates, end_x, i, end_x, sink);
+        }
+      }
     }
 
     if (end_y < pos_new) {
-      DispatchAdditions(postponed_updates, update_callback, end_x, pos_new - end_y, end_y);
+      if (!detect_moves_) {
+        update_callback->OnInserted(end_x, pos_new - end_y);
+      } else {
+        for (int i = pos_new - end_y - 1; i >= 0; i--) {
+          VisitAddition(postponed_updates, end_x, i, end_y, sink);
+        }
+      }
     }
 
-    for (int i = snake_size - 1; i >= 0; i--) {
+    for (int i = snake.size - 1; i >= 0; i--) {
       if ((old_item_statuses_[snake.x + i] & FLAG_MASK) == FLAG_CHANGED) {
-        update_callback->OnChanged(snake.x + i, 1,
-            callback_->GetChangePayload(snake.x + i, snake.y + i));
+        update_callback->OnChangedWithPayload(snake.x + i, 1,
+            callback_->GetTypedChangePayload(snake.x + i, snake.y + i));
       }
     }
 
     pos_old = snake.x;
     pos_new = snake.y;
   }
+
+  update_callback->OnUpdatesDispatched();
 }
 
 }  // namespace pandora
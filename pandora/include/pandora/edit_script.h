@@ -0,0 +1,485 @@
+#ifndef PANDORA_EDIT_SCRIPT_H_
+#define PANDORA_EDIT_SCRIPT_H_
+
+#include "binary_io.h"
+#include "diff_util.h"
+#include "field_hashers.h"
+#include "list_update_callback.h"
+#include "pandora_exception.h"
+#include "payload.h"
+#include "real_data_set.h"
+#include "tree_serializer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pandora
+{
+    constexpr uint32_t kEditScriptMagic = 0x53444550;  // "PEDS"
+    constexpr uint64_t kEditScriptVersion = 1;
+
+    namespace detail
+    {
+        enum class EditOp : uint8_t
+        {
+            END = 0,
+            INSERTED,
+            REMOVED,
+            MOVED,
+            CHANGED,
+            DISPATCHED,
+        };
+
+        enum : uint8_t
+        {
+            kNoPayload = 0,
+            kFieldMaskPayload = 1,
+        };
+
+        template <typename T>
+        void WriteScriptItem(BinaryWriter& writer, const T& item)
+        {
+            if constexpr (IsRawSerializable<T>::value) writer.WriteBytes(&item, sizeof(T));
+            else Serializer<T>::Write(writer, item);
+        }
+
+        template <typename T>
+        T ReadScriptItem(BinaryReader& reader)
+        {
+            if constexpr (IsRawSerializable<T>::value)
+            {
+                T item;
+                std::memcpy(&item, reader.ReadBytes(sizeof(T)), sizeof(T));
+                return item;
+            }
+            else
+            {
+                return Serializer<T>::Read(reader);
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Encodes list updates into a compact edit script, e.g. to mirror a list in another process
+     *
+     * The encoder is a ListUpdateCallback: dispatch a DiffResult to it, see
+     * Encode, or set it as the list update callback of a data set to journal
+     * that data set's mutations as they are notified. Finish then appends the
+     * items the receiver does not have, the inserted and changed ones, taken
+     * from the list as it is after the updates. The script size and the
+     * encoding time scale with the number of updates, not with the list.
+     *
+     * Script format, varints in LEB128:
+     * @code
+     *   script := fixed32 magic, varint version, u8 item_encoding, varint item_size,
+     *             varint old_size, op *, u8 END, varint new_size,
+     *             varint item_count, (varint position_delta, item) * item_count
+     *   op     := u8 INSERTED, varint position, varint count
+     *           | u8 REMOVED, varint position, varint count
+     *           | u8 MOVED, varint from, varint to
+     *           | u8 CHANGED, varint position, varint count, u8 payload_kind, [varint field_mask]
+     *           | u8 DISPATCHED
+     * @endcode
+     *
+     * Items are encoded as in TreeSerializer. A FieldChangeMask payload is
+     * carried by value; any other payload is process local and is dropped.
+     *
+     * @tparam T The data type, with a Serializer<T> or raw serializable
+     */
+    template <typename T>
+    class EditScriptEncoder : public ListUpdateCallback
+    {
+    public:
+        static_assert(HasSerializer<T>::value || IsRawSerializable<T>::value,
+                      "EditScriptEncoder needs a pandora::Serializer<T> specialization for this item type");
+
+        /**
+         * @param old_size Size of the list before the first update
+         */
+        explicit EditScriptEncoder(int old_size) { Reset(old_size); }
+
+        /// Drops the encoded updates and starts a new script from a list of old_size items
+        void Reset(int old_size)
+        {
+            script_.clear();
+            fresh_.clear();
+            size_ = old_size;
+            BinaryWriter writer(script_);
+            writer.WriteFixed32(kEditScriptMagic);
+            writer.WriteVarint(kEditScriptVersion);
+            writer.WriteU8(IsRawSerializable<T>::value ? 1 : 0);
+            writer.WriteVarint(IsRawSerializable<T>::value ? sizeof(T) : 0);
+            writer.WriteVarint(static_cast<uint64_t>(old_size));
+        }
+
+        void OnInserted(int position, int count) override
+        {
+            Write(detail::EditOp::INSERTED, position, count);
+            ShiftFresh(position, count);
+            for (int i = 0; i < count; ++i) MarkFresh(position + i);
+            size_ += count;
+        }
+
+        void OnRemoved(int position, int count) override
+        {
+            Write(detail::EditOp::REMOVED, position, count);
+            fresh_.erase(std::lower_bound(fresh_.begin(), fresh_.end(), position),
+                         std::lower_bound(fresh_.begin(), fresh_.end(), position + count));
+            ShiftFresh(position + count, -count);
+            size_ -= count;
+        }
+
+        void OnMoved(int from_position, int to_position) override
+        {
+            Write(detail::EditOp::MOVED, from_position, to_position);
+            const auto it = std::lower_bound(fresh_.begin(), fresh_.end(), from_position);
+            const bool fresh = it != fresh_.end() && *it == from_position;
+            if (fresh) fresh_.erase(it);
+            ShiftFresh(from_position + 1, -1);
+            ShiftFresh(to_position, 1);
+            if (fresh) MarkFresh(to_position);
+        }
+
+        void OnChanged(int position, int count, void* payload) override
+        {
+            OnChangedWithPayload(position, count, Payload::Borrow(payload));
+        }
+
+        void OnChangedWithPayload(int position, int count, const Payload& payload) override
+        {
+            Write(detail::EditOp::CHANGED, position, count);
+            BinaryWriter writer(script_);
+            if (const auto* mask = payload.Get<FieldChangeMask>())
+            {
+                writer.WriteU8(detail::kFieldMaskPayload);
+                writer.WriteVarint(mask->bits);
+            }
+            else
+            {
+                writer.WriteU8(detail::kNoPayload);
+            }
+            for (int i = 0; i < count; ++i) MarkFresh(position + i);
+        }
+
+        void OnUpdatesDispatched() override { script_.push_back(static_cast<uint8_t>(detail::EditOp::DISPATCHED)); }
+
+        /**
+         * @brief Completes the script with the inserted and changed items
+         *
+         * Call it once, after the last update.
+         *
+         * @param item_at Returns the item at a position of the list after the updates
+         * @return The script; valid until the next Reset
+         */
+        template <typename ItemAt, std::enable_if_t<std::is_invocable_v<ItemAt&, int>, int> = 0>
+        const std::vector<uint8_t>& Finish(ItemAt&& item_at)
+        {
+            BinaryWriter writer(script_);
+            writer.WriteU8(static_cast<uint8_t>(detail::EditOp::END));
+            writer.WriteVarint(static_cast<uint64_t>(size_));
+            writer.WriteVarint(fresh_.size());
+            int last = 0;
+            for (int position : fresh_)
+            {
+                writer.WriteVarint(static_cast<uint64_t>(position - last));
+                detail::WriteScriptItem(writer, static_cast<const T&>(item_at(position)));
+                last = position;
+            }
+            return script_;
+        }
+
+        const std::vector<uint8_t>& Finish(const std::vector<T>& items)
+        {
+            return Finish([&items](int position) -> const T& { return items[position]; });
+        }
+
+        const std::vector<uint8_t>& Finish(PandoraBoxAdapter<T>& node)
+        {
+            return Finish([&node](int position) -> const T& { return *node.GetDataByIndex(position); });
+        }
+
+        /// Number of items the list has after the updates so far
+        [[nodiscard]] int GetSize() const { return size_; }
+
+        /**
+         * @brief The edit script turning the old list of result into new_items
+         */
+        static std::vector<uint8_t> Encode(DiffUtil::DiffResult& result, const std::vector<T>& new_items)
+        {
+            EditScriptEncoder encoder(result.GetOldListSize());
+            result.DispatchUpdatesTo(&encoder);
+            encoder.Finish(new_items);
+            return std::move(encoder.script_);
+        }
+
+    private:
+        void Write(detail::EditOp op, int first, int second)
+        {
+            BinaryWriter writer(script_);
+            writer.WriteU8(static_cast<uint8_t>(op));
+            writer.WriteVarint(static_cast<uint64_t>(first));
+            writer.WriteVarint(static_cast<uint64_t>(second));
+        }
+
+        void ShiftFresh(int from_position, int delta)
+        {
+            for (auto it = std::lower_bound(fresh_.begin(), fresh_.end(), from_position); it != fresh_.end(); ++it)
+            {
+                *it += delta;
+            }
+        }
+
+        void MarkFresh(int position)
+        {
+            const auto it = std::lower_bound(fresh_.begin(), fresh_.end(), position);
+            if (it == fresh_.end() || *it != position) fresh_.insert(it, position);
+        }
+
+        std::vector<uint8_t> script_;
+        std::vector<int> fresh_;  // Sorted positions whose item the receiver needs
+        int size_ = 0;
+    };
+
+    /**
+     * @brief Applies an edit script of EditScriptEncoder and notifies the updates it holds
+     *
+     * The script is validated and the new items are assembled before anything
+     * is modified, so a malformed script leaves the target as it was. The
+     * target's callback then receives the encoded updates, in order, instead
+     * of the updates of a diff.
+     *
+     * @tparam T The data type, with a Serializer<T> or raw serializable
+     */
+    template <typename T>
+    class EditScriptDecoder
+    {
+    public:
+        /**
+         * @brief Applies script to target, notifying target's list update callback
+         *
+         * @throws PandoraException if script is malformed or was encoded for a list of another size
+         */
+        template <typename Storage>
+        static void Apply(const uint8_t* data, size_t size, RealDataSet<T, Storage>& target)
+        {
+            Decoded decoded = Decode(data, size, target.GetStorage());
+            target.SetDataWithUpdates(std::move(decoded.items), [&decoded](ListUpdateCallback* callback)
+            {
+                Dispatch(decoded.ops, callback);
+            });
+        }
+
+        template <typename Storage>
+        static void Apply(const std::vector<uint8_t>& script, RealDataSet<T, Storage>& target)
+        {
+            Apply(script.data(), script.size(), target);
+        }
+
+        /**
+         * @brief Applies script to items, notifying callback if not null
+         */
+        static void Apply(const uint8_t* data, size_t size, std::vector<T>& items, ListUpdateCallback* callback)
+        {
+            Decoded decoded = Decode(data, size, items);
+            items = std::move(decoded.items);
+            if (callback) Dispatch(decoded.ops, callback);
+        }
+
+    private:
+        struct Op
+        {
+            detail::EditOp op;
+            int first;
+            int second;
+            uint64_t field_mask;
+            bool has_field_mask;
+        };
+
+        struct Decoded
+        {
+            std::vector<Op> ops;
+            std::vector<T> items;
+        };
+
+        template <typename Storage>
+        static Decoded Decode(const uint8_t* data, size_t size, const Storage& old_items)
+        {
+            BinaryReader reader(data, size);
+            if (reader.ReadFixed32() != kEditScriptMagic)
+            {
+                throw PandoraException("EditScriptDecoder: not an edit script");
+            }
+            const uint64_t version = reader.ReadVarint();
+            if (version != kEditScriptVersion)
+            {
+                throw PandoraException("EditScriptDecoder: unsupported script version " + std::to_string(version));
+            }
+            const uint8_t encoding = reader.ReadU8();
+            const uint64_t item_size = reader.ReadVarint();
+            if (encoding != (IsRawSerializable<T>::value ? 1 : 0) ||
+                item_size != (IsRawSerializable<T>::value ? sizeof(T) : 0))
+            {
+                throw PandoraException("EditScriptDecoder: script was encoded with another item encoding");
+            }
+            const uint64_t old_size = reader.ReadVarint();
+            if (old_size != old_items.size())
+            {
+                throw PandoraException("EditScriptDecoder: script expects " + std::to_string(old_size) +
+                                       " items, the list has " + std::to_string(old_items.size()));
+            }
+
+            // Old position of the item at every position, -1 for inserted and changed items the script carries
+            std::vector<int> sources(old_items.size());
+            for (size_t i = 0; i < sources.size(); ++i) sources[i] = static_cast<int>(i);
+
+            Decoded decoded;
+            for (;;)
+            {
+                const auto op = static_cast<detail::EditOp>(reader.ReadU8());
+                if (op == detail::EditOp::END) break;
+                if (op == detail::EditOp::DISPATCHED)
+                {
+                    decoded.ops.push_back(Op{op, 0, 0, 0, false});
+                    continue;
+                }
+                if (op != detail::EditOp::INSERTED && op != detail::EditOp::REMOVED &&
+                    op != detail::EditOp::MOVED && op != detail::EditOp::CHANGED)
+                {
+                    throw PandoraException("EditScriptDecoder: unknown operation " +
+                                           std::to_string(static_cast<int>(op)));
+                }
+                Op decoded_op{op, ReadInt(reader), ReadInt(reader), 0, false};
+                if (op == detail::EditOp::CHANGED)
+                {
+                    const uint8_t payload_kind = reader.ReadU8();
+                    if (payload_kind == detail::kFieldMaskPayload)
+                    {
+                        decoded_op.field_mask = reader.ReadVarint();
+                        decoded_op.has_field_mask = true;
+                    }
+                    else if (payload_kind != detail::kNoPayload)
+                    {
+                        throw PandoraException("EditScriptDecoder: unknown payload kind " +
+                                               std::to_string(static_cast<int>(payload_kind)));
+                    }
+                }
+                ApplyToSources(decoded_op, sources);
+                decoded.ops.push_back(decoded_op);
+            }
+
+            if (reader.ReadVarint() != sources.size())
+            {
+                throw PandoraException("EditScriptDecoder: updates do not produce the encoded size");
+            }
+            const uint64_t item_count = reader.ReadVarint();
+            if (item_count > sources.size())
+            {
+                throw PandoraException("EditScriptDecoder: more items than positions");
+            }
+
+            decoded.items.reserve(sources.size());
+            size_t position = 0;
+            uint64_t last = 0;
+            for (uint64_t i = 0; i < item_count; ++i)
+            {
+                const uint64_t delta = reader.ReadVarint();
+                if ((i > 0 && delta == 0) || delta >= sources.size() || last + delta >= sources.size())
+                {
+                    throw PandoraException("EditScriptDecoder: item position out of range");
+                }
+                last += delta;
+                for (; position < last; ++position) decoded.items.push_back(OldItem(old_items, sources[position]));
+                decoded.items.push_back(detail::ReadScriptItem<T>(reader));
+                position++;
+            }
+            for (; position < sources.size(); ++position) decoded.items.push_back(OldItem(old_items, sources[position]));
+            if (!reader.AtEnd())
+            {
+                throw PandoraException("EditScriptDecoder: trailing bytes after the script");
+            }
+            return decoded;
+        }
+
+        static int ReadInt(BinaryReader& reader)
+        {
+            const uint64_t value = reader.ReadVarint();
+            if (value > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+            {
+                throw PandoraException("EditScriptDecoder: position out of range");
+            }
+            return static_cast<int>(value);
+        }
+
+        static void ApplyToSources(const Op& op, std::vector<int>& sources)
+        {
+            const auto size = static_cast<int>(sources.size());
+            const bool valid =
+                op.op == detail::EditOp::INSERTED ? op.first <= size :
+                op.op == detail::EditOp::MOVED ? op.first < size && op.second < size :
+                op.second <= size - op.first;
+            if (!valid)
+            {
+                throw PandoraException("EditScriptDecoder: update out of range at " + std::to_string(op.first));
+            }
+
+            switch (op.op)
+            {
+            case detail::EditOp::INSERTED:
+                sources.insert(sources.begin() + op.first, static_cast<size_t>(op.second), -1);
+                break;
+            case detail::EditOp::REMOVED:
+                sources.erase(sources.begin() + op.first, sources.begin() + op.first + op.second);
+                break;
+            case detail::EditOp::MOVED:
+            {
+                const int source = sources[op.first];
+                sources.erase(sources.begin() + op.first);
+                sources.insert(sources.begin() + op.second, source);
+                break;
+            }
+            case detail::EditOp::CHANGED:
+                // The script must carry the new contents
+                std::fill(sources.begin() + op.first, sources.begin() + op.first + op.second, -1);
+                break;
+            default:
+                break;
+            }
+        }
+
+        template <typename Storage>
+        static const T& OldItem(const Storage& old_items, int source)
+        {
+            if (source < 0)
+            {
+                throw PandoraException("EditScriptDecoder: script lacks an inserted or changed item");
+            }
+            return old_items[static_cast<size_t>(source)];
+        }
+
+        static void Dispatch(const std::vector<Op>& ops, ListUpdateCallback* callback)
+        {
+            for (const Op& op : ops)
+            {
+                switch (op.op)
+                {
+                case detail::EditOp::INSERTED: callback->OnInserted(op.first, op.second); break;
+                case detail::EditOp::REMOVED: callback->OnRemoved(op.first, op.second); break;
+                case detail::EditOp::MOVED: callback->OnMoved(op.first, op.second); break;
+                case detail::EditOp::CHANGED:
+                    callback->OnChangedWithPayload(op.first, op.second,
+                        op.has_field_mask ? Payload(FieldChangeMask{op.field_mask}) : Payload());
+                    break;
+                case detail::EditOp::DISPATCHED: callback->OnUpdatesDispatched(); break;
+                default: break;
+                }
+            }
+        }
+    };
+} // namespace pandora
+
+#endif // PANDORA_EDIT_SCRIPT_H_
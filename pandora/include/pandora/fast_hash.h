@@ -0,0 +1,128 @@
+#ifndef PANDORA_FAST_HASH_H_
+#define PANDORA_FAST_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pandora
+{
+    /**
+     * @brief wyhash (final version 4) over raw bytes
+     *
+     * A fast non-cryptographic hash built on 64x64->128 bit multiplication.
+     * Used by ContentHasher for trivially copyable types, where the length is
+     * a compile-time constant and all length branches fold away.
+     */
+    namespace fast_hash
+    {
+        constexpr uint64_t kSecret[4] = {
+            0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+        inline void MultiplyFold(uint64_t& a, uint64_t& b)
+        {
+#if defined(__SIZEOF_INT128__)
+            const __uint128_t product = static_cast<__uint128_t>(a) * b;
+            a = static_cast<uint64_t>(product);
+            b = static_cast<uint64_t>(product >> 64);
+#else
+            const uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+            const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+            const uint64_t t = rl + (rm0 << 32);
+            uint64_t carry = t < rl;
+            const uint64_t lo = t + (rm1 << 32);
+            carry += lo < t;
+            a = lo;
+            b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+        }
+
+        inline uint64_t Mix(uint64_t a, uint64_t b)
+        {
+            MultiplyFold(a, b);
+            return a ^ b;
+        }
+
+        inline uint64_t Read64(const uint8_t* p)
+        {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint64_t Read32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint64_t Read3(const uint8_t* p, size_t len)
+        {
+            return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+        }
+
+        /**
+         * @brief Hashes len bytes at data
+         *
+         * Results depend on the byte order of the platform, which is fine for
+         * in-memory snapshots but not for anything persisted.
+         */
+        inline uint64_t HashBytes(const void* data, size_t len, uint64_t seed = 0)
+        {
+            const auto* p = static_cast<const uint8_t*>(data);
+            seed ^= Mix(seed ^ kSecret[0], kSecret[1]);
+            uint64_t a;
+            uint64_t b;
+            if (len <= 16)
+            {
+                if (len >= 4)
+                {
+                    a = (Read32(p) << 32) | Read32(p + ((len >> 3) << 2));
+                    b = (Read32(p + len - 4) << 32) | Read32(p + len - 4 - ((len >> 3) << 2));
+                }
+                else if (len > 0)
+                {
+                    a = Read3(p, len);
+                    b = 0;
+                }
+                else
+                {
+                    a = b = 0;
+                }
+            }
+            else
+            {
+                size_t i = len;
+                if (i > 48)
+                {
+                    uint64_t see1 = seed;
+                    uint64_t see2 = seed;
+                    do
+                    {
+                        seed = Mix(Read64(p) ^ kSecret[1], Read64(p + 8) ^ seed);
+                        see1 = Mix(Read64(p + 16) ^ kSecret[2], Read64(p + 24) ^ see1);
+                        see2 = Mix(Read64(p + 32) ^ kSecret[3], Read64(p + 40) ^ see2);
+                        p += 48;
+                        i -= 48;
+                    } while (i > 48);
+                    seed ^= see1 ^ see2;
+                }
+                while (i > 16)
+                {
+                    seed = Mix(Read64(p) ^ kSecret[1], Read64(p + 8) ^ seed);
+                    i -= 16;
+                    p += 16;
+                }
+                a = Read64(p + i - 16);
+                b = Read64(p + i - 8);
+            }
+            a ^= kSecret[1];
+            b ^= seed;
+            MultiplyFold(a, b);
+            return Mix(a ^ kSecret[0] ^ len, b ^ kSecret[1]);
+        }
+    } // namespace fast_hash
+} // namespace pandora
+
+#endif // PANDORA_FAST_HASH_H_
@@ -0,0 +1,166 @@
+#ifndef PANDORA_FIELD_HASHERS_H_
+#define PANDORA_FIELD_HASHERS_H_
+
+#include "pandora_traits.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Payload of OnChanged for types with FieldHashers: which fields changed
+     *
+     * Bit i is set when field i of FieldHashers<T> differs from the snapshot.
+     * It travels inline in a Payload; the pointer passed to OnChanged is only
+     * valid during that call, so copy the mask (or the Payload) to keep it.
+     *
+     * @code
+     * void OnChangedWithPayload(int position, int count, const Payload& payload) override
+     * {
+     *     const auto* mask = payload.Get<FieldChangeMask>();
+     *     if (mask && !mask->Has(kTitleField)) { RebindLikes(position); return; }
+     *     RebindAll(position, count);
+     * }
+     * @endcode
+     */
+    struct FieldChangeMask
+    {
+        uint64_t bits = 0;
+
+        [[nodiscard]] bool Has(int field) const { return (bits >> field) & 1u; }
+        [[nodiscard]] bool Empty() const { return bits == 0; }
+
+        // Adjacent changes batched together rebind the fields changed in either
+        void Merge(const FieldChangeMask& other) { bits |= other.bits; }
+    };
+
+    /**
+     * @brief Declares the fields of T that views bind separately
+     *
+     * Specialize it with a FieldList of member pointers:
+     *
+     * @code
+     * template <>
+     * struct pandora::FieldHashers<Article> : FieldList<&Article::title, &Article::likes> {};
+     * @endcode
+     *
+     * or with any type providing kCount (at most 64) and
+     * static void HashFields(const T&, uint32_t* out) writing kCount hashes.
+     * RealDataSet and WrapperDataSet then keep one 32-bit hash per field in
+     * their snapshot and pass a FieldChangeMask to OnChanged. Without a
+     * specialization the payload stays nullptr.
+     */
+    template <typename T>
+    struct FieldHashers
+    {
+    };
+
+    template <typename T, typename = void>
+    struct HasFieldHashers : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct HasFieldHashers<T, std::void_t<decltype(FieldHashers<T>::kCount)>> : std::true_type
+    {
+    };
+
+    namespace detail
+    {
+        // std::hash where the standard library has one (strings, fundamentals), otherwise ContentHasher
+        template <typename F>
+        uint32_t HashField(const F& value)
+        {
+            size_t hash;
+            if constexpr (std::is_default_constructible_v<std::hash<F>>) hash = std::hash<F>{}(value);
+            else hash = ContentHasher<F>{}(value);
+            return static_cast<uint32_t>(static_cast<uint64_t>(hash) ^ (static_cast<uint64_t>(hash) >> 32));
+        }
+    } // namespace detail
+
+    /**
+     * @brief FieldHashers built from member pointers, each field hashed on its own
+     */
+    template <auto... Members>
+    struct FieldList
+    {
+        static constexpr int kCount = sizeof...(Members);
+
+        template <typename T>
+        static void HashFields(const T& obj, uint32_t* out)
+        {
+            int i = 0;
+            ((out[i++] = detail::HashField(obj.*Members)), ...);
+        }
+    };
+
+    /**
+     * @brief Per-field hashes of a snapshot, for data sets to build FieldChangeMask payloads
+     *
+     * Empty and free for types without FieldHashers.
+     */
+    template <typename T>
+    class FieldHashSnapshot
+    {
+    public:
+        static constexpr bool kEnabled = HasFieldHashers<T>::value;
+
+        void Capture(const T* items, size_t count)
+        {
+            if constexpr (kEnabled)
+            {
+                constexpr int kFields = FieldHashers<T>::kCount;
+                static_assert(kFields > 0 && kFields <= 64, "FieldHashers supports 1 to 64 fields");
+                hashes_.resize(count * kFields);
+                for (size_t i = 0; i < count; ++i) FieldHashers<T>::HashFields(items[i], &hashes_[i * kFields]);
+            }
+        }
+
+        // Empty slots hash to 0 in every field
+        void Capture(const std::optional<T>* items, size_t count)
+        {
+            if constexpr (kEnabled)
+            {
+                constexpr int kFields = FieldHashers<T>::kCount;
+                static_assert(kFields > 0 && kFields <= 64, "FieldHashers supports 1 to 64 fields");
+                hashes_.assign(count * kFields, 0);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (items[i]) FieldHashers<T>::HashFields(*items[i], &hashes_[i * kFields]);
+                }
+            }
+        }
+
+        /**
+         * @brief The declared fields of item that differ from snapshot item index
+         *
+         * Empty without FieldHashers, or when only undeclared fields changed.
+         */
+        [[nodiscard]] FieldChangeMask Compare(size_t index, const T& item) const
+        {
+            FieldChangeMask mask;
+            if constexpr (kEnabled)
+            {
+                constexpr int kFields = FieldHashers<T>::kCount;
+                uint32_t current[kFields];
+                FieldHashers<T>::HashFields(item, current);
+                for (int field = 0; field < kFields; ++field)
+                {
+                    if (current[field] != hashes_[index * kFields + field]) mask.bits |= uint64_t{1} << field;
+                }
+            }
+            return mask;
+        }
+
+        [[nodiscard]] size_t GetBytes() const { return hashes_.size() * sizeof(uint32_t); }
+
+    private:
+        std::vector<uint32_t> hashes_;
+    };
+} // namespace pandora
+
+#endif // PANDORA_FIELD_HASHERS_H_
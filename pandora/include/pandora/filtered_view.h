@@ -0,0 +1,563 @@
+#ifndef PANDORA_FILTERED_VIEW_H_
+#define PANDORA_FILTERED_VIEW_H_
+
+#include "pandora_box_adapter.h"
+#include "list_update_callback.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Live, read-only filtered view over a PandoraBoxAdapter
+     *
+     * Keeps the sorted list of source positions whose items match a predicate
+     * and updates it incrementally from the source's ListUpdateCallback: only
+     * the inserted, removed, moved or changed entries are touched, and the view
+     * reports precise, coalesced updates to its own ListUpdateCallback. Changing
+     * the predicate re-evaluates the source in parallel chunks and is reported
+     * as a linear merge of the old and new visible lists, without a diff.
+     *
+     * The view takes over the source's ListUpdateCallback slot; the callback
+     * installed before is kept and still receives every source update.
+     *
+     * Inserted and changed items are evaluated once the source batch has been
+     * dispatched (ListUpdateCallback::OnUpdatesDispatched), when source
+     * positions match the data again, or lazily on the next read or Sync().
+     *
+     * @tparam T The data type
+     *
+     * Example:
+     * @code
+     * RealDataSet<Contact> contacts;
+     * FilteredView<Contact> results(&contacts);
+     * results.SetListUpdateCallback(std::make_unique<MyAdapterCallback>());
+     *
+     * // On every keystroke
+     * results.SetPredicate([query](const Contact& c) { return c.name.find(query) != std::string::npos; });
+     * @endcode
+     *
+     * @note The source must outlive the view. The predicate may be called from
+     *       several threads at once. Change payloads are not forwarded.
+     */
+    template <typename T>
+    class FilteredView
+    {
+    public:
+        using Predicate = std::function<bool(const T&)>;
+
+        /// Sources smaller than this are evaluated on the calling thread
+        static constexpr int kDefaultMinParallelChunk = 4096;
+
+        /**
+         * @param source The adapter to filter
+         * @param predicate Items for which it returns true are visible; null shows everything
+         * @param min_parallel_chunk Minimum number of items evaluated per worker thread
+         */
+        explicit FilteredView(PandoraBoxAdapter<T>* source, Predicate predicate = nullptr,
+                              int min_parallel_chunk = kDefaultMinParallelChunk)
+            : source_(source), predicate_(std::move(predicate)),
+              min_parallel_chunk_(std::max(1, min_parallel_chunk))
+        {
+            if (!source_)
+            {
+                throw PandoraException("FilteredView: source cannot be null");
+            }
+            Rebuild();
+            auto listener = std::make_unique<SourceListener>(this, source_->TakeListUpdateCallback());
+            listener_ = listener.get();
+            source_->SetListUpdateCallback(std::move(listener));
+        }
+
+        FilteredView(const FilteredView&) = delete;
+        FilteredView& operator=(const FilteredView&) = delete;
+
+        ~FilteredView()
+        {
+            // Hand the original callback back, unless someone replaced ours meanwhile
+            if (source_->GetListUpdateCallback() == listener_)
+            {
+                auto previous = std::move(listener_->previous);
+                source_->SetListUpdateCallback(std::move(previous));
+            }
+        }
+
+        [[nodiscard]] PandoraBoxAdapter<T>* GetSource() const { return source_; }
+
+        [[nodiscard]] ListUpdateCallback* GetListUpdateCallback() const { return callback_.get(); }
+
+        void SetListUpdateCallback(std::unique_ptr<ListUpdateCallback> callback)
+        {
+            callback_ = std::move(callback);
+        }
+
+        /// Number of visible items
+        int GetDataCount()
+        {
+            SyncIfIdle();
+            return static_cast<int>(visible_.size());
+        }
+
+        /// Visible item at index, or nullptr
+        T* GetDataByIndex(int index)
+        {
+            SyncIfIdle();
+            if (index < 0 || index >= static_cast<int>(visible_.size())) return nullptr;
+            return source_->GetDataByIndex(visible_[index]);
+        }
+
+        /// Source position of the visible item at index, or -1
+        int GetSourceIndex(int index)
+        {
+            SyncIfIdle();
+            if (index < 0 || index >= static_cast<int>(visible_.size())) return -1;
+            return visible_[index];
+        }
+
+        /// Visible index of the item at source_index, or -1 when it is filtered out
+        int GetVisibleIndex(int source_index)
+        {
+            SyncIfIdle();
+            const auto it = std::lower_bound(visible_.begin(), visible_.end(), source_index);
+            if (it == visible_.end() || *it != source_index) return -1;
+            return static_cast<int>(it - visible_.begin());
+        }
+
+        /**
+         * @brief Replace the predicate and report what appeared and disappeared
+         */
+        void SetPredicate(Predicate predicate)
+        {
+            predicate_ = std::move(predicate);
+            Refresh();
+        }
+
+        /**
+         * @brief Re-evaluate every item, e.g. after state captured by the predicate changed
+         */
+        void Refresh()
+        {
+            const int count = static_cast<int>(state_.size());
+            for (auto& state : state_)
+            {
+                // Pending entries are evaluated anyway; settled ones are re-checked without a change
+                if (state == kVisible) state = kPendingRefreshVisible;
+                else if (state == kHidden) state = kPendingRefreshHidden;
+            }
+            MarkPending(0, count);
+            Sync();
+        }
+
+        /**
+         * @brief Evaluate pending items now and report the result
+         */
+        void Sync()
+        {
+            if (!has_pending_) return;
+            has_pending_ = false;
+
+            const int lo = std::max(0, pending_lo_);
+            const int hi = std::min(static_cast<int>(state_.size()), pending_hi_);
+            if (lo >= hi) return;
+
+            std::vector<int> positions;
+            for (int p = lo; p < hi; ++p)
+            {
+                if (IsPending(state_[p])) positions.push_back(p);
+            }
+            const std::vector<uint8_t> matches = Evaluate(positions);
+
+            // Walk the range once, rebuilding its part of visible_ and recording
+            // the updates relative to what observers have been told so far.
+            const auto seg_begin = std::lower_bound(visible_.begin(), visible_.end(), lo);
+            const auto seg_end = std::lower_bound(seg_begin, visible_.end(), hi);
+            int out = static_cast<int>(seg_begin - visible_.begin());
+
+            std::vector<int> segment;
+            Updates updates;
+            size_t next = 0;
+            for (int p = lo; p < hi; ++p)
+            {
+                const uint8_t state = state_[p];
+                bool now_visible = WasVisible(state);
+                if (next < positions.size() && positions[next] == p)
+                {
+                    now_visible = matches[next++] != 0;
+                }
+
+                if (WasVisible(state) && now_visible)
+                {
+                    if (state == kPendingChangeVisible) updates.Add(kChanged, out, 1);
+                    ++out;
+                }
+                else if (WasVisible(state))
+                {
+                    updates.Add(kRemoved, out, 1);
+                }
+                else if (now_visible)
+                {
+                    updates.Add(kInserted, out, 1);
+                    ++out;
+                }
+
+                state_[p] = now_visible ? kVisible : kHidden;
+                if (now_visible) segment.push_back(p);
+            }
+
+            const auto offset = seg_begin - visible_.begin();
+            visible_.erase(seg_begin, seg_end);
+            visible_.insert(visible_.begin() + offset, segment.begin(), segment.end());
+
+            updates.DispatchTo(callback_.get());
+        }
+
+        [[nodiscard]] bool HasPendingChanges() const { return has_pending_; }
+
+    private:
+        // Per source position
+        static constexpr uint8_t kHidden = 0;
+        static constexpr uint8_t kVisible = 1;
+        static constexpr uint8_t kPendingInsert = 2;          // Not yet reported
+        static constexpr uint8_t kPendingChangeVisible = 3;   // Reported visible, content changed
+        static constexpr uint8_t kPendingChangeHidden = 4;    // Hidden, content changed
+        static constexpr uint8_t kPendingRefreshVisible = 5;  // Reported visible, predicate changed
+        static constexpr uint8_t kPendingRefreshHidden = 6;   // Hidden, predicate changed
+
+        static bool IsPending(uint8_t state) { return state >= kPendingInsert; }
+
+        // Whether observers currently see the item
+        static bool WasVisible(uint8_t state)
+        {
+            return state == kVisible || state == kPendingChangeVisible || state == kPendingRefreshVisible;
+        }
+
+        enum UpdateType { kInserted, kRemoved, kChanged, kMoved };
+
+        // Collects updates, merging consecutive ones of the same kind
+        class Updates
+        {
+        public:
+            void Add(UpdateType type, int position, int count)
+            {
+                if (!ops_.empty())
+                {
+                    Op& last = ops_.back();
+                    if (last.type == type && type != kMoved)
+                    {
+                        const bool contiguous = type == kRemoved
+                                                    ? last.position == position
+                                                    : last.position + last.count == position;
+                        if (contiguous)
+                        {
+                            last.count += count;
+                            return;
+                        }
+                    }
+                }
+                ops_.push_back(Op{type, position, count});
+            }
+
+            void DispatchTo(ListUpdateCallback* callback) const
+            {
+                if (!callback || ops_.empty()) return;
+                for (const Op& op : ops_)
+                {
+                    switch (op.type)
+                    {
+                    case kInserted: callback->OnInserted(op.position, op.count); break;
+                    case kRemoved: callback->OnRemoved(op.position, op.count); break;
+                    case kChanged: callback->OnChanged(op.position, op.count, nullptr); break;
+                    case kMoved: callback->OnMoved(op.position, op.count); break;
+                    }
+                }
+                callback->OnUpdatesDispatched();
+            }
+
+        private:
+            struct Op
+            {
+                UpdateType type;
+                int position;
+                int count;  // Target position for moves
+            };
+
+            std::vector<Op> ops_;
+        };
+
+        class SourceListener : public ListUpdateCallback
+        {
+        public:
+            SourceListener(FilteredView* owner, std::unique_ptr<ListUpdateCallback> chained)
+                : view(owner), previous(std::move(chained))
+            {
+            }
+
+            void OnInserted(int position, int count) override
+            {
+                if (previous) previous->OnInserted(position, count);
+                Guard guard(view);
+                view->OnSourceInserted(position, count);
+            }
+
+            void OnRemoved(int position, int count) override
+            {
+                if (previous) previous->OnRemoved(position, count);
+                Guard guard(view);
+                view->OnSourceRemoved(position, count);
+            }
+
+            void OnMoved(int from_position, int to_position) override
+            {
+                if (previous) previous->OnMoved(from_position, to_position);
+                Guard guard(view);
+                view->OnSourceMoved(from_position, to_position);
+            }
+
+            void OnChanged(int position, int count, void* payload) override
+            {
+                if (previous) previous->OnChanged(position, count, payload);
+                Guard guard(view);
+                view->OnSourceChanged(position, count);
+            }
+
+            void OnChangedWithPayload(int position, int count, const Payload& payload) override
+            {
+                if (previous) previous->OnChangedWithPayload(position, count, payload);
+                Guard guard(view);
+                view->OnSourceChanged(position, count);
+            }
+
+            void OnUpdatesDispatched() override
+            {
+                if (previous) previous->OnUpdatesDispatched();
+                view->Sync();
+            }
+
+            FilteredView* view;
+            std::unique_ptr<ListUpdateCallback> previous;
+
+        private:
+            // Observers reading the view from inside a source update must not
+            // trigger evaluation while source positions are still in flux.
+            struct Guard
+            {
+                explicit Guard(FilteredView* v) : view(v) { ++view->in_source_update_; }
+                ~Guard() { --view->in_source_update_; }
+                FilteredView* view;
+            };
+        };
+
+        void Rebuild()
+        {
+            const int count = source_->GetDataCount();
+            state_.assign(count, kPendingInsert);
+            visible_.clear();
+            has_pending_ = false;
+            MarkPending(0, count);
+            // No callback is installed yet, so the initial evaluation is silent
+            Sync();
+        }
+
+        void SyncIfIdle()
+        {
+            if (has_pending_ && in_source_update_ == 0) Sync();
+        }
+
+        void MarkPending(int lo, int hi)
+        {
+            if (lo >= hi) return;
+            if (has_pending_)
+            {
+                pending_lo_ = std::min(pending_lo_, lo);
+                pending_hi_ = std::max(pending_hi_, hi);
+            }
+            else
+            {
+                pending_lo_ = lo;
+                pending_hi_ = hi;
+                has_pending_ = true;
+            }
+        }
+
+        // Shift every visible source position >= position by delta
+        void ShiftVisible(int position, int delta)
+        {
+            for (auto it = std::lower_bound(visible_.begin(), visible_.end(), position); it != visible_.end(); ++it)
+            {
+                *it += delta;
+            }
+        }
+
+        void OnSourceInserted(int position, int count)
+        {
+            if (count <= 0 || position < 0 || position > static_cast<int>(state_.size())) return;
+            state_.insert(state_.begin() + position, count, kPendingInsert);
+            ShiftVisible(position, count);
+            if (has_pending_)
+            {
+                if (pending_lo_ >= position) pending_lo_ += count;
+                if (pending_hi_ > position) pending_hi_ += count;
+            }
+            MarkPending(position, position + count);
+        }
+
+        void OnSourceRemoved(int position, int count)
+        {
+            const int end = std::min(position + count, static_cast<int>(state_.size()));
+            if (position < 0 || position >= end) return;
+            count = end - position;
+
+            const auto first = std::lower_bound(visible_.begin(), visible_.end(), position);
+            const auto last = std::lower_bound(first, visible_.end(), end);
+            const int visible_index = static_cast<int>(first - visible_.begin());
+            const int removed = static_cast<int>(last - first);
+            visible_.erase(first, last);
+            state_.erase(state_.begin() + position, state_.begin() + end);
+            ShiftVisible(end - count, -count);
+
+            if (has_pending_)
+            {
+                pending_lo_ = pending_lo_ >= end ? pending_lo_ - count : std::min(pending_lo_, position);
+                pending_hi_ = pending_hi_ >= end ? pending_hi_ - count : std::min(pending_hi_, position);
+                if (pending_hi_ <= pending_lo_) has_pending_ = false;
+            }
+
+            if (removed > 0 && callback_)
+            {
+                callback_->OnRemoved(visible_index, removed);
+            }
+        }
+
+        void OnSourceMoved(int from_position, int to_position)
+        {
+            const int size = static_cast<int>(state_.size());
+            if (from_position == to_position || from_position < 0 || from_position >= size ||
+                to_position < 0 || to_position >= size)
+            {
+                return;
+            }
+
+            const uint8_t state = state_[from_position];
+            const bool visible = WasVisible(state);
+            int from_visible = -1;
+            if (visible)
+            {
+                const auto it = std::lower_bound(visible_.begin(), visible_.end(), from_position);
+                from_visible = static_cast<int>(it - visible_.begin());
+                visible_.erase(it);
+            }
+            state_.erase(state_.begin() + from_position);
+            ShiftVisible(from_position, -1);
+
+            state_.insert(state_.begin() + to_position, state);
+            ShiftVisible(to_position, 1);
+            if (visible)
+            {
+                const auto it = std::lower_bound(visible_.begin(), visible_.end(), to_position);
+                const int to_visible = static_cast<int>(it - visible_.begin());
+                visible_.insert(it, to_position);
+                if (from_visible != to_visible && callback_)
+                {
+                    callback_->OnMoved(from_visible, to_visible);
+                }
+            }
+
+            if (has_pending_)
+            {
+                MarkPending(std::min(from_position, to_position), std::max(from_position, to_position) + 1);
+            }
+        }
+
+        void OnSourceChanged(int position, int count)
+        {
+            const int end = std::min(position + count, static_cast<int>(state_.size()));
+            if (position < 0 || position >= end) return;
+            for (int p = position; p < end; ++p)
+            {
+                uint8_t& state = state_[p];
+                if (state == kVisible || state == kPendingRefreshVisible) state = kPendingChangeVisible;
+                else if (state == kHidden || state == kPendingRefreshHidden) state = kPendingChangeHidden;
+            }
+            MarkPending(position, end);
+        }
+
+        // Evaluate the predicate for source positions, in parallel chunks for large batches
+        std::vector<uint8_t> Evaluate(const std::vector<int>& positions)
+        {
+            const int count = static_cast<int>(positions.size());
+            std::vector<uint8_t> matches(count, 1);
+            if (!predicate_ || count == 0) return matches;
+
+            // Resolve items up front: adapters are not required to be thread-safe
+            std::vector<const T*> items(count);
+            for (int i = 0; i < count; ++i)
+            {
+                items[i] = source_->GetDataByIndex(positions[i]);
+            }
+
+            const Predicate& predicate = predicate_;
+            auto evaluate_chunk = [&items, &matches, &predicate](int begin, int end)
+            {
+                for (int i = begin; i < end; ++i)
+                {
+                    try
+                    {
+                        matches[i] = items[i] && predicate(*items[i]) ? 1 : 0;
+                    }
+                    catch (const std::exception& e)
+                    {
+                        matches[i] = 0;
+                        Logger::e("FilteredView", std::string("Exception in predicate: ") + e.what());
+                    }
+                }
+            };
+
+            const int hardware = std::max(1u, std::thread::hardware_concurrency());
+            const int chunks = std::min(hardware, (count + min_parallel_chunk_ - 1) / min_parallel_chunk_);
+            if (chunks <= 1)
+            {
+                evaluate_chunk(0, count);
+                return matches;
+            }
+
+            const int chunk_size = (count + chunks - 1) / chunks;
+            std::vector<std::future<void>> workers;
+            workers.reserve(chunks - 1);
+            for (int c = 1; c < chunks; ++c)
+            {
+                const int begin = c * chunk_size;
+                const int end = std::min(count, begin + chunk_size);
+                workers.push_back(std::async(std::launch::async, evaluate_chunk, begin, end));
+            }
+            evaluate_chunk(0, std::min(count, chunk_size));
+            for (auto& worker : workers)
+            {
+                worker.get();
+            }
+            return matches;
+        }
+
+        PandoraBoxAdapter<T>* source_;
+        Predicate predicate_;
+        int min_parallel_chunk_;
+        std::unique_ptr<ListUpdateCallback> callback_;
+        SourceListener* listener_ = nullptr;  // Owned by the source
+
+        std::vector<uint8_t> state_;  // One entry per source position
+        std::vector<int> visible_;    // Sorted source positions reported as visible
+        bool has_pending_ = false;
+        int pending_lo_ = 0;  // Pending entries lie within [pending_lo_, pending_hi_)
+        int pending_hi_ = 0;
+        int in_source_update_ = 0;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_FILTERED_VIEW_H_
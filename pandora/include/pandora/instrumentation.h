@@ -0,0 +1,18 @@
+#ifndef PANDORA_INSTRUMENTATION_H_
+#define PANDORA_INSTRUMENTATION_H_
+
+#include "metrics.h"
+#include "phase_timing.h"
+#include "trace.h"
+
+/**
+ * Marks a phase of the notification path of adapter for every enabled
+ * instrumentation (PANDORA_ENABLE_PHASE_TIMING, PANDORA_ENABLE_METRICS); a
+ * no-op when none is. Trace spans (PANDORA_ENABLE_TRACING) are opened next to
+ * it with PANDORA_TRACE_SPAN, since their sites attach sizes and edit counts.
+ */
+#define PANDORA_INSTRUMENT_PHASE(adapter, phase) \
+    PANDORA_TIME_PHASE(phase);                   \
+    PANDORA_METRICS_PHASE(adapter, phase)
+
+#endif  // PANDORA_INSTRUMENTATION_H_
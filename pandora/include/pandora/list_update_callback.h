@@ -3,6 +3,8 @@
 
 #include <memory>
 
+#include "payload.h"
+
 namespace pandora {
 
 /**
@@ -45,6 +47,29 @@ class ListUpdateCallback {
    */
   virtual void OnChanged(int position, int count, void* payload = nullptr) = 0;
 
+  /**
+   * Called when count number of items are updated at the given position, with a typed payload.
+   *
+   * DiffUtil dispatches changes through this method. The default forwards payload.Data()
+   * to OnChanged, so callbacks implementing only OnChanged see the same pointers; override
+   * this one to read the payload with Payload::Get or to keep a copy of it. It has its own
+   * name so that overriding OnChanged alone does not hide it.
+   *
+   * @param position The position of the item which has been updated.
+   * @param count    The number of items which has changed.
+   * @param payload  The payload, empty when there is none.
+   */
+  virtual void OnChangedWithPayload(int position, int count, const Payload& payload) {
+    OnChanged(position, count, payload.Data());
+  }
+
+  /**
+   * Called after the last update of a batch, e.g. at the end of
+   * DiffResult::DispatchUpdatesTo. Positions reported so far are now
+   * consistent with the data.
+   */
+  virtual void OnUpdatesDispatched() {}
+
   virtual ~ListUpdateCallback() = default;
 };
 
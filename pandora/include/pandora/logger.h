@@ -18,7 +18,7 @@ namespace pandora
         static void Println(Level lvl, const std::string& t, const std::string& msg)
         {
             // TODO: 推荐使用 spdlog，当前用 std::cout
-            if (debug && Require(lvl))
+            if (IsLoggable(lvl))
             {
                 std::cout << "[" << t << "] " << msg << std::endl;
             }
@@ -28,6 +28,9 @@ namespace pandora
         static void SetLevel(Level lvl) { level = lvl; }
         static bool Require(Level lvl) { return level <= lvl; }
 
+        /// Whether Println would print at lvl; check it before building a costly message
+        static bool IsLoggable(Level lvl) { return debug && Require(lvl); }
+
         static void w(const char* tag, const char* text)
         {
             Println(WARN, tag, text);
@@ -0,0 +1,384 @@
+#ifndef PANDORA_MAPPED_STORAGE_H_
+#define PANDORA_MAPPED_STORAGE_H_
+
+#include "pandora_exception.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pandora
+{
+    /**
+     * @brief Memory-mapped, file-backed storage for RealDataSet
+     *
+     * Records live in a file mapped with MAP_PRIVATE: opening costs one mmap
+     * regardless of the record count, and pages are faulted in as they are
+     * read. The container offers the subset of the std::vector interface
+     * RealDataSet uses, so it can be plugged in as its Storage:
+     *
+     * @code
+     * RealDataSet<Record, MappedStorage<Record>> cache(MappedStorage<Record>::Open("cache.bin"));
+     * cache.Add(record);
+     * cache.GetStorage().Flush();
+     * @endcode
+     *
+     * Mutations land in copy-on-write pages and never reach the file on
+     * their own. Flush() (and destruction) writes the dirty record range
+     * back, then commits the record count in the header. Until then the
+     * file keeps the state of the last Flush(), so a crash loses the
+     * unflushed edits but never leaves records half shifted. Only a crash
+     * inside Flush() itself can leave part of the dirty range written.
+     *
+     * Non-const element access and non-const begin() count as writes, so
+     * the records they reach are written back by the next Flush(). Use the
+     * const accessors and cbegin() to keep that range small.
+     *
+     * @tparam T A trivially copyable record type; the file is only portable
+     *           between builds with the same layout of T
+     *
+     * @note POSIX only. Not thread-safe, and one process should open a file at a time.
+     */
+    template <typename T>
+    class MappedStorage
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "MappedStorage requires a trivially copyable T");
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        MappedStorage() = default;
+
+        MappedStorage(MappedStorage&& other) noexcept { Swap(other); }
+
+        MappedStorage& operator=(MappedStorage&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                Swap(other);
+            }
+            return *this;
+        }
+
+        MappedStorage(const MappedStorage&) = delete;
+        MappedStorage& operator=(const MappedStorage&) = delete;
+
+        ~MappedStorage() { Close(); }
+
+        /**
+         * @brief Open the file at path, creating it when missing
+         *
+         * @throws PandoraException when the file cannot be mapped or was written
+         *         for another record size
+         */
+        static MappedStorage Open(const std::string& path, size_t initial_capacity = 1024)
+        {
+            MappedStorage storage;
+            storage.fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (storage.fd_ < 0)
+            {
+                throw PandoraException("MappedStorage: cannot open " + path + ": " + std::strerror(errno));
+            }
+
+            struct stat st{};
+            if (::fstat(storage.fd_, &st) != 0)
+            {
+                throw PandoraException("MappedStorage: cannot stat " + path + ": " + std::strerror(errno));
+            }
+
+            if (st.st_size == 0)
+            {
+                storage.Map(std::max<size_t>(initial_capacity, 1));
+                storage.header_->magic = kMagic;
+                storage.header_->record_size = sizeof(T);
+                storage.header_->count = 0;
+                if (!storage.WriteBack())
+                {
+                    throw PandoraException("MappedStorage: cannot write " + path + ": " + std::strerror(errno));
+                }
+                return storage;
+            }
+
+            const size_t file_size = static_cast<size_t>(st.st_size);
+            if (file_size < sizeof(Header) || (file_size - sizeof(Header)) % sizeof(T) != 0)
+            {
+                throw PandoraException("MappedStorage: " + path + " is not a storage file");
+            }
+            storage.Map((file_size - sizeof(Header)) / sizeof(T));
+            if (storage.header_->magic != kMagic || storage.header_->record_size != sizeof(T) ||
+                storage.header_->count > storage.capacity_)
+            {
+                storage.Close(false);  // Leave the foreign header untouched
+                throw PandoraException("MappedStorage: " + path + " was written for another record type");
+            }
+            storage.size_ = static_cast<size_t>(storage.header_->count);
+            return storage;
+        }
+
+        [[nodiscard]] bool IsOpen() const { return fd_ >= 0; }
+
+        /**
+         * @brief Write the dirty records to the file, then commit the record count
+         */
+        void Flush() const
+        {
+            if (!IsOpen()) return;
+            if (!WriteBack())
+            {
+                throw PandoraException(std::string("MappedStorage: write back failed: ") + std::strerror(errno));
+            }
+        }
+
+        // std::vector subset used by RealDataSet
+
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] bool empty() const { return size_ == 0; }
+        [[nodiscard]] size_t capacity() const { return capacity_; }
+
+        T& operator[](size_t index)
+        {
+            MarkDirty(index, index + 1);
+            return records_[index];
+        }
+        const T& operator[](size_t index) const { return records_[index]; }
+
+        iterator begin()
+        {
+            MarkDirty(0, size_);
+            return records_;
+        }
+        iterator end() { return records_ + size_; }
+        const_iterator begin() const { return records_; }
+        const_iterator end() const { return records_ + size_; }
+        const_iterator cbegin() const { return records_; }
+        const_iterator cend() const { return records_ + size_; }
+
+        void clear() { size_ = 0; }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity <= capacity_) return;
+            if (!IsOpen())
+            {
+                throw PandoraException("MappedStorage: storage is not open");
+            }
+            Remap(capacity);
+        }
+
+        void push_back(const T& item)
+        {
+            const T copy = item;  // item may live in the mapping, which Grow() moves
+            Grow(size_ + 1);
+            MarkDirty(size_, size_ + 1);
+            records_[size_++] = copy;
+        }
+
+        iterator insert(const_iterator pos, const T& item)
+        {
+            const size_t index = pos - records_;
+            const T copy = item;
+            Grow(size_ + 1);
+            std::memmove(records_ + index + 1, records_ + index, (size_ - index) * sizeof(T));
+            records_[index] = copy;
+            ++size_;
+            MarkDirty(index, size_);
+            return records_ + index;
+        }
+
+        template <typename InputIt>
+        iterator insert(const_iterator pos, InputIt first, InputIt last)
+        {
+            const size_t index = pos - records_;
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            Grow(size_ + count);
+            std::memmove(records_ + index + count, records_ + index, (size_ - index) * sizeof(T));
+            std::copy(first, last, records_ + index);
+            size_ += count;
+            MarkDirty(index, size_);
+            return records_ + index;
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            const size_t index = pos - records_;
+            std::memmove(records_ + index, records_ + index + 1, (size_ - index - 1) * sizeof(T));
+            --size_;
+            MarkDirty(index, size_);
+            return records_ + index;
+        }
+
+        template <typename InputIt>
+        void assign(InputIt first, InputIt last)
+        {
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            Grow(count);
+            std::copy(first, last, records_);
+            size_ = count;
+            MarkDirty(0, size_);
+        }
+
+    private:
+        static constexpr uint32_t kMagic = 0x53444450;  // "PDDS"
+        static constexpr size_t kClean = static_cast<size_t>(-1);
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t record_size;
+            uint64_t count;
+        };
+
+        static size_t MappingSize(size_t capacity) { return sizeof(Header) + capacity * sizeof(T); }
+
+        void MarkDirty(size_t first, size_t last)
+        {
+            if (first >= last) return;
+            dirty_first_ = std::min(dirty_first_, first);
+            dirty_last_ = std::max(dirty_last_, last);
+        }
+
+        static bool WriteAll(int fd, const void* data, size_t size, size_t offset)
+        {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                const ssize_t written = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                bytes += written;
+                size -= static_cast<size_t>(written);
+                offset += static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        // Records first, then the count, so the header never covers unwritten records
+        bool WriteBack() const
+        {
+            const size_t last = std::min(dirty_last_, size_);
+            if (dirty_first_ < last)
+            {
+                if (!WriteAll(fd_, records_ + dirty_first_, (last - dirty_first_) * sizeof(T),
+                              MappingSize(dirty_first_)) ||
+                    ::fsync(fd_) != 0)
+                {
+                    return false;
+                }
+            }
+            header_->count = size_;
+            if (!WriteAll(fd_, header_, sizeof(Header), 0) || ::fsync(fd_) != 0) return false;
+            dirty_first_ = kClean;
+            dirty_last_ = 0;
+            return true;
+        }
+
+        void Grow(size_t required)
+        {
+            if (!IsOpen())
+            {
+                throw PandoraException("MappedStorage: storage is not open");
+            }
+            if (required > capacity_)
+            {
+                Remap(std::max(required, capacity_ * 2));
+            }
+        }
+
+        void Map(size_t capacity)
+        {
+            if (::ftruncate(fd_, static_cast<off_t>(MappingSize(capacity))) != 0)
+            {
+                throw PandoraException(std::string("MappedStorage: cannot resize file: ") + std::strerror(errno));
+            }
+            void* mapping = ::mmap(nullptr, MappingSize(capacity), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_, 0);
+            if (mapping == MAP_FAILED)
+            {
+                throw PandoraException(std::string("MappedStorage: mmap failed: ") + std::strerror(errno));
+            }
+            mapping_ = mapping;
+            capacity_ = capacity;
+            header_ = static_cast<Header*>(mapping);
+            records_ = reinterpret_cast<T*>(static_cast<char*>(mapping) + sizeof(Header));
+        }
+
+        void Remap(size_t capacity)
+        {
+            // The new mapping reads the file, so the unflushed records are carried over by hand.
+            // Map() only replaces the members once it succeeded.
+            void* old_mapping = mapping_;
+            const size_t old_size = MappingSize(capacity_);
+            const T* old_records = records_;
+            Map(capacity);
+            const size_t last = std::min(dirty_last_, size_);
+            if (dirty_first_ < last)
+            {
+                std::memcpy(records_ + dirty_first_, old_records + dirty_first_, (last - dirty_first_) * sizeof(T));
+            }
+            ::munmap(old_mapping, old_size);
+        }
+
+        void Close(bool commit = true)
+        {
+            if (mapping_ && commit)
+            {
+                WriteBack();  // Nothing to report from a destructor; the file keeps the last Flush()
+            }
+            if (mapping_)
+            {
+                ::munmap(mapping_, MappingSize(capacity_));
+            }
+            if (fd_ >= 0)
+            {
+                ::close(fd_);
+            }
+            fd_ = -1;
+            mapping_ = nullptr;
+            header_ = nullptr;
+            records_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+            dirty_first_ = kClean;
+            dirty_last_ = 0;
+        }
+
+        void Swap(MappedStorage& other) noexcept
+        {
+            std::swap(fd_, other.fd_);
+            std::swap(mapping_, other.mapping_);
+            std::swap(header_, other.header_);
+            std::swap(records_, other.records_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(dirty_first_, other.dirty_first_);
+            std::swap(dirty_last_, other.dirty_last_);
+        }
+
+        int fd_ = -1;
+        void* mapping_ = nullptr;
+        Header* header_ = nullptr;
+        T* records_ = nullptr;
+        size_t size_ = 0;
+        size_t capacity_ = 0;
+        // Records written since the last Flush(), as [dirty_first_, dirty_last_)
+        mutable size_t dirty_first_ = kClean;
+        mutable size_t dirty_last_ = 0;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_MAPPED_STORAGE_H_
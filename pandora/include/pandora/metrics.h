@@ -0,0 +1,350 @@
+#ifndef PANDORA_METRICS_H_
+#define PANDORA_METRICS_H_
+
+#include "list_update_callback.h"
+#include "phase_timing.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Log-linear latency histogram in nanoseconds, HDR style
+     *
+     * Every power of two is split into 8 linear sub-buckets, so a recorded
+     * value is reported within 12.5% over its whole range with a fixed
+     * footprint of 4 KiB. Recording is lock-free; reads may run concurrently
+     * with recording and see a slightly stale state.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int kSubBucketBits = 3;
+        static constexpr int kSubBuckets = 1 << kSubBucketBits;
+        static constexpr int kBucketCount = kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+        LatencyHistogram() { Reset(); }
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        void Record(uint64_t nanos)
+        {
+            buckets_[BucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(nanos, std::memory_order_relaxed);
+
+            uint64_t min = min_.load(std::memory_order_relaxed);
+            while (nanos < min && !min_.compare_exchange_weak(min, nanos, std::memory_order_relaxed))
+            {
+            }
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (nanos > max && !max_.compare_exchange_weak(max, nanos, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        [[nodiscard]] uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+
+        [[nodiscard]] uint64_t GetTotal() const { return sum_.load(std::memory_order_relaxed); }
+
+        [[nodiscard]] uint64_t GetMin() const { return GetCount() == 0 ? 0 : min_.load(std::memory_order_relaxed); }
+
+        [[nodiscard]] uint64_t GetMax() const { return max_.load(std::memory_order_relaxed); }
+
+        [[nodiscard]] double GetMean() const
+        {
+            const uint64_t count = GetCount();
+            return count == 0 ? 0.0 : static_cast<double>(GetTotal()) / static_cast<double>(count);
+        }
+
+        /**
+         * @brief Get the value at percentile (0..100), as the upper bound of its bucket
+         */
+        [[nodiscard]] uint64_t GetPercentile(double percentile) const
+        {
+            const uint64_t count = GetCount();
+            if (count == 0) return 0;
+
+            percentile = std::min(100.0, std::max(0.0, percentile));
+            const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * count + 0.5));
+            uint64_t seen = 0;
+            for (int i = 0; i < kBucketCount; ++i)
+            {
+                seen += buckets_[i].load(std::memory_order_relaxed);
+                if (seen >= rank)
+                {
+                    return std::min(BucketUpperBound(i), GetMax());
+                }
+            }
+            return GetMax();
+        }
+
+        void Reset()
+        {
+            for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            min_.store(UINT64_MAX, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+        static int BucketOf(uint64_t value)
+        {
+            if (value < kSubBuckets) return static_cast<int>(value);
+            int exponent = 63;
+            while (!(value >> exponent)) --exponent;
+            const int shift = exponent - kSubBucketBits;
+            const int sub_bucket = static_cast<int>(value >> shift) - kSubBuckets;
+            return kSubBuckets + shift * kSubBuckets + sub_bucket;
+        }
+
+        static uint64_t BucketUpperBound(int bucket)
+        {
+            if (bucket < kSubBuckets) return static_cast<uint64_t>(bucket);
+            const int shift = (bucket - kSubBuckets) / kSubBuckets;
+            const uint64_t sub_bucket = (bucket - kSubBuckets) % kSubBuckets;
+            const uint64_t lower = (kSubBuckets + sub_bucket) << shift;
+            return lower + ((uint64_t{1} << shift) - 1);
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> min_{UINT64_MAX};
+        std::atomic<uint64_t> max_{0};
+    };
+
+    /**
+     * @brief Cost counters of one PandoraBoxAdapter
+     *
+     * Only recorded when PANDORA_ENABLE_METRICS is defined to a non-zero value,
+     * with the same caveat as PANDORA_ENABLE_PHASE_TIMING; otherwise the
+     * recording sites compile to nothing. Read them with
+     * PandoraBoxAdapter::GetMetrics() or ForEachAdapterMetrics().
+     */
+    struct AdapterMetrics
+    {
+        std::atomic<uint64_t> snapshots{0};             // Snapshots taken
+        std::atomic<uint64_t> snapshot_bytes{0};        // Bytes copied into snapshots
+        std::atomic<uint64_t> hash_calls{0};            // Content hashes computed
+        std::atomic<uint64_t> items_the_same_calls{0};  // DiffCallback::AreItemsTheSame calls
+        std::atomic<uint64_t> contents_the_same_calls{0};
+        std::atomic<uint64_t> diffs{0};                 // DiffUtil::CalculateDiff runs
+        std::atomic<uint64_t> diff_d_total{0};          // Sum of the D-values (edit distances) of the diffs
+        std::atomic<uint64_t> diff_d_max{0};
+        std::atomic<uint64_t> updates_dispatched{0};    // ListUpdateCallback invocations
+
+        LatencyHistogram snapshot_latency;
+        LatencyHistogram diff_latency;
+        LatencyHistogram dispatch_latency;
+
+        LatencyHistogram& LatencyOf(Phase phase)
+        {
+            switch (phase)
+            {
+            case Phase::SNAPSHOT: return snapshot_latency;
+            case Phase::DIFF: return diff_latency;
+            default: return dispatch_latency;
+            }
+        }
+
+        void RecordSnapshot(uint64_t items, uint64_t bytes)
+        {
+            snapshots.fetch_add(1, std::memory_order_relaxed);
+            snapshot_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            hash_calls.fetch_add(items, std::memory_order_relaxed);
+        }
+
+        void RecordDiffCalls(uint64_t items_the_same, uint64_t contents_the_same)
+        {
+            items_the_same_calls.fetch_add(items_the_same, std::memory_order_relaxed);
+            contents_the_same_calls.fetch_add(contents_the_same, std::memory_order_relaxed);
+            hash_calls.fetch_add(contents_the_same, std::memory_order_relaxed);
+        }
+
+        void RecordDiff(uint64_t d_value)
+        {
+            diffs.fetch_add(1, std::memory_order_relaxed);
+            diff_d_total.fetch_add(d_value, std::memory_order_relaxed);
+            uint64_t max = diff_d_max.load(std::memory_order_relaxed);
+            while (d_value > max && !diff_d_max.compare_exchange_weak(max, d_value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        [[nodiscard]] std::string GetAlias() const
+        {
+            std::lock_guard<std::mutex> lock(alias_mutex_);
+            return alias_;
+        }
+
+        void SetAlias(const std::string& alias)
+        {
+            std::lock_guard<std::mutex> lock(alias_mutex_);
+            alias_ = alias;
+        }
+
+        void Reset()
+        {
+            for (auto* counter : {&snapshots, &snapshot_bytes, &hash_calls, &items_the_same_calls,
+                                  &contents_the_same_calls, &diffs, &diff_d_total, &diff_d_max,
+                                  &updates_dispatched})
+            {
+                counter->store(0, std::memory_order_relaxed);
+            }
+            snapshot_latency.Reset();
+            diff_latency.Reset();
+            dispatch_latency.Reset();
+        }
+
+    private:
+        mutable std::mutex alias_mutex_;
+        std::string alias_;
+    };
+
+    namespace detail
+    {
+        struct MetricsRegistry
+        {
+            std::mutex mutex;
+            std::vector<std::weak_ptr<AdapterMetrics>> entries;
+        };
+
+        inline MetricsRegistry& GetMetricsRegistry()
+        {
+            static MetricsRegistry registry;
+            return registry;
+        }
+
+        inline void RegisterAdapterMetrics(const std::shared_ptr<AdapterMetrics>& metrics)
+        {
+            MetricsRegistry& registry = GetMetricsRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.entries.push_back(metrics);
+        }
+    } // namespace detail
+
+    /**
+     * @brief Visit the metrics of every live adapter that recorded any, e.g. from a debug endpoint
+     *
+     * Adapters appear once they first record; destroyed adapters are dropped.
+     */
+    inline void ForEachAdapterMetrics(const std::function<void(const AdapterMetrics&)>& visitor)
+    {
+        std::vector<std::shared_ptr<AdapterMetrics>> live;
+        {
+            detail::MetricsRegistry& registry = detail::GetMetricsRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            auto& entries = registry.entries;
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                         [&live](const std::weak_ptr<AdapterMetrics>& entry)
+                                         {
+                                             auto metrics = entry.lock();
+                                             if (!metrics) return true;
+                                             live.push_back(std::move(metrics));
+                                             return false;
+                                         }),
+                          entries.end());
+        }
+        for (const auto& metrics : live)
+        {
+            visitor(*metrics);
+        }
+    }
+
+    /**
+     * @brief Forwards updates to another callback, counting them in metrics
+     */
+    class MetricsListUpdateCallback : public ListUpdateCallback
+    {
+    public:
+        MetricsListUpdateCallback(ListUpdateCallback* target, AdapterMetrics& metrics)
+            : target_(target), metrics_(metrics) {}
+
+        void OnInserted(int position, int count) override
+        {
+            Count();
+            target_->OnInserted(position, count);
+        }
+
+        void OnRemoved(int position, int count) override
+        {
+            Count();
+            target_->OnRemoved(position, count);
+        }
+
+        void OnMoved(int from_position, int to_position) override
+        {
+            Count();
+            target_->OnMoved(from_position, to_position);
+        }
+
+        void OnChanged(int position, int count, void* payload) override
+        {
+            Count();
+            target_->OnChanged(position, count, payload);
+        }
+
+        void OnChangedWithPayload(int position, int count, const Payload& payload) override
+        {
+            Count();
+            target_->OnChangedWithPayload(position, count, payload);
+        }
+
+        void OnUpdatesDispatched() override
+        {
+            target_->OnUpdatesDispatched();
+        }
+
+    private:
+        void Count() { metrics_.updates_dispatched.fetch_add(1, std::memory_order_relaxed); }
+
+        ListUpdateCallback* target_;
+        AdapterMetrics& metrics_;
+    };
+
+    /**
+     * @brief Records the duration of a scope into the latency histogram of a phase
+     */
+    class ScopedPhaseLatency
+    {
+    public:
+        ScopedPhaseLatency(AdapterMetrics& metrics, Phase phase)
+            : histogram_(metrics.LatencyOf(phase)), start_(std::chrono::steady_clock::now()) {}
+
+        ~ScopedPhaseLatency()
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            histogram_.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        ScopedPhaseLatency(const ScopedPhaseLatency&) = delete;
+        ScopedPhaseLatency& operator=(const ScopedPhaseLatency&) = delete;
+
+    private:
+        LatencyHistogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+} // namespace pandora
+
+#if defined(PANDORA_ENABLE_METRICS) && PANDORA_ENABLE_METRICS
+#define PANDORA_METRICS(...) __VA_ARGS__
+#define PANDORA_METRICS_PHASE(adapter, phase) \
+    ::pandora::ScopedPhaseLatency PANDORA_PHASE_CONCAT(pandora_phase_latency_, __LINE__)( \
+        (adapter)->GetOrCreateMetrics(), phase)
+#else
+#define PANDORA_METRICS(...) ((void)0)
+#define PANDORA_METRICS_PHASE(adapter, phase) ((void)0)
+#endif
+
+#endif  // PANDORA_METRICS_H_
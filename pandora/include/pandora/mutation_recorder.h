@@ -0,0 +1,189 @@
+#ifndef PANDORA_MUTATION_RECORDER_H_
+#define PANDORA_MUTATION_RECORDER_H_
+
+#include "pandora_box_adapter.h"
+#include "pandora_traits.h"
+#include "binary_io.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Operations of a mutation trace, see MutationRecorder
+     */
+    enum class MutationOp : uint8_t
+    {
+        ADD = 1,
+        ADD_AT,
+        ADD_ALL,
+        REMOVE,
+        REMOVE_AT,
+        REPLACE_AT,
+        SET_DATA,
+        CLEAR,
+        START_TRANSACTION,
+        END_TRANSACTION,
+        END_TRANSACTION_SILENTLY,
+    };
+
+    constexpr uint32_t kMutationTraceMagic = 0x52544D50;  // "PMTR"
+    constexpr uint64_t kMutationTraceVersion = 1;
+
+    /**
+     * @brief Records every mutation applied to an adapter tree into a compact binary trace
+     *
+     * The trace starts with the shape and contents of the tree, then holds one
+     * record per mutation: the operation, the time since the previous one, the
+     * path of group indices from the root to the mutated node, its position
+     * and its items. Items are stored as their id and content hash, so a trace
+     * holds no payloads; MutationReplayer rebuilds items from them.
+     *
+     * Mutations of RealDataSet leaves and transactions of any node are
+     * recorded, before they are applied. Changes to the shape of the tree are
+     * not, nor are mutations of other leaf types. Not thread safe, like the
+     * data sets themselves.
+     *
+     * Trace format, varints in LEB128 and signed ones zigzag encoded:
+     * @code
+     *   trace := fixed32 magic, varint version, node
+     *   node  := varint child_count, string alias,
+     *            (child_count > 0 ? node * child_count : varint size, item * size)
+     *   item  := varint id, fixed64 content_hash
+     *   record:= u8 op, varint delta_nanos, varint depth, varint group_index * depth,
+     *            [svarint position], [varint count], item *
+     * @endcode
+     *
+     * @tparam T The data type
+     */
+    template <typename T>
+    class MutationRecorder
+    {
+    public:
+        using IdOf = std::function<uint64_t(const T&)>;
+
+        /**
+         * @brief Snapshot root and record the mutations of its tree until Stop()
+         *
+         * @param id_of Stable identity of an item, the one its operator== compares
+         */
+        MutationRecorder(PandoraBoxAdapter<T>* root, IdOf id_of)
+            : root_(root), id_of_(std::move(id_of)), writer_(trace_)
+        {
+            writer_.WriteFixed32(kMutationTraceMagic);
+            writer_.WriteVarint(kMutationTraceVersion);
+            WriteNode(root_);
+            last_nanos_ = NowNanos();
+            root_->SetMutationRecorder(this);
+        }
+
+        ~MutationRecorder() { Stop(); }
+
+        MutationRecorder(const MutationRecorder&) = delete;
+        MutationRecorder& operator=(const MutationRecorder&) = delete;
+
+        void Stop()
+        {
+            if (root_)
+            {
+                root_->SetMutationRecorder(nullptr);
+                root_ = nullptr;
+            }
+        }
+
+        [[nodiscard]] bool IsRecording() const { return root_ != nullptr; }
+
+        [[nodiscard]] const std::vector<uint8_t>& GetTrace() const { return trace_; }
+
+        [[nodiscard]] size_t GetMutationCount() const { return mutation_count_; }
+
+        /**
+         * @brief Called by the data sets before applying a mutation to node
+         */
+        void Record(PandoraBoxAdapter<T>* node, MutationOp op, int position = 0,
+                    const T* items = nullptr, size_t count = 0)
+        {
+            const uint64_t now = NowNanos();
+            writer_.WriteU8(static_cast<uint8_t>(op));
+            writer_.WriteVarint(now - last_nanos_);
+            last_nanos_ = now;
+            WritePath(node);
+
+            if (HasPosition(op)) writer_.WriteSignedVarint(position);
+            if (HasItemList(op)) writer_.WriteVarint(count);
+            for (size_t i = 0; i < count; ++i) WriteItem(items[i]);
+            mutation_count_++;
+        }
+
+        static bool HasPosition(MutationOp op)
+        {
+            return op == MutationOp::ADD_AT || op == MutationOp::REMOVE_AT || op == MutationOp::REPLACE_AT;
+        }
+
+        static bool HasItemList(MutationOp op)
+        {
+            return op == MutationOp::ADD_ALL || op == MutationOp::SET_DATA;
+        }
+
+        static bool HasSingleItem(MutationOp op)
+        {
+            return op == MutationOp::ADD || op == MutationOp::ADD_AT || op == MutationOp::REMOVE ||
+                op == MutationOp::REPLACE_AT;
+        }
+
+    private:
+        static uint64_t NowNanos()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void WriteItem(const T& item)
+        {
+            writer_.WriteVarint(id_of_(item));
+            writer_.WriteFixed64(static_cast<uint64_t>(Pandora::Hash(item)));
+        }
+
+        void WriteNode(PandoraBoxAdapter<T>* node)
+        {
+            const int child_count = node->GetChildCount();
+            writer_.WriteVarint(static_cast<uint64_t>(child_count));
+            writer_.WriteString(node->GetAlias());
+            if (child_count > 0)
+            {
+                for (int i = 0; i < child_count; ++i) WriteNode(node->GetChild(i));
+                return;
+            }
+
+            const int size = node->GetDataCount();
+            writer_.WriteVarint(static_cast<uint64_t>(size));
+            for (int i = 0; i < size; ++i) WriteItem(*node->GetDataByIndex(i));
+        }
+
+        void WritePath(PandoraBoxAdapter<T>* node)
+        {
+            path_.clear();
+            for (; node != nullptr && node != root_; node = node->GetParent())
+            {
+                path_.push_back(node->GetGroupIndex());
+            }
+            writer_.WriteVarint(path_.size());
+            for (auto it = path_.rbegin(); it != path_.rend(); ++it)
+            {
+                writer_.WriteVarint(static_cast<uint64_t>(*it));
+            }
+        }
+
+        PandoraBoxAdapter<T>* root_;
+        IdOf id_of_;
+        std::vector<uint8_t> trace_;
+        BinaryWriter writer_;
+        std::vector<int> path_;
+        uint64_t last_nanos_ = 0;
+        size_t mutation_count_ = 0;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_MUTATION_RECORDER_H_
@@ -0,0 +1,216 @@
+#ifndef PANDORA_MUTATION_REPLAY_H_
+#define PANDORA_MUTATION_REPLAY_H_
+
+#include "mutation_recorder.h"
+#include "real_data_set.h"
+#include "wrapper_data_set.h"
+#include "metrics.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Outcome of MutationReplayer::Replay
+     */
+    struct ReplayStats
+    {
+        uint64_t mutations = 0;
+        uint64_t replay_nanos = 0;    // Time spent in the replayed mutations
+        uint64_t recorded_nanos = 0;  // Time between the first and the last recorded mutation
+
+        [[nodiscard]] double GetMutationsPerSecond() const
+        {
+            return replay_nanos == 0 ? 0.0 : static_cast<double>(mutations) * 1e9 / static_cast<double>(replay_nanos);
+        }
+    };
+
+    /**
+     * @brief Re-executes a trace of MutationRecorder against a freshly built tree
+     *
+     * The leaves of the tree come from a factory, so the same trace can be
+     * replayed against any storage or data set configuration. Mutations run
+     * back to back; the recorded pacing is only reported.
+     *
+     * @tparam T The data type
+     */
+    template <typename T>
+    class MutationReplayer
+    {
+    public:
+        /// Rebuilds an item from its recorded id and content hash
+        using MakeItem = std::function<T(uint64_t id, uint64_t content_hash)>;
+        using MakeLeaf = std::function<std::unique_ptr<PandoraBoxAdapter<T>>()>;
+
+        /**
+         * @throws PandoraException if trace is not a mutation trace or is truncated
+         */
+        MutationReplayer(std::vector<uint8_t> trace, MakeItem make_item)
+            : trace_(std::move(trace)), make_item_(std::move(make_item))
+        {
+            BinaryReader reader(trace_);
+            if (reader.ReadFixed32() != kMutationTraceMagic)
+            {
+                throw PandoraException("MutationReplayer: not a mutation trace");
+            }
+            const uint64_t version = reader.ReadVarint();
+            if (version != kMutationTraceVersion)
+            {
+                throw PandoraException("MutationReplayer: unsupported trace version " + std::to_string(version));
+            }
+            root_ = ReadNode(reader);
+            records_offset_ = reader.GetPosition();
+        }
+
+        /**
+         * @brief Build the tree as it was when recording started
+         *
+         * @param make_leaf Creates every leaf, RealDataSet<T> by default
+         */
+        std::unique_ptr<PandoraBoxAdapter<T>> BuildTree(const MakeLeaf& make_leaf = nullptr) const
+        {
+            return BuildNode(root_, make_leaf ? make_leaf : MakeLeaf([]
+            {
+                return std::unique_ptr<PandoraBoxAdapter<T>>(new RealDataSet<T>());
+            }));
+        }
+
+        /**
+         * @brief Apply the recorded mutations to root, a tree built by BuildTree()
+         *
+         * @param latency Receives the duration of every mutation if not null
+         * @throws PandoraException if the trace is malformed or does not match root
+         */
+        ReplayStats Replay(PandoraBoxAdapter<T>& root, LatencyHistogram* latency = nullptr) const
+        {
+            ReplayStats stats;
+            BinaryReader reader(trace_.data() + records_offset_, trace_.size() - records_offset_);
+            std::vector<T> items;
+            bool first = true;
+            while (!reader.AtEnd())
+            {
+                const auto op = static_cast<MutationOp>(reader.ReadU8());
+                const uint64_t delta_nanos = reader.ReadVarint();
+                if (!first) stats.recorded_nanos += delta_nanos;
+                first = false;
+
+                PandoraBoxAdapter<T>* node = &root;
+                const uint64_t depth = reader.ReadVarint();
+                for (uint64_t i = 0; i < depth; ++i)
+                {
+                    node = node->GetChild(static_cast<int>(reader.ReadVarint()));
+                    if (node == nullptr)
+                    {
+                        throw PandoraException("MutationReplayer: trace does not match the tree");
+                    }
+                }
+
+                const int position = MutationRecorder<T>::HasPosition(op)
+                    ? static_cast<int>(reader.ReadSignedVarint()) : 0;
+                uint64_t count = MutationRecorder<T>::HasSingleItem(op) ? 1 : 0;
+                if (MutationRecorder<T>::HasItemList(op)) count = reader.ReadVarint();
+                items.clear();
+                for (uint64_t i = 0; i < count; ++i) items.push_back(ReadItem(reader));
+
+                const auto start = std::chrono::steady_clock::now();
+                Apply(*node, op, position, items);
+                const auto nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+
+                stats.mutations++;
+                stats.replay_nanos += nanos;
+                if (latency) latency->Record(nanos);
+            }
+            return stats;
+        }
+
+    private:
+        struct RecordedNode
+        {
+            std::string alias;
+            std::vector<RecordedNode> children;
+            std::vector<std::pair<uint64_t, uint64_t>> items;  // id, content hash
+        };
+
+        static RecordedNode ReadNode(BinaryReader& reader)
+        {
+            RecordedNode node;
+            const uint64_t child_count = reader.ReadVarint();
+            node.alias = reader.ReadString();
+            if (child_count > 0)
+            {
+                for (uint64_t i = 0; i < child_count; ++i) node.children.push_back(ReadNode(reader));
+                return node;
+            }
+
+            const uint64_t size = reader.ReadVarint();
+            for (uint64_t i = 0; i < size; ++i)
+            {
+                const uint64_t id = reader.ReadVarint();
+                node.items.emplace_back(id, reader.ReadFixed64());
+            }
+            return node;
+        }
+
+        std::unique_ptr<PandoraBoxAdapter<T>> BuildNode(const RecordedNode& recorded, const MakeLeaf& make_leaf) const
+        {
+            std::unique_ptr<PandoraBoxAdapter<T>> node;
+            if (recorded.children.empty())
+            {
+                node = make_leaf();
+                std::vector<T> items;
+                items.reserve(recorded.items.size());
+                for (const auto& item : recorded.items) items.push_back(make_item_(item.first, item.second));
+                node->SetData(items);
+            }
+            else
+            {
+                node = std::make_unique<WrapperDataSet<T>>();
+            }
+            if (!recorded.alias.empty()) node->SetAlias(recorded.alias);
+            for (const auto& child : recorded.children)
+            {
+                node->AddChild(BuildNode(child, make_leaf));
+            }
+            return node;
+        }
+
+        T ReadItem(BinaryReader& reader) const
+        {
+            const uint64_t id = reader.ReadVarint();
+            return make_item_(id, reader.ReadFixed64());
+        }
+
+        static void Apply(PandoraBoxAdapter<T>& node, MutationOp op, int position, const std::vector<T>& items)
+        {
+            switch (op)
+            {
+            case MutationOp::ADD: node.Add(items[0]); break;
+            case MutationOp::ADD_AT: node.Add(position, items[0]); break;
+            case MutationOp::ADD_ALL: node.AddAll(items); break;
+            case MutationOp::REMOVE: node.Remove(items[0]); break;
+            case MutationOp::REMOVE_AT: node.RemoveAtPos(position); break;
+            case MutationOp::REPLACE_AT: node.ReplaceAtPosIfExist(position, items[0]); break;
+            case MutationOp::SET_DATA: node.SetData(items); break;
+            case MutationOp::CLEAR: node.ClearAllData(); break;
+            case MutationOp::START_TRANSACTION: node.StartTransaction(); break;
+            case MutationOp::END_TRANSACTION: node.EndTransaction(); break;
+            case MutationOp::END_TRANSACTION_SILENTLY: node.EndTransactionSilently(); break;
+            default:
+                throw PandoraException("MutationReplayer: unknown operation " +
+                    std::to_string(static_cast<int>(op)));
+            }
+        }
+
+        std::vector<uint8_t> trace_;
+        MakeItem make_item_;
+        RecordedNode root_;
+        size_t records_offset_ = 0;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_MUTATION_REPLAY_H_
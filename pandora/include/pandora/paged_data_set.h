@@ -0,0 +1,613 @@
+#ifndef PANDORA_PAGED_DATA_SET_H_
+#define PANDORA_PAGED_DATA_SET_H_
+
+#include "pandora_box_adapter.h"
+#include "pandora_traits.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Supplies the pages of a PagedDataSet
+     *
+     * LoadPage() starts loading and returns; the result is delivered later
+     * through PagedDataSet::OnPageLoaded() or OnPageLoadFailed(), on the thread
+     * that uses the data set.
+     */
+    template <typename T>
+    class PageSource
+    {
+    public:
+        virtual ~PageSource() = default;
+
+        /**
+         * @param page_index The page to load
+         * @param start The data index of the first item of the page
+         * @param count The number of items the page holds
+         */
+        virtual void LoadPage(int page_index, int start, int count) = 0;
+    };
+
+    /**
+     * @brief Lazily loaded data set of known size, kept within a memory budget
+     *
+     * Items of pages that are not loaded read as a placeholder. Every read asks
+     * the PageSource for the pages within the prefetch distance of the index;
+     * each arriving page is reported as OnChanged for its range. When the loaded
+     * pages exceed the memory budget the least recently used ones are dropped,
+     * reported as OnChanged again, and reloaded on demand.
+     *
+     * The list is owned by the server: structural mutations (Add, Remove, ...)
+     * are not supported and only log a warning. Use SetTotalCount() and
+     * Invalidate() to follow remote changes; ReplaceAtPosIfExist() edits a
+     * loaded item locally.
+     *
+     * @tparam T The data type
+     *
+     * Example:
+     * @code
+     * PagedDataSet<Row> rows(&source, PagedDataSet<Row>::Config{50, 100, 8 << 20});
+     * rows.SetTotalCount(server_count);
+     * // In PageSource::LoadPage, once the response is back on the UI thread:
+     * rows.OnPageLoaded(page_index, std::move(page_rows));
+     * @endcode
+     *
+     * @note Not thread-safe. Reads triggered by the data set's own
+     *       notifications, or by a parent adapter reacting to them, do not
+     *       request pages.
+     */
+    template <typename T>
+    class PagedDataSet final : public PandoraBoxAdapter<T>
+    {
+    public:
+        using SizeEstimator = std::function<size_t(const T&)>;
+
+        struct Config
+        {
+            int page_size = 50;
+            int prefetch_distance = 100;             // Items around an accessed index to keep loaded
+            size_t memory_budget = 16 * 1024 * 1024; // Bytes of loaded items, as estimated
+        };
+
+        /**
+         * @param source The page source; must outlive the data set
+         * @param config Paging configuration
+         * @param placeholder Value read for items that are not loaded
+         * @param size_estimator Memory footprint of an item, sizeof(T) by default
+         */
+        explicit PagedDataSet(PageSource<T>* source, Config config = Config(), T placeholder = T(),
+                              SizeEstimator size_estimator = nullptr)
+            : source_(source), config_(config), placeholder_(std::move(placeholder)),
+              size_estimator_(std::move(size_estimator))
+        {
+            if (!source_)
+            {
+                throw PandoraException("PagedDataSet: source cannot be null");
+            }
+            if (config_.page_size <= 0)
+            {
+                throw PandoraException("PagedDataSet: page size must be positive");
+            }
+            config_.prefetch_distance = std::max(0, config_.prefetch_distance);
+        }
+
+        [[nodiscard]] int GetDataCount() const override { return total_count_; }
+
+        /**
+         * @brief Get the item at index, or the placeholder while its page is loading
+         *
+         * Requests the pages within the prefetch distance that are not loaded yet.
+         */
+        T* GetDataByIndex(int index) override
+        {
+            if (index < 0 || index >= total_count_) return nullptr;
+
+            const int page_index = index / config_.page_size;
+            if (suppress_loads_ == 0)
+            {
+                RequestPages(index);
+            }
+
+            auto it = pages_.find(page_index);
+            if (it == pages_.end())
+            {
+                return &placeholder_;
+            }
+            Touch(it->second);
+            return &it->second.items[index - page_index * config_.page_size];
+        }
+
+        [[nodiscard]] bool IsLoaded(int index) const
+        {
+            return index >= 0 && index < total_count_ && pages_.count(index / config_.page_size) != 0;
+        }
+
+        [[nodiscard]] bool IsPlaceholder(const T* item) const { return item == &placeholder_; }
+
+        [[nodiscard]] int GetLoadedPageCount() const { return static_cast<int>(pages_.size()); }
+
+        [[nodiscard]] size_t GetLoadedBytes() const { return loaded_bytes_; }
+
+        [[nodiscard]] const Config& GetConfig() const { return config_; }
+
+        /**
+         * @brief Set the number of items on the server
+         *
+         * Growth is reported as inserted placeholders at the end, shrinking as a
+         * removal; pages beyond the new end are dropped.
+         */
+        void SetTotalCount(int total_count)
+        {
+            total_count = std::max(0, total_count);
+            if (total_count == total_count_) return;
+
+            const int old_count = total_count_;
+            BeginChange();
+            total_count_ = total_count;
+            DropPagesFrom(total_count);
+            EndChange([old_count, total_count](ListUpdateCallback* callback)
+            {
+                if (total_count > old_count) callback->OnInserted(old_count, total_count - old_count);
+                else callback->OnRemoved(total_count, old_count - total_count);
+            });
+        }
+
+        /**
+         * @brief Drop every loaded page, e.g. after the server data changed
+         */
+        void Invalidate()
+        {
+            requested_.clear();
+            if (pages_.empty()) return;
+            const int count = total_count_;
+            BeginChange();
+            DropPagesFrom(0);
+            EndChange([count](ListUpdateCallback* callback) { callback->OnChanged(0, count, nullptr); });
+        }
+
+        /**
+         * @brief Deliver a page requested through PageSource::LoadPage
+         */
+        void OnPageLoaded(int page_index, std::vector<T> items)
+        {
+            requested_.erase(page_index);
+            const int start = page_index * config_.page_size;
+            const int expected = std::min(config_.page_size, total_count_ - start);
+            if (page_index < 0 || expected <= 0)
+            {
+                Log(Logger::WARN, "page " + std::to_string(page_index) + " is out of range, dropped");
+                return;
+            }
+            if (static_cast<int>(items.size()) != expected)
+            {
+                Log(Logger::WARN, "page " + std::to_string(page_index) + " has " + std::to_string(items.size()) +
+                    " items, expected " + std::to_string(expected));
+                items.resize(expected, placeholder_);
+            }
+
+            BeginChange();
+            DropPage(page_index);
+            Page& page = pages_[page_index];
+            page.items = std::move(items);
+            page.bytes = EstimateBytes(page.items);
+            lru_.push_front(page_index);
+            page.lru_position = lru_.begin();
+            loaded_bytes_ += page.bytes;
+            std::vector<int> evicted = EvictOverBudget(page_index);
+            EndChange([this, start, expected, &evicted](ListUpdateCallback* callback)
+            {
+                callback->OnChanged(start, expected, nullptr);
+                for (int evicted_page : evicted)
+                {
+                    const int evicted_start = evicted_page * config_.page_size;
+                    callback->OnChanged(evicted_start, PageLength(evicted_page), nullptr);
+                }
+            });
+        }
+
+        /**
+         * @brief Report a failed load; the page will be requested again when accessed
+         */
+        void OnPageLoadFailed(int page_index)
+        {
+            requested_.erase(page_index);
+        }
+
+        // DataAdapter mutations: the list is owned by the page source
+
+        void ClearAllData() override
+        {
+            SetTotalCount(0);
+        }
+
+        void Add(const T& item) override { Unsupported("Add"); }
+
+        void Add(int pos, const T& item) override { Unsupported("Add at position"); }
+
+        void AddAll(const std::vector<T>& collection) override { Unsupported("AddAll"); }
+
+        void Remove(const T& item) override { Unsupported("Remove"); }
+
+        void RemoveAtPos(int position) override { Unsupported("RemoveAtPos"); }
+
+        void SetData(const std::vector<T>& collection) override { Unsupported("SetData"); }
+
+        /**
+         * @brief Replace a loaded item locally; unloaded items cannot be replaced
+         */
+        bool ReplaceAtPosIfExist(int position, const T& item) override
+        {
+            if (position < 0 || position >= total_count_) return false;
+            auto it = pages_.find(position / config_.page_size);
+            if (it == pages_.end()) return false;
+
+            BeginChange();
+            T& target = it->second.items[position - it->first * config_.page_size];
+            loaded_bytes_ -= EstimateBytes(target);
+            it->second.bytes -= EstimateBytes(target);
+            target = item;
+            loaded_bytes_ += EstimateBytes(target);
+            it->second.bytes += EstimateBytes(target);
+            EndChange([position](ListUpdateCallback* callback) { callback->OnChanged(position, 1, nullptr); });
+            return true;
+        }
+
+        /**
+         * @brief Index of item among the loaded pages, or -1
+         */
+        int IndexOf(const T& item) const override
+        {
+            int result = -1;
+            for (const auto& entry : pages_)
+            {
+                const auto& items = entry.second.items;
+                for (size_t i = 0; i < items.size(); ++i)
+                {
+                    if (Pandora::Equals(items[i], item))
+                    {
+                        const int index = entry.first * config_.page_size + static_cast<int>(i);
+                        if (result < 0 || index < result) result = index;
+                        break;
+                    }
+                }
+            }
+            return result;
+        }
+
+        // Node interface implementation
+        [[nodiscard]] int GetGroupIndex() const override { return group_index_; }
+        void SetGroupIndex(int group_index) override { group_index_ = group_index; }
+
+        void AddChild(std::unique_ptr<PandoraBoxAdapter<T>> sub) override
+        {
+            throw PandoraException("PagedDataSet does not support AddChild");
+        }
+
+        [[nodiscard]] bool HasBindToParent() const override { return parent_ != nullptr; }
+
+        void RemoveFromOriginalParent() override
+        {
+            if (parent_)
+            {
+                parent_->RemoveChild(this);
+                parent_ = nullptr;
+            }
+        }
+
+        void RemoveChild(PandoraBoxAdapter<T>* sub) override
+        {
+            throw PandoraException("PagedDataSet does not support RemoveChild");
+        }
+
+        [[nodiscard]] int GetStartIndex() const override { return start_index_; }
+        void SetStartIndex(const int start_index) override { start_index_ = start_index; }
+
+        PandoraBoxAdapter<T>* RetrieveAdapterByDataIndex(const int index) override
+        {
+            if (0 <= index && index < GetDataCount())
+                return this;
+            return nullptr;
+        }
+
+        std::pair<PandoraBoxAdapter<T>*, int> RetrieveAdapterByDataIndex2(int index) override
+        {
+            auto temp = RetrieveAdapterByDataIndex(index);
+            if (temp == nullptr)
+                return {nullptr, -1};
+
+            return {temp, index};
+        }
+
+        void NotifyHasAddToParent(PandoraBoxAdapter<T>* parent) override
+        {
+            parent_ = parent;
+        }
+
+        void NotifyHasRemoveFromParent() override
+        {
+            parent_ = nullptr;
+        }
+
+        PandoraBoxAdapter<T>* GetParent() override { return parent_; }
+
+        PandoraBoxAdapter<T>* FindByAlias(const std::string& target_alias) override
+        {
+            if (target_alias.empty()) return nullptr;
+            if (this->GetAlias() == target_alias) return this;
+            return nullptr;
+        }
+
+        bool IsAliasConflict(const std::string& alias) override
+        {
+            return this->GetAlias() == alias;
+        }
+
+        // Transactions only defer the notifications: changes come from the page
+        // source and cannot be rolled back. The count change and the range of
+        // changed items are collected and reported when the transaction ends.
+        void StartTransaction() override
+        {
+            if (!use_transaction_)
+            {
+                transaction_start_count_ = total_count_;
+                pending_updates_.Clear();
+            }
+            use_transaction_ = true;
+        }
+
+        void EndTransaction() override
+        {
+            use_transaction_ = false;
+            const int old_count = transaction_start_count_;
+            const int new_count = total_count_;
+            const int dirty_start = pending_updates_.start;
+            const int dirty_end = std::min(pending_updates_.end, std::min(old_count, new_count));
+            pending_updates_.Clear();
+            if (IsParentInTransaction()) return;
+
+            auto callback = PandoraBoxAdapter<T>::GetListUpdateCallback();
+            if (!callback || (old_count == new_count && dirty_start >= dirty_end)) return;
+            ++suppress_loads_;
+            if (new_count > old_count) callback->OnInserted(old_count, new_count - old_count);
+            else if (new_count < old_count) callback->OnRemoved(new_count, old_count - new_count);
+            if (dirty_start < dirty_end) callback->OnChanged(dirty_start, dirty_end - dirty_start, nullptr);
+            callback->OnUpdatesDispatched();
+            --suppress_loads_;
+        }
+
+        void EndTransactionSilently() override
+        {
+            use_transaction_ = false;
+            pending_updates_.Clear();
+        }
+
+        [[nodiscard]] bool InTransaction() const override
+        {
+            return use_transaction_ || IsParentInTransaction();
+        }
+
+    protected:
+        void OnBeforeChanged() override
+        {
+            BeginChange();
+        }
+
+        void RebuildSubNodes() override
+        {
+        }
+
+        void OnAfterChanged() override
+        {
+            EndChange([](ListUpdateCallback*) {});
+        }
+
+        void Restore() override
+        {
+            Log(Logger::WARN, "restore is not supported");
+        }
+
+    private:
+        struct Page
+        {
+            std::vector<T> items;
+            size_t bytes = 0;
+            std::list<int>::iterator lru_position;
+        };
+
+        // Parent hooks read our items; keep those reads from requesting pages
+        void BeginChange()
+        {
+            ++suppress_loads_;
+            if (parent_)
+            {
+                parent_->OnBeforeChanged();
+            }
+            --suppress_loads_;
+        }
+
+        template <typename Dispatch>
+        void EndChange(const Dispatch& dispatch)
+        {
+            ++suppress_loads_;
+            if (parent_)
+            {
+                parent_->OnAfterChanged();
+            }
+            if (use_transaction_)
+            {
+                dispatch(&pending_updates_);
+            }
+            else if (!IsParentInTransaction())
+            {
+                if (auto callback = PandoraBoxAdapter<T>::GetListUpdateCallback())
+                {
+                    dispatch(callback);
+                    callback->OnUpdatesDispatched();
+                }
+            }
+            --suppress_loads_;
+        }
+
+        // Collects the changed range of a transaction; count changes are
+        // derived from the count at its start
+        class PendingUpdates final : public ListUpdateCallback
+        {
+        public:
+            void OnInserted(int position, int count) override {}
+
+            void OnRemoved(int position, int count) override {}
+
+            void OnMoved(int from_position, int to_position) override {}
+
+            void OnChanged(int position, int count, void* payload) override
+            {
+                if (count <= 0) return;
+                start = std::min(start, position);
+                end = std::max(end, position + count);
+            }
+
+            void Clear()
+            {
+                start = std::numeric_limits<int>::max();
+                end = 0;
+            }
+
+            int start = std::numeric_limits<int>::max();
+            int end = 0;
+        };
+
+        void RequestPages(int index)
+        {
+            const int first = std::max(0, index - config_.prefetch_distance) / config_.page_size;
+            const int last = std::min(total_count_ - 1, index + config_.prefetch_distance) / config_.page_size;
+            const int center = index / config_.page_size;
+
+            // Nearest pages first, the accessed one before all others
+            for (int distance = 0; center - distance >= first || center + distance <= last; ++distance)
+            {
+                if (center + distance <= last) Request(center + distance);
+                if (distance > 0 && center - distance >= first) Request(center - distance);
+            }
+        }
+
+        void Request(int page_index)
+        {
+            if (pages_.count(page_index) != 0 || !requested_.insert(page_index).second) return;
+            source_->LoadPage(page_index, page_index * config_.page_size, PageLength(page_index));
+        }
+
+        int PageLength(int page_index) const
+        {
+            return std::max(0, std::min(config_.page_size, total_count_ - page_index * config_.page_size));
+        }
+
+        void Touch(Page& page)
+        {
+            if (page.lru_position != lru_.begin())
+            {
+                lru_.splice(lru_.begin(), lru_, page.lru_position);
+            }
+        }
+
+        // Evict least recently used pages until within budget, never the one just loaded
+        std::vector<int> EvictOverBudget(int keep_page)
+        {
+            std::vector<int> evicted;
+            while (loaded_bytes_ > config_.memory_budget && pages_.size() > 1)
+            {
+                const int victim = lru_.back();
+                if (victim == keep_page) break;
+                DropPage(victim);
+                evicted.push_back(victim);
+            }
+            return evicted;
+        }
+
+        void DropPage(int page_index)
+        {
+            auto it = pages_.find(page_index);
+            if (it == pages_.end()) return;
+            loaded_bytes_ -= it->second.bytes;
+            lru_.erase(it->second.lru_position);
+            pages_.erase(it);
+        }
+
+        void DropPagesFrom(int first_index)
+        {
+            std::vector<int> dropped;
+            for (const auto& entry : pages_)
+            {
+                if (entry.first * config_.page_size + static_cast<int>(entry.second.items.size()) > first_index)
+                {
+                    dropped.push_back(entry.first);
+                }
+            }
+            for (int page_index : dropped)
+            {
+                DropPage(page_index);
+            }
+            for (auto it = requested_.begin(); it != requested_.end();)
+            {
+                it = PageLength(*it) == 0 ? requested_.erase(it) : std::next(it);
+            }
+        }
+
+        size_t EstimateBytes(const T& item) const
+        {
+            return size_estimator_ ? size_estimator_(item) : sizeof(T);
+        }
+
+        size_t EstimateBytes(const std::vector<T>& items) const
+        {
+            if (!size_estimator_) return items.size() * sizeof(T);
+            size_t bytes = 0;
+            for (const auto& item : items) bytes += size_estimator_(item);
+            return bytes;
+        }
+
+        void Unsupported(const char* operation) const
+        {
+            Log(Logger::WARN, std::string(operation) + ": PagedDataSet does not support this operation");
+        }
+
+        [[nodiscard]] bool IsParentInTransaction() const
+        {
+            return parent_ != nullptr && parent_->InTransaction();
+        }
+
+        void Log(const Logger::Level level, const std::string& message) const
+        {
+            Logger::Println(level, "PagedDataSet", message);
+        }
+
+        PageSource<T>* source_;
+        Config config_;
+        T placeholder_;
+        SizeEstimator size_estimator_;
+
+        int total_count_ = 0;
+        std::unordered_map<int, Page> pages_;
+        std::list<int> lru_;  // Loaded page indices, most recently used first
+        std::unordered_set<int> requested_;
+        size_t loaded_bytes_ = 0;
+        int suppress_loads_ = 0;
+
+        bool use_transaction_ = false;
+        int transaction_start_count_ = 0;
+        PendingUpdates pending_updates_;
+        int group_index_ = Node<PandoraBoxAdapter<T>>::kNoGroupIndex;
+        int start_index_ = 0;
+        PandoraBoxAdapter<T>* parent_ = nullptr;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_PAGED_DATA_SET_H_
@@ -5,6 +5,7 @@
 #include "data_adapter.h"
 #include "pandora_exception.h"
 #include "logger.h"
+#include "metrics.h"
 #include <string>
 #include <functional>
 
@@ -12,6 +13,9 @@
 
 namespace pandora
 {
+    template <typename T>
+    class MutationRecorder;
+
     template <typename T>
     class PandoraBoxAdapter : public Node<PandoraBoxAdapter<T>>, public DataAdapter<T>
     {
@@ -69,9 +73,13 @@ namespace pandora
                 throw PandoraException("Alias conflict: " + alias);
             }
             alias_ = alias;
+            if (metrics_)
+            {
+                metrics_->SetAlias(alias);
+            }
         }
 
-        [[nodiscard]] std::string GetAlias() const { return alias_; }
+        [[nodiscard]] const std::string& GetAlias() const { return alias_; }
 
         // Find adapter by alias in this tree
         virtual PandoraBoxAdapter<T>* FindByAlias(const std::string& target_alias) = 0;
@@ -94,6 +102,10 @@ namespace pandora
         // Get parent adapter
         virtual PandoraBoxAdapter<T>* GetParent() = 0;
 
+        // Child adapters, none for leaves
+        [[nodiscard]] virtual int GetChildCount() const { return 0; }
+        virtual PandoraBoxAdapter<T>* GetChild(int /*index*/) { return nullptr; }
+
         // Transaction support
         virtual void StartTransaction() = 0;
         virtual void EndTransaction() = 0;
@@ -117,9 +129,54 @@ namespace pandora
             listUpdateCallback = std::move(list_update_callback);
         }
 
+        /// Release the callback, e.g. to chain it behind another one
+        std::unique_ptr<ListUpdateCallback> TakeListUpdateCallback()
+        {
+            return std::move(listUpdateCallback);
+        }
+
+        /**
+         * @brief Cost counters of this adapter
+         *
+         * @return nullptr unless built with PANDORA_ENABLE_METRICS and something was recorded
+         */
+        [[nodiscard]] const AdapterMetrics* GetMetrics() const { return metrics_.get(); }
+
+        void ResetMetrics()
+        {
+            if (metrics_) metrics_->Reset();
+        }
+
+        /// Used by the instrumentation macros; registers the metrics on first use
+        AdapterMetrics& GetOrCreateMetrics()
+        {
+            if (!metrics_)
+            {
+                metrics_ = std::make_shared<AdapterMetrics>();
+                metrics_->SetAlias(alias_);
+                detail::RegisterAdapterMetrics(metrics_);
+            }
+            return *metrics_;
+        }
+
+        /// Attach a recorder to the tree rooted here, or detach it with nullptr
+        void SetMutationRecorder(MutationRecorder<T>* recorder) { mutation_recorder_ = recorder; }
+
+        /// The recorder of this adapter or of its nearest ancestor having one
+        MutationRecorder<T>* FindMutationRecorder()
+        {
+            for (PandoraBoxAdapter<T>* node = this; node != nullptr; node = node->GetParent())
+            {
+                if (node->mutation_recorder_) return node->mutation_recorder_;
+            }
+            return nullptr;
+        }
+
     private:
         std::string alias_;
         std::unique_ptr<ListUpdateCallback> listUpdateCallback;
+        std::shared_ptr<AdapterMetrics> metrics_;
+        MutationRecorder<T>* mutation_recorder_ = nullptr;
     };
 } // namespace pandora
 
@@ -30,6 +30,8 @@
 #include "rv/i_view_holder.h"
 #include "rv/view_holder_creator.h"
 #include "rv/data_observer.h"
+#include "rv/viewport.h"
+#include "rv/bind_scheduler.h"
 
 // Type system
 #include "rv/type_cell.h"
@@ -40,10 +42,12 @@
 #include "rv/pandora_data_set.h"
 #include "rv/pandora_real_rv_data_set.h"
 #include "rv/pandora_wrapper_rv_data_set.h"
+#include "rv/variant_data_set.h"
 
 // Reactive support
 #include "rv/reactive_data.h"
 #include "rv/i_reactive_view_holder.h"
+#include "rv/batched_reactive_data.h"
 
 /**
  * @namespace pandora::rv
@@ -2,8 +2,12 @@
 #define PANDORA_TRAITS_H_
 
 #include <cstddef>
+#include <cstring>
 #include <type_traits>
 #include <functional>
+#include <variant>
+
+#include "fast_hash.h"
 
 namespace pandora {
 
@@ -34,6 +38,50 @@ struct HasEqualOperator : std::false_type {};
 template <typename T>
 struct HasEqualOperator<T, std::void_t<decltype(std::declval<T>() == std::declval<T>())>> : std::true_type {};
 
+/**
+ * Type trait to check if a type is a std::variant
+ */
+template <typename T>
+struct IsVariant : std::false_type {};
+
+template <typename... Ts>
+struct IsVariant<std::variant<Ts...>> : std::true_type {};
+
+/**
+ * Type trait for types hashed by their raw bytes: trivially copyable, without
+ * padding or floating point members (so equal values have equal bytes), and
+ * not already covered by a Hash() member or another specialization
+ */
+template <typename T>
+struct IsBytewiseHashable
+    : std::bool_constant<std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T> &&
+                         !std::is_fundamental_v<T> && !std::is_pointer_v<T> && !HasHashMethod<T>::value &&
+                         !IsVariant<T>::value> {};
+
+/**
+ * Opt-in for bytewise equality of a type whose operator== compares every
+ * member, so ContentEquals can use memcmp instead. Specialize as
+ *
+ * template<>
+ * struct pandora::UseBytewiseEquals<MyRow> : std::true_type {};
+ *
+ * Leave it off when operator== compares an id only, as AreItemsTheSame does.
+ */
+template <typename T>
+struct UseBytewiseEquals : std::false_type {};
+
+/**
+ * Type trait for types compared by their raw bytes: integral types, enums and
+ * trivially copyable types without padding or floating point members that
+ * either have no operator== or opt in through UseBytewiseEquals
+ */
+template <typename T>
+struct IsBytewiseComparable
+    : std::bool_constant<std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T> &&
+                         !std::is_pointer_v<T> && !IsVariant<T>::value &&
+                         (std::is_integral_v<T> || std::is_enum_v<T> || !HasEqualOperator<T>::value ||
+                          UseBytewiseEquals<T>::value)> {};
+
 /**
  * Helper trait for dependent false in static_assert
  */
@@ -100,6 +148,33 @@ struct ContentHasher<T, std::enable_if_t<std::is_fundamental_v<T>>> {
     }
 };
 
+/**
+ * Specialization for trivially copyable types without padding, e.g. enums and
+ * plain rows of integers - hashes the object representation with wyhash
+ */
+template <typename T>
+struct ContentHasher<T, std::enable_if_t<IsBytewiseHashable<T>::value>> {
+    size_t operator()(const T& obj) const {
+        return static_cast<size_t>(fast_hash::HashBytes(&obj, sizeof(T)));
+    }
+};
+
+/**
+ * Specialization for std::variant - hashes the active index and alternative
+ */
+template <typename... Ts>
+struct ContentHasher<std::variant<Ts...>> {
+    size_t operator()(const std::variant<Ts...>& obj) const {
+        size_t seed = obj.index();
+        if (!obj.valueless_by_exception()) {
+            std::visit([&seed](const auto& value) {
+                HashCombine(seed, ContentHasher<std::decay_t<decltype(value)>>{}(value));
+            }, obj);
+        }
+        return seed;
+    }
+};
+
 /**
  * Equality comparator for Pandora types
  * Users can specialize this template for custom types
@@ -116,6 +191,16 @@ struct ContentEquals {
     }
 };
 
+/**
+ * Specialization for bytewise comparable types - a single memcmp
+ */
+template <typename T>
+struct ContentEquals<T, std::enable_if_t<IsBytewiseComparable<T>::value>> {
+    bool operator()(const T& lhs, const T& rhs) const {
+        return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+    }
+};
+
 /**
  * Specialization for pointer types
  */
@@ -141,6 +226,20 @@ size_t Hash(const T& obj) {
     return ContentHasher<T>{}(obj);
 }
 
+/**
+ * Hash count contiguous items into hashes[0, count)
+ *
+ * Iterations are independent, so the multiplications of consecutive bytewise
+ * hashes overlap in the pipeline; Snapshot() hashes through this in one pass.
+ */
+template <typename T>
+void HashRange(const T* items, size_t count, size_t* hashes) {
+    const ContentHasher<T> hasher{};
+    for (size_t i = 0; i < count; ++i) {
+        hashes[i] = hasher(items[i]);
+    }
+}
+
 /**
  * Check equality for any type
  */
@@ -149,6 +248,49 @@ bool Equals(const T& lhs, const T& rhs) {
     return ContentEquals<T>{}(lhs, rhs);
 }
 
+/**
+ * Length of the common prefix of lhs[0, count) and rhs[0, count), i.e. the
+ * position of the first pair that is not Equals, or count
+ *
+ * Bytewise comparable items are compared a block at a time with memcmp.
+ */
+template <typename T>
+size_t MismatchLength(const T* lhs, const T* rhs, size_t count) {
+    size_t i = 0;
+    if constexpr (IsBytewiseComparable<T>::value) {
+        constexpr size_t kBlock = sizeof(T) >= 256 ? 1 : 256 / sizeof(T);
+        while (i + kBlock <= count && std::memcmp(lhs + i, rhs + i, kBlock * sizeof(T)) == 0) {
+            i += kBlock;
+        }
+    }
+    const ContentEquals<T> equals{};
+    while (i < count && equals(lhs[i], rhs[i])) {
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * Length of the common suffix of the count items ending before lhs_end and
+ * rhs_end, the backward counterpart of MismatchLength
+ */
+template <typename T>
+size_t MismatchLengthBackward(const T* lhs_end, const T* rhs_end, size_t count) {
+    size_t i = 0;
+    if constexpr (IsBytewiseComparable<T>::value) {
+        constexpr size_t kBlock = sizeof(T) >= 256 ? 1 : 256 / sizeof(T);
+        while (i + kBlock <= count &&
+               std::memcmp(lhs_end - i - kBlock, rhs_end - i - kBlock, kBlock * sizeof(T)) == 0) {
+            i += kBlock;
+        }
+    }
+    const ContentEquals<T> equals{};
+    while (i < count && equals(*(lhs_end - i - 1), *(rhs_end - i - 1))) {
+        ++i;
+    }
+    return i;
+}
+
 /**
  * Check equality for pointers (handles null pointers)
  */
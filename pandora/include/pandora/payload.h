@@ -0,0 +1,262 @@
+#ifndef PANDORA_PAYLOAD_H_
+#define PANDORA_PAYLOAD_H_
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pandora {
+
+namespace detail {
+
+/**
+ * Thread-local free lists for out-of-line payloads, in 64, 128 and 256 byte
+ * blocks. Larger payloads go to operator new. A block freed on another thread
+ * joins that thread's list.
+ */
+class PayloadPool {
+ public:
+  static constexpr size_t kClassCount = 3;
+  static constexpr size_t kMinBlock = 64;
+  static constexpr size_t kMaxBlock = kMinBlock << (kClassCount - 1);
+
+  static void* Allocate(size_t size) {
+    if (size > kMaxBlock) return ::operator new(size);
+    FreeList& list = Local().lists[ClassOf(size)];
+    if (list.head == nullptr) return ::operator new(kMinBlock << ClassOf(size));
+    Block* block = list.head;
+    list.head = block->next;
+    return block;
+  }
+
+  static void Free(void* ptr, size_t size) {
+    if (size > kMaxBlock) {
+      ::operator delete(ptr);
+      return;
+    }
+    FreeList& list = Local().lists[ClassOf(size)];
+    list.head = new (ptr) Block{list.head};
+  }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  struct FreeList {
+    Block* head = nullptr;
+  };
+
+  struct Lists {
+    FreeList lists[kClassCount];
+
+    ~Lists() {
+      for (FreeList& list : lists) {
+        while (list.head != nullptr) {
+          Block* next = list.head->next;
+          ::operator delete(list.head);
+          list.head = next;
+        }
+      }
+    }
+  };
+
+  static size_t ClassOf(size_t size) {
+    size_t index = 0;
+    while ((kMinBlock << index) < size) ++index;
+    return index;
+  }
+
+  static Lists& Local() {
+    thread_local Lists lists;
+    return lists;
+  }
+};
+
+template <typename P, typename = void>
+struct HasMergeMethod : std::false_type {};
+
+template <typename P>
+struct HasMergeMethod<P, std::void_t<decltype(std::declval<P&>().Merge(std::declval<const P&>()))>>
+    : std::true_type {};
+
+}  // namespace detail
+
+/**
+ * A typed change payload for ListUpdateCallback::OnChanged.
+ *
+ * Trivially copyable payloads of up to kInlineSize bytes, such as
+ * FieldChangeMask, are stored inline, so creating, copying and passing one
+ * never allocates. Other payloads are copied into pooled blocks. A Payload
+ * can also borrow a raw pointer, which is how a legacy void* payload from
+ * DiffCallback::GetChangePayload is carried.
+ *
+ * Payloads of the same type merge when the type has a
+ * void Merge(const P& other) member, e.g. to OR two field masks when
+ * BatchingListUpdateCallback joins adjacent changes.
+ */
+class Payload {
+ public:
+  static constexpr size_t kInlineSize = 24;
+
+  Payload() = default;
+
+  /**
+   * Stores a copy of value: inline when trivially copyable and small enough, pooled otherwise.
+   */
+  template <typename P, typename = std::enable_if_t<!std::is_same_v<std::decay_t<P>, Payload>>>
+  explicit Payload(P&& value) {
+    using Value = std::decay_t<P>;
+    ops_ = &OpsFor<Value>();
+    if constexpr (IsInline<Value>()) {
+      new (buffer_) Value(std::forward<P>(value));
+    } else {
+      static_assert(alignof(Value) <= alignof(std::max_align_t), "Over-aligned payloads are not supported");
+      void* block = detail::PayloadPool::Allocate(sizeof(Value));
+      new (block) Value(std::forward<P>(value));
+      std::memcpy(buffer_, &block, sizeof(block));
+    }
+  }
+
+  /**
+   * A non-owning payload: Data() returns ptr, which must outlive the payload's use.
+   */
+  static Payload Borrow(void* ptr) {
+    Payload payload;
+    if (ptr != nullptr) {
+      payload.ops_ = &kBorrowedOps;
+      std::memcpy(payload.buffer_, &ptr, sizeof(ptr));
+    }
+    return payload;
+  }
+
+  Payload(const Payload& other) { CopyFrom(other); }
+
+  Payload(Payload&& other) noexcept {
+    ops_ = other.ops_;
+    std::memcpy(buffer_, other.buffer_, kInlineSize);
+    other.ops_ = nullptr;
+  }
+
+  Payload& operator=(const Payload& other) {
+    if (this != &other) {
+      Reset();
+      CopyFrom(other);
+    }
+    return *this;
+  }
+
+  Payload& operator=(Payload&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ops_ = other.ops_;
+      std::memcpy(buffer_, other.buffer_, kInlineSize);
+      other.ops_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~Payload() { Reset(); }
+
+  [[nodiscard]] bool Empty() const { return ops_ == nullptr; }
+
+  /**
+   * The stored object, or the borrowed pointer, or nullptr when empty.
+   */
+  [[nodiscard]] void* Data() const {
+    if (ops_ == nullptr) return nullptr;
+    if (ops_->is_inline) return const_cast<unsigned char*>(buffer_);
+    void* ptr;
+    std::memcpy(&ptr, buffer_, sizeof(ptr));
+    return ptr;
+  }
+
+  /**
+   * The stored value if it is a P, otherwise nullptr. Borrowed payloads are untyped.
+   */
+  template <typename P>
+  [[nodiscard]] const P* Get() const {
+    return ops_ == &OpsFor<P>() ? static_cast<const P*>(Data()) : nullptr;
+  }
+
+  /**
+   * Merges other into this payload. Two empty payloads merge trivially, as
+   * do two borrowed payloads of the same pointer and two payloads of the same
+   * type with a Merge member. Returns false, leaving this payload unchanged,
+   * for anything else.
+   */
+  bool Merge(const Payload& other) {
+    if (ops_ == nullptr || other.ops_ == nullptr) return ops_ == other.ops_;
+    if (ops_ == &kBorrowedOps) return other.ops_ == &kBorrowedOps && Data() == other.Data();
+    if (ops_ != other.ops_ || ops_->merge == nullptr) return false;
+    ops_->merge(Data(), other.Data());
+    return true;
+  }
+
+ private:
+  struct Ops {
+    bool is_inline;
+    size_t size;
+    void (*copy)(void* target, const void* source);
+    void (*destroy)(void* object);
+    void (*merge)(void* target, const void* source);
+  };
+
+  template <typename P>
+  static constexpr bool IsInline() {
+    return std::is_trivially_copyable_v<P> && sizeof(P) <= kInlineSize &&
+           alignof(P) <= alignof(std::max_align_t);
+  }
+
+  template <typename P>
+  static const Ops& OpsFor() {
+    static constexpr Ops ops = {
+        IsInline<P>(),
+        sizeof(P),
+        [](void* target, const void* source) { new (target) P(*static_cast<const P*>(source)); },
+        [](void* object) { static_cast<P*>(object)->~P(); },
+        MergeFor<P>(),
+    };
+    return ops;
+  }
+
+  template <typename P>
+  static constexpr void (*MergeFor())(void*, const void*) {
+    if constexpr (detail::HasMergeMethod<P>::value) {
+      return [](void* target, const void* source) { static_cast<P*>(target)->Merge(*static_cast<const P*>(source)); };
+    } else {
+      return nullptr;
+    }
+  }
+
+  void CopyFrom(const Payload& other) {
+    ops_ = other.ops_;
+    if (ops_ == nullptr || ops_->is_inline || ops_ == &kBorrowedOps) {
+      std::memcpy(buffer_, other.buffer_, kInlineSize);
+      return;
+    }
+    void* block = detail::PayloadPool::Allocate(ops_->size);
+    ops_->copy(block, other.Data());
+    std::memcpy(buffer_, &block, sizeof(block));
+  }
+
+  void Reset() {
+    if (ops_ != nullptr && !ops_->is_inline && ops_ != &kBorrowedOps) {
+      void* block = Data();
+      ops_->destroy(block);
+      detail::PayloadPool::Free(block, ops_->size);
+    }
+    ops_ = nullptr;
+  }
+
+  static constexpr Ops kBorrowedOps = {false, 0, nullptr, nullptr, nullptr};
+
+  const Ops* ops_ = nullptr;
+  alignas(std::max_align_t) unsigned char buffer_[kInlineSize] = {};
+};
+
+}  // namespace pandora
+
+#endif  // PANDORA_PAYLOAD_H_
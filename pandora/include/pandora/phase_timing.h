@@ -0,0 +1,89 @@
+#ifndef PANDORA_PHASE_TIMING_H_
+#define PANDORA_PHASE_TIMING_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace pandora
+{
+    /**
+     * @brief Stages of the change notification path of a data set
+     */
+    enum class Phase
+    {
+        SNAPSHOT = 0,  // Copying the old state and hashing it
+        DIFF,          // DiffUtil::CalculateDiff
+        DISPATCH,      // DiffResult::DispatchUpdatesTo, including the callbacks
+        COUNT
+    };
+
+    /**
+     * @brief Time spent per Phase by the current thread
+     *
+     * Only accumulated when PANDORA_ENABLE_PHASE_TIMING is defined to a
+     * non-zero value; otherwise PANDORA_TIME_PHASE compiles to nothing. The
+     * macro must have the same value in every translation unit instantiating
+     * the same data set types.
+     */
+    struct PhaseTimes
+    {
+        std::array<uint64_t, static_cast<int>(Phase::COUNT)> nanos{};
+        std::array<uint64_t, static_cast<int>(Phase::COUNT)> calls{};
+
+        [[nodiscard]] uint64_t GetNanos(Phase phase) const { return nanos[static_cast<int>(phase)]; }
+        [[nodiscard]] uint64_t GetCalls(Phase phase) const { return calls[static_cast<int>(phase)]; }
+
+        PhaseTimes operator-(const PhaseTimes& other) const
+        {
+            PhaseTimes result;
+            for (int i = 0; i < static_cast<int>(Phase::COUNT); ++i)
+            {
+                result.nanos[i] = nanos[i] - other.nanos[i];
+                result.calls[i] = calls[i] - other.calls[i];
+            }
+            return result;
+        }
+    };
+
+    inline PhaseTimes& ThreadPhaseTimes()
+    {
+        thread_local PhaseTimes times;
+        return times;
+    }
+
+    class ScopedPhaseTimer
+    {
+    public:
+        explicit ScopedPhaseTimer(Phase phase)
+            : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+
+        ~ScopedPhaseTimer()
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            PhaseTimes& times = ThreadPhaseTimes();
+            times.nanos[static_cast<int>(phase_)] +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            times.calls[static_cast<int>(phase_)]++;
+        }
+
+        ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+        ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+    private:
+        Phase phase_;
+        std::chrono::steady_clock::time_point start_;
+    };
+} // namespace pandora
+
+#define PANDORA_PHASE_CONCAT_INNER(a, b) a##b
+#define PANDORA_PHASE_CONCAT(a, b) PANDORA_PHASE_CONCAT_INNER(a, b)
+
+#if defined(PANDORA_ENABLE_PHASE_TIMING) && PANDORA_ENABLE_PHASE_TIMING
+#define PANDORA_TIME_PHASE(phase) \
+    ::pandora::ScopedPhaseTimer PANDORA_PHASE_CONCAT(pandora_phase_timer_, __LINE__)(phase)
+#else
+#define PANDORA_TIME_PHASE(phase) ((void)0)
+#endif
+
+#endif  // PANDORA_PHASE_TIMING_H_
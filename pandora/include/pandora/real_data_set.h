@@ -4,16 +4,40 @@
 #include "pandora_box_adapter.h"
 #include "pandora_traits.h"
 #include "diff_util.h"
+#include "field_hashers.h"
+#include "instrumentation.h"
+#include "mutation_recorder.h"
 #include <vector>
 #include <algorithm>
+#include <iterator>
+#include <utility>
 
 namespace pandora
 {
-    template <typename T>
+    /**
+     * @brief Leaf data set holding its items in a contiguous container
+     *
+     * SetData with the items already held returns without a snapshot, diff
+     * or notification. Bytewise comparable items are compared with memcmp;
+     * other items also need matching content hashes, item by item.
+     *
+     * @tparam T The data type
+     * @tparam Storage The container of the items: std::vector<T>, or another
+     *         type with the same interface such as MappedStorage<T>
+     */
+    template <typename T, typename Storage = std::vector<T>>
     class RealDataSet final : public PandoraBoxAdapter<T>
     {
     public:
         RealDataSet() = default;
+
+        explicit RealDataSet(Storage storage) : data_(std::move(storage)) {}
+
+        /**
+         * @brief The underlying container; mutate through the data set so updates are notified
+         */
+        [[nodiscard]] const Storage& GetStorage() const { return data_; }
+
         [[nodiscard]] int GetDataCount() const override { return static_cast<int>(data_.size()); }
 
         T* GetDataByIndex(int index) override
@@ -24,6 +48,7 @@ namespace pandora
 
         void ClearAllData() override
         {
+            RecordMutation(MutationOp::CLEAR);
             OnBeforeChanged();
             data_.clear();
             OnAfterChanged();
@@ -31,6 +56,7 @@ namespace pandora
 
         void Add(const T& item) override
         {
+            RecordMutation(MutationOp::ADD, 0, &item, 1);
             OnBeforeChanged();
             data_.push_back(item);
             OnAfterChanged();
@@ -38,37 +64,45 @@ namespace pandora
 
         void Add(int pos, const T& item) override
         {
+            RecordMutation(MutationOp::ADD_AT, pos, &item, 1);
             if (pos < 0 || pos > static_cast<int>(data_.size())) return;
             OnBeforeChanged();
-            data_.insert(data_.begin() + pos, item);
+            data_.insert(data_.cbegin() + pos, item);
             OnAfterChanged();
         }
 
         void AddAll(const std::vector<T>& collection) override
         {
+            RecordMutation(MutationOp::ADD_ALL, 0, collection.data(), collection.size());
             OnBeforeChanged();
-            data_.insert(data_.end(), collection.begin(), collection.end());
+            data_.insert(data_.cend(), collection.begin(), collection.end());
             OnAfterChanged();
         }
 
         void Remove(const T& item) override
         {
+            RecordMutation(MutationOp::REMOVE, 0, &item, 1);
             OnBeforeChanged();
-            auto it = std::find(data_.begin(), data_.end(), item);
-            if (it != data_.end()) data_.erase(it);
+            auto it = std::find(data_.cbegin(), data_.cend(), item);
+            if (it != data_.cend())
+            {
+                data_.erase(it);
+            }
             OnAfterChanged();
         }
 
         void RemoveAtPos(int position) override
         {
+            RecordMutation(MutationOp::REMOVE_AT, position);
             if (position < 0 || position >= static_cast<int>(data_.size())) return;
             OnBeforeChanged();
-            data_.erase(data_.begin() + position);
+            data_.erase(data_.cbegin() + position);
             OnAfterChanged();
         }
 
         bool ReplaceAtPosIfExist(int position, const T& item) override
         {
+            RecordMutation(MutationOp::REPLACE_AT, position, &item, 1);
             if (position < 0 || position >= static_cast<int>(data_.size())) return false;
             OnBeforeChanged();
             data_[position] = item;
@@ -78,11 +112,48 @@ namespace pandora
 
         void SetData(const std::vector<T>& collection) override
         {
+            RecordMutation(MutationOp::SET_DATA, 0, collection.data(), collection.size());
+            if (collection.size() == data_.size() && HoldsSameItems(collection)) return;
             OnBeforeChanged();
-            data_ = collection;
+            data_.assign(collection.begin(), collection.end());
             OnAfterChanged();
         }
 
+        /**
+         * @brief Replaces the items and notifies updates known upfront instead of diffing
+         *
+         * dispatch(callback) reports to callback the updates that turn the
+         * current items into items, e.g. decoded from an edit script; it runs
+         * after the items are replaced, as DiffResult::DispatchUpdatesTo does.
+         * No snapshot is taken. Inside a transaction dispatch is not called:
+         * the transaction's own diff reports the change.
+         */
+        template <typename Dispatch>
+        void SetDataWithUpdates(std::vector<T> items, Dispatch&& dispatch)
+        {
+            RecordMutation(MutationOp::SET_DATA, 0, items.data(), items.size());
+            const bool notify = !InTransaction();
+            if (notify)
+            {
+                if (parent_) parent_->OnBeforeChanged();
+            }
+            else
+            {
+                OnBeforeChanged();
+            }
+            data_.assign(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+            if (parent_) parent_->OnAfterChanged();
+
+            auto callback = notify ? PandoraBoxAdapter<T>::GetListUpdateCallback() : nullptr;
+            if (callback)
+            {
+                PANDORA_INSTRUMENT_PHASE(this, Phase::DISPATCH);
+                PANDORA_METRICS(MetricsListUpdateCallback counted(callback, this->GetOrCreateMetrics()));
+                PANDORA_METRICS(callback = &counted);
+                dispatch(callback);
+            }
+        }
+
         int IndexOf(const T& item) const override
         {
             auto it = std::find(data_.begin(), data_.end(), item);
@@ -165,18 +236,24 @@ namespace pandora
         // Transaction support
         void StartTransaction() override
         {
+            RecordMutation(MutationOp::START_TRANSACTION);
+            PANDORA_TRACE_SPAN(trace_span, "pandora", "StartTransaction", this->GetAlias());
             use_transaction_ = true;
             Snapshot();
         }
 
         void EndTransaction() override
         {
+            RecordMutation(MutationOp::END_TRANSACTION);
+            PANDORA_TRACE_SPAN(trace_span, "pandora", "EndTransaction", this->GetAlias());
+            PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), GetDataCount()));
             use_transaction_ = false;
             CalcChangeAndNotify();
         }
 
         void EndTransactionSilently() override
         {
+            RecordMutation(MutationOp::END_TRANSACTION_SILENTLY);
             use_transaction_ = false;
         }
 
@@ -230,15 +307,21 @@ namespace pandora
         // DiffCallback implementation for change detection
         class DiffCallbackImpl : public DiffCallback {
         private:
-            RealDataSet<T>* dataset_;
+            RealDataSet* dataset_;
             const std::vector<T>& old_list_;
             const std::vector<size_t>& old_hashes_;
+            const FieldHashSnapshot<T>& old_fields_;
 
         public:
-            DiffCallbackImpl(RealDataSet<T>* dataset,
+            DiffCallbackImpl(RealDataSet* dataset,
                            const std::vector<T>& old_list,
-                           const std::vector<size_t>& old_hashes)
-                : dataset_(dataset), old_list_(old_list), old_hashes_(old_hashes) {}
+                           const std::vector<size_t>& old_hashes,
+                           const FieldHashSnapshot<T>& old_fields)
+                : dataset_(dataset), old_list_(old_list), old_hashes_(old_hashes), old_fields_(old_fields) {}
+
+            // Call counts, only kept with PANDORA_ENABLE_METRICS
+            mutable uint64_t items_the_same_calls = 0;
+            mutable uint64_t contents_the_same_calls = 0;
 
             int GetOldListSize() const override {
                 return static_cast<int>(old_list_.size());
@@ -249,22 +332,43 @@ namespace pandora
             }
 
             bool AreItemsTheSame(int old_item_position, int new_item_position) const override {
+                PANDORA_METRICS(++items_the_same_calls);
                 if (old_item_position >= static_cast<int>(old_list_.size())) return false;
                 if (new_item_position >= dataset_->GetDataCount()) return false;
 
                 const T& old_item = old_list_[old_item_position];
-                T* new_item = dataset_->GetDataByIndex(new_item_position);
+                const T* new_item = dataset_->ItemAt(new_item_position);
 
                 if (new_item == nullptr) return false;
                 return Pandora::Equals(old_item, *new_item);
             }
 
+            // Both lists are contiguous, so a run is compared in one call
+            int CountItemsTheSame(int old_item_position, int new_item_position, int max_count) const override {
+                if (max_count <= 0) return 0;
+                const size_t run = Pandora::MismatchLength(&old_list_[old_item_position],
+                                                           dataset_->ItemAt(new_item_position),
+                                                           static_cast<size_t>(max_count));
+                PANDORA_METRICS(items_the_same_calls += run + (run < static_cast<size_t>(max_count) ? 1 : 0));
+                return static_cast<int>(run);
+            }
+
+            int CountItemsTheSameBackward(int old_item_end, int new_item_end, int max_count) const override {
+                if (max_count <= 0) return 0;
+                const size_t run = Pandora::MismatchLengthBackward(old_list_.data() + old_item_end,
+                                                                   dataset_->ItemAt(0) + new_item_end,
+                                                                   static_cast<size_t>(max_count));
+                PANDORA_METRICS(items_the_same_calls += run + (run < static_cast<size_t>(max_count) ? 1 : 0));
+                return static_cast<int>(run);
+            }
+
             bool AreContentsTheSame(int old_item_position, int new_item_position) const override {
+                PANDORA_METRICS(++contents_the_same_calls);
                 if (old_item_position >= static_cast<int>(old_list_.size())) return false;
                 if (new_item_position >= dataset_->GetDataCount()) return false;
 
                 const T& old_item = old_list_[old_item_position];
-                T* new_item = dataset_->GetDataByIndex(new_item_position);
+                const T* new_item = dataset_->ItemAt(new_item_position);
 
                 // First check if items are the same
                 if (new_item == nullptr) return false;
@@ -275,21 +379,59 @@ namespace pandora
                 size_t new_hash = Pandora::Hash(*new_item);
                 return old_hashes_[old_item_position] == new_hash;
             }
+
+            // An inline FieldChangeMask for types with FieldHashers, otherwise empty
+            Payload GetTypedChangePayload(int old_item_position, int new_item_position) const override {
+                if constexpr (FieldHashSnapshot<T>::kEnabled) {
+                    const T* new_item = dataset_->ItemAt(new_item_position);
+                    if (new_item == nullptr) return Payload();
+                    const FieldChangeMask mask = old_fields_.Compare(static_cast<size_t>(old_item_position), *new_item);
+                    if (!mask.Empty()) return Payload(mask);
+                }
+                return Payload();
+            }
         };
 
-        void Snapshot()
+        [[nodiscard]] const T* ItemAt(int index) const
         {
-            old_data_.clear();
-            old_data_hashes_.clear();
+            if (index < 0 || index >= static_cast<int>(data_.size())) return nullptr;
+            return &data_[index];
+        }
 
-            if (data_.size() > 0)
+        /**
+         * @brief Whether collection, of the current size, holds the current items in the same order and with the same contents
+         *
+         * Nothing is cached: items may be edited in place through GetDataByIndex.
+         */
+        bool HoldsSameItems(const std::vector<T>& collection) const
+        {
+            const size_t count = collection.size();
+            if (count == 0) return true;
+            const T* current = ItemAt(0);
+            if (Pandora::MismatchLength(current, collection.data(), count) != count) return false;
+            if constexpr (!IsBytewiseComparable<T>::value)
             {
-                old_data_.assign(data_.begin(), data_.end());
-                for (const auto& item : data_)
+                // Equals may compare keys only; the content hashes must match too
+                const ContentHasher<T> hasher{};
+                for (size_t i = 0; i < count; ++i)
                 {
-                    old_data_hashes_.push_back(Pandora::Hash(item));
+                    if (hasher(current[i]) != hasher(collection[i])) return false;
                 }
             }
+            return true;
+        }
+
+        void Snapshot()
+        {
+            PANDORA_INSTRUMENT_PHASE(this, Phase::SNAPSHOT);
+            PANDORA_TRACE_SPAN(trace_span, "pandora", "Snapshot", this->GetAlias());
+            old_data_.assign(data_.cbegin(), data_.cend());
+            old_data_hashes_.resize(old_data_.size());
+            Pandora::HashRange(old_data_.data(), old_data_.size(), old_data_hashes_.data());
+            old_field_hashes_.Capture(old_data_.data(), old_data_.size());
+            PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), TraceEvent::kNoValue));
+            PANDORA_METRICS(this->GetOrCreateMetrics().RecordSnapshot(
+                old_data_.size(), old_data_.size() * (sizeof(T) + sizeof(size_t)) + old_field_hashes_.GetBytes()));
         }
 
         // Calculate changes and notify observers
@@ -297,23 +439,54 @@ namespace pandora
         {
             if (auto callback = PandoraBoxAdapter<T>::GetListUpdateCallback())
             {
-                DiffCallbackImpl diff_callback(this, old_data_, old_data_hashes_);
-                const auto result = DiffUtil::CalculateDiff(&diff_callback);
+                DiffCallbackImpl diff_callback(this, old_data_, old_data_hashes_, old_field_hashes_);
+                std::unique_ptr<DiffUtil::DiffResult> result;
+                {
+                    PANDORA_INSTRUMENT_PHASE(this, Phase::DIFF);
+                    PANDORA_TRACE_SPAN(trace_span, "pandora", "CalculateDiff", this->GetAlias());
+                    result = DiffUtil::CalculateDiff(&diff_callback);
+                    PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), GetDataCount()));
+                    PANDORA_TRACE(if (result) trace_span.SetEdits(result->GetEditDistance()));
+                }
+                PANDORA_METRICS(RecordDiffMetrics(diff_callback, result.get()));
                 if (result)
                 {
-                    if (auto ref = result.get()) ref->DispatchUpdatesTo(callback);
+                    PANDORA_INSTRUMENT_PHASE(this, Phase::DISPATCH);
+                    PANDORA_TRACE_SPAN(trace_span, "pandora", "DispatchUpdatesTo", this->GetAlias());
+                    PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), GetDataCount()));
+                    PANDORA_TRACE(trace_span.SetEdits(result->GetEditDistance()));
+                    PANDORA_METRICS(MetricsListUpdateCallback counted(callback, this->GetOrCreateMetrics()));
+                    PANDORA_METRICS(callback = &counted);
+                    result->DispatchUpdatesTo(callback);
                 }
             }
         }
 
+        template <typename Callback>
+        void RecordDiffMetrics(const Callback& diff_callback, const DiffUtil::DiffResult* result)
+        {
+            AdapterMetrics& metrics = this->GetOrCreateMetrics();
+            metrics.RecordDiffCalls(diff_callback.items_the_same_calls, diff_callback.contents_the_same_calls);
+            if (result)
+            {
+                metrics.RecordDiff(static_cast<uint64_t>(result->GetEditDistance()));
+            }
+        }
+
+        void RecordMutation(MutationOp op, int position = 0, const T* items = nullptr, size_t count = 0)
+        {
+            if (auto* recorder = this->FindMutationRecorder()) recorder->Record(this, op, position, items, count);
+        }
+
         [[nodiscard]] bool IsParentInTransaction() const
         {
             return parent_ != nullptr && parent_->InTransaction();
         }
 
-        std::vector<T> data_;
+        Storage data_;
         std::vector<T> old_data_; // Snapshot for transaction rollback
         std::vector<size_t> old_data_hashes_; // Snapshot of content hashes
+        FieldHashSnapshot<T> old_field_hashes_; // Snapshot of per-field hashes, with FieldHashers<T>
         bool use_transaction_ = false;
         int group_index_ = Node<PandoraBoxAdapter<T>>::kNoGroupIndex;
         int start_index_ = 0;
@@ -0,0 +1,273 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 leobert-lan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ */
+
+#ifndef PANDORA_RV_BATCHED_REACTIVE_DATA_H
+#define PANDORA_RV_BATCHED_REACTIVE_DATA_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "reactive_data.h"
+#include "i_reactive_view_holder.h"
+#include "../logger.h"
+
+namespace pandora {
+namespace rv {
+
+/**
+ * @brief Something holding property changes until it is flushed
+ */
+class IPropertyChangeFlushable {
+public:
+    virtual ~IPropertyChangeFlushable() = default;
+
+    /**
+     * @brief Deliver all accumulated property changes
+     */
+    virtual void FlushPropertyChanges() = 0;
+};
+
+/**
+ * @brief Per-tick queue of reactive data waiting to deliver property changes
+ *
+ * Data objects post themselves when they become dirty; the host drains the
+ * queue once per frame with Flush(). Posting is thread-safe, flushing is
+ * expected to happen on the UI thread.
+ */
+class ReactiveFlushQueue {
+public:
+    void Post(std::weak_ptr<IPropertyChangeFlushable> flushable) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(flushable));
+    }
+
+    /**
+     * @brief Flush every posted data object
+     *
+     * @return The number of data objects flushed
+     */
+    int Flush() {
+        std::vector<std::weak_ptr<IPropertyChangeFlushable>> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending.swap(pending_);
+        }
+        int flushed = 0;
+        for (auto& weak : pending) {
+            if (auto flushable = weak.lock()) {
+                try {
+                    flushable->FlushPropertyChanges();
+                    ++flushed;
+                } catch (const std::exception& e) {
+                    Logger::e("ReactiveFlushQueue",
+                              std::string("Exception when flushing property changes: ") + e.what());
+                }
+            }
+        }
+        return flushed;
+    }
+
+    bool IsEmpty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_.empty();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::weak_ptr<IPropertyChangeFlushable>> pending_;
+};
+
+/**
+ * @brief ReactiveData that batches property changes into a dirty mask
+ *
+ * Property changes are accumulated and delivered to the bound ViewHolder as a
+ * single OnPropertiesChanged() call:
+ * - inside StartBatch()/EndBatch(), when the outermost batch ends;
+ * - otherwise, when the ReactiveFlushQueue given at construction is flushed;
+ * - without a queue, immediately.
+ *
+ * Property ids outside [0, 64) have no bit in the mask. They are kept in a
+ * separate list and delivered one by one through OnPropertyChanged(), after
+ * the mask.
+ *
+ * @tparam DA The actual data type, deriving from BatchedReactiveData<DA>
+ *
+ * Example:
+ * @code
+ * class MyData : public BatchedReactiveData<MyData> {
+ * public:
+ *     explicit MyData(ReactiveFlushQueue* queue) : BatchedReactiveData(queue) {}
+ *
+ *     void set_name(const std::string& name) {
+ *         name_ = name;
+ *         NotifyPropertyChanged(PROPERTY_NAME);
+ *     }
+ *
+ *     static constexpr int PROPERTY_NAME = 1;
+ *
+ * private:
+ *     std::string name_;
+ * };
+ *
+ * // Once per frame
+ * queue.Flush();
+ * @endcode
+ *
+ * @note The object must be owned by a std::shared_ptr. Batches are not
+ *       thread-safe, while NotifyPropertyChanged() may be called from any thread
+ *       when a queue is used. The queue must outlive the data.
+ */
+template<typename DA>
+class BatchedReactiveData : public ReactiveData<DA>,
+                            public IPropertyChangeFlushable,
+                            public std::enable_shared_from_this<BatchedReactiveData<DA>> {
+public:
+    explicit BatchedReactiveData(ReactiveFlushQueue* queue = nullptr) : queue_(queue) {}
+
+    // A copy starts unbound and clean
+    BatchedReactiveData(const BatchedReactiveData& other) : queue_(other.queue_) {}
+
+    BatchedReactiveData& operator=(const BatchedReactiveData&) {
+        return *this;
+    }
+
+    void BindReactiveVh(std::shared_ptr<IReactiveViewHolder<DA>> view_holder) override {
+        std::lock_guard<std::mutex> lock(view_holder_mutex_);
+        view_holder_ = view_holder;
+    }
+
+    void UnbindReactiveVh() override {
+        std::lock_guard<std::mutex> lock(view_holder_mutex_);
+        view_holder_.reset();
+    }
+
+    /**
+     * @brief Start a batch; changes are held until the matching EndBatch()
+     */
+    void StartBatch() {
+        batch_depth_++;
+    }
+
+    /**
+     * @brief End a batch, flushing the changes if it was the outermost one
+     */
+    void EndBatch() {
+        if (batch_depth_ == 0) {
+            Logger::w("BatchedReactiveData", "EndBatch() without StartBatch()");
+            return;
+        }
+        if (--batch_depth_ == 0) {
+            FlushPropertyChanges();
+        }
+    }
+
+    bool InBatch() const {
+        return batch_depth_ > 0;
+    }
+
+    /**
+     * @brief Get the properties changed since the last flush, without ids outside [0, 64)
+     */
+    PropertyMask GetDirtyProperties() const {
+        return dirty_.load(std::memory_order_acquire);
+    }
+
+    void FlushPropertyChanges() override {
+        posted_.store(false, std::memory_order_release);
+        const PropertyMask mask = dirty_.exchange(0, std::memory_order_acq_rel);
+        std::vector<int> overflow;
+        {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            overflow.swap(overflow_);
+        }
+        if (mask == 0 && overflow.empty()) {
+            return;
+        }
+
+        std::shared_ptr<IReactiveViewHolder<DA>> view_holder;
+        {
+            std::lock_guard<std::mutex> lock(view_holder_mutex_);
+            view_holder = view_holder_.lock();
+        }
+        if (view_holder) {
+            auto data = std::static_pointer_cast<DA>(this->shared_from_this());
+            if (mask != 0) {
+                view_holder->OnPropertiesChanged(data, mask);
+            }
+            for (int property_id : overflow) {
+                view_holder->OnPropertyChanged(data, property_id);
+            }
+        }
+    }
+
+protected:
+    void NotifyPropertyChanged(int property_id) {
+        const PropertyMask bit = PropertyBit(property_id);
+        if (bit != 0) {
+            NotifyPropertiesChanged(bit);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            if (std::find(overflow_.begin(), overflow_.end(), property_id) != overflow_.end()) {
+                return;
+            }
+            overflow_.push_back(property_id);
+        }
+        ScheduleFlush();
+    }
+
+    void NotifyPropertiesChanged(PropertyMask mask) {
+        if (mask == 0) {
+            return;
+        }
+        dirty_.fetch_or(mask, std::memory_order_acq_rel);
+        ScheduleFlush();
+    }
+
+private:
+    void ScheduleFlush() {
+        if (batch_depth_ > 0) {
+            return;
+        }
+        if (!queue_) {
+            FlushPropertyChanges();
+            return;
+        }
+        if (!posted_.exchange(true, std::memory_order_acq_rel)) {
+            queue_->Post(this->weak_from_this());
+        }
+    }
+
+    ReactiveFlushQueue* queue_;
+    std::atomic<PropertyMask> dirty_{0};
+    std::mutex overflow_mutex_;
+    std::vector<int> overflow_;  // Changed ids outside [0, 64), in notification order
+    std::atomic<bool> posted_{false};
+    int batch_depth_ = 0;
+    std::mutex view_holder_mutex_;
+    std::weak_ptr<IReactiveViewHolder<DA>> view_holder_;
+};
+
+} // namespace rv
+} // namespace pandora
+
+#endif // PANDORA_RV_BATCHED_REACTIVE_DATA_H
@@ -0,0 +1,283 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 leobert-lan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ */
+
+#ifndef PANDORA_RV_BIND_SCHEDULER_H
+#define PANDORA_RV_BIND_SCHEDULER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../logger.h"
+
+namespace pandora {
+namespace rv {
+
+/**
+ * @brief Direction the host view is currently scrolling in
+ */
+enum class ScrollDirection { NONE, FORWARD, BACKWARD };
+
+/**
+ * @brief Accumulated bind cost of one view type
+ */
+struct BindCostStats {
+    int64_t count = 0;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+
+    std::chrono::nanoseconds Average() const {
+        return count == 0 ? std::chrono::nanoseconds(0) : total / count;
+    }
+};
+
+/**
+ * @brief Spreads ViewHolder binding over frames under a per-frame time budget
+ *
+ * Bind requests are queued per position and executed by RunFrame(), which the
+ * host calls once per frame:
+ * 1. Pending visible positions are always bound, regardless of the budget,
+ *    so that no visible row is left blank.
+ * 2. Positions ahead of the viewport in the scroll direction are prefetched,
+ *    nearest first, as long as the measured average cost of their view type
+ *    still fits in the remaining budget.
+ * 3. Anything else is bound nearest-to-viewport first with whatever budget is
+ *    left, or deferred to a later frame.
+ *
+ * The scheduler measures every bind and keeps the cost per view type, which is
+ * both used for the budget prediction and exposed through GetBindCost().
+ *
+ * Example:
+ * @code
+ * BindScheduler scheduler(std::chrono::milliseconds(4));
+ *
+ * // In onBindViewHolder
+ * scheduler.Schedule(position, view_type, [=] {
+ *     DataSet<MyData>::HelpSetToViewHolder(data, holder);
+ * });
+ *
+ * // On scroll
+ * scheduler.UpdateViewport(first, last, ScrollDirection::FORWARD, 6);
+ *
+ * // Once per frame
+ * scheduler.RunFrame();
+ * @endcode
+ *
+ * @note Not thread-safe; use it from the UI thread only.
+ */
+class BindScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using BindTask = std::function<void()>;
+    using NowFunc = std::function<Clock::time_point()>;
+
+    /**
+     * @brief Construct a scheduler
+     *
+     * @param frame_budget Time that binding may take per frame, besides visible rows
+     * @param now Clock source, replaceable for testing
+     */
+    explicit BindScheduler(std::chrono::nanoseconds frame_budget, NowFunc now = Clock::now)
+        : frame_budget_(frame_budget), now_(std::move(now)) {}
+
+    void SetFrameBudget(std::chrono::nanoseconds frame_budget) {
+        frame_budget_ = frame_budget;
+    }
+
+    std::chrono::nanoseconds GetFrameBudget() const {
+        return frame_budget_;
+    }
+
+    /**
+     * @brief Update the visible range and scroll state
+     *
+     * @param first_visible The first visible position
+     * @param last_visible The last visible position
+     * @param direction The current scroll direction
+     * @param prefetch_distance How many positions ahead of the viewport to prefetch
+     */
+    void UpdateViewport(int first_visible, int last_visible, ScrollDirection direction,
+                        int prefetch_distance) {
+        first_visible_ = first_visible;
+        last_visible_ = last_visible;
+        direction_ = direction;
+        prefetch_distance_ = std::max(0, prefetch_distance);
+    }
+
+    /**
+     * @brief Queue a bind for position, replacing any bind still pending for it
+     *
+     * @param position The adapter position
+     * @param view_type The view type of the row, used for cost accounting
+     * @param task The bind to run
+     */
+    void Schedule(int position, int view_type, BindTask task) {
+        pending_[position] = PendingBind{view_type, std::move(task)};
+    }
+
+    /**
+     * @brief Drop the pending bind of position, e.g. when its holder is recycled
+     */
+    void Cancel(int position) {
+        pending_.erase(position);
+    }
+
+    void CancelAll() {
+        pending_.clear();
+    }
+
+    int GetPendingCount() const {
+        return static_cast<int>(pending_.size());
+    }
+
+    bool IsPending(int position) const {
+        return pending_.find(position) != pending_.end();
+    }
+
+    /**
+     * @brief Run the binds of one frame
+     *
+     * @return The number of binds executed
+     */
+    int RunFrame() {
+        int bound = 0;
+
+        // 1. Visible rows, unconditionally
+        if (first_visible_ >= 0 && last_visible_ >= first_visible_) {
+            // Re-seek after every task: it may have cancelled the next position
+            auto it = pending_.lower_bound(first_visible_);
+            while (it != pending_.end() && it->first <= last_visible_) {
+                const int position = it->first;
+                Run(it);
+                ++bound;
+                it = pending_.lower_bound(position + 1);
+            }
+        }
+
+        // The budget only covers the optional work below
+        const Clock::time_point deadline = now_() + frame_budget_;
+
+        // 2. Prefetch in the scroll direction, nearest first
+        for (int step = 1; step <= prefetch_distance_ && direction_ != ScrollDirection::NONE; ++step) {
+            const int position = direction_ == ScrollDirection::FORWARD
+                                     ? last_visible_ + step
+                                     : first_visible_ - step;
+            auto it = pending_.find(position);
+            if (it == pending_.end()) continue;
+            if (!Fits(it->second.view_type, deadline)) {
+                return bound;
+            }
+            Run(it);
+            ++bound;
+        }
+
+        // 3. Everything else, nearest to the viewport first
+        if (pending_.empty() || now_() >= deadline) {
+            return bound;
+        }
+        std::vector<std::pair<int, int>> rest;  // (distance, position)
+        rest.reserve(pending_.size());
+        for (const auto& entry : pending_) {
+            rest.emplace_back(DistanceToViewport(entry.first), entry.first);
+        }
+        std::sort(rest.begin(), rest.end());
+        for (const auto& candidate : rest) {
+            auto it = pending_.find(candidate.second);
+            if (it == pending_.end()) continue;  // cancelled by an earlier task
+            if (!Fits(it->second.view_type, deadline)) break;
+            Run(it);
+            ++bound;
+        }
+        return bound;
+    }
+
+    /**
+     * @brief Get the measured bind cost of a view type
+     */
+    BindCostStats GetBindCost(int view_type) const {
+        const auto it = cost_by_view_type_.find(view_type);
+        return it == cost_by_view_type_.end() ? BindCostStats() : it->second;
+    }
+
+    /**
+     * @brief Get the measured bind cost of every view type seen so far
+     */
+    const std::unordered_map<int, BindCostStats>& GetAllBindCosts() const {
+        return cost_by_view_type_;
+    }
+
+    void ResetBindCosts() {
+        cost_by_view_type_.clear();
+    }
+
+private:
+    struct PendingBind {
+        int view_type;
+        BindTask task;
+    };
+
+    using PendingMap = std::map<int, PendingBind>;
+
+    void Run(PendingMap::iterator it) {
+        // Take the task out first: it may schedule or cancel other positions
+        const int view_type = it->second.view_type;
+        BindTask task = std::move(it->second.task);
+        pending_.erase(it);
+
+        const Clock::time_point start = now_();
+        try {
+            if (task) task();
+        } catch (const std::exception& e) {
+            Logger::e("BindScheduler", std::string("Exception in bind task: ") + e.what());
+        }
+        const auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(now_() - start);
+
+        BindCostStats& stats = cost_by_view_type_[view_type];
+        stats.count++;
+        stats.total += cost;
+        stats.max = std::max(stats.max, cost);
+    }
+
+    bool Fits(int view_type, Clock::time_point deadline) const {
+        return now_() + GetBindCost(view_type).Average() <= deadline;
+    }
+
+    int DistanceToViewport(int position) const {
+        if (position < first_visible_) return first_visible_ - position;
+        if (position > last_visible_) return position - last_visible_;
+        return 0;
+    }
+
+    std::chrono::nanoseconds frame_budget_;
+    NowFunc now_;
+    PendingMap pending_;
+    std::unordered_map<int, BindCostStats> cost_by_view_type_;
+    int first_visible_ = -1;
+    int last_visible_ = -1;
+    ScrollDirection direction_ = ScrollDirection::NONE;
+    int prefetch_distance_ = 0;
+};
+
+} // namespace rv
+} // namespace pandora
+
+#endif // PANDORA_RV_BIND_SCHEDULER_H
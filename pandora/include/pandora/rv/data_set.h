@@ -24,8 +24,11 @@
 #include "data_observer.h"
 #include "data_vh_mapping_pool.h"
 #include "i_view_holder.h"
+#include "viewport.h"
+#include "../list_update_callback.h"
 #include "../data_adapter.h"
 #include "../pandora_exception.h"
+#include "../trace.h"
 
 namespace pandora
 {
@@ -44,6 +47,7 @@ namespace pandora
          * - Observer pattern for change notifications
          * - Weak reference observers to avoid memory leaks
          * - Thread-safe operations
+         * - Optional viewport filtering that defers off-screen notifications
          *
          * Example:
          * @code
@@ -245,6 +249,79 @@ namespace pandora
                 return *this;
             }
 
+            // ========== Viewport ==========
+
+            /**
+             * @brief Set the visible range of the host view
+             *
+             * While a viewport is set, notifications touching
+             * [first_visible - prefetch, last_visible + prefetch] are dispatched
+             * precisely, and off-screen ones are collapsed and deferred until the
+             * viewport moves or FlushDeferredUpdates() is called.
+             *
+             * @param first_visible The first visible position
+             * @param last_visible The last visible position
+             * @param prefetch Extra rows on both sides that are treated as visible
+             */
+            void SetViewport(int first_visible, int last_visible, int prefetch = 0)
+            {
+                Viewport viewport;
+                viewport.first_visible = first_visible;
+                viewport.last_visible = last_visible;
+                viewport.prefetch = prefetch;
+
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                viewport_filter_.SetViewport(viewport, GetCount(), broadcaster_);
+            }
+
+            /**
+             * @brief Remove the viewport, flushing deferred updates and disabling filtering
+             */
+            void ClearViewport()
+            {
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                viewport_filter_.SetViewport(Viewport(), GetCount(), broadcaster_);
+            }
+
+            /**
+             * @brief Get the current viewport, shifted by off-screen inserts and removals
+             */
+            Viewport GetViewport() const
+            {
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                return viewport_filter_.GetViewport();
+            }
+
+            /**
+             * @brief Dispatch all deferred off-screen updates
+             *
+             * Call this once per frame before layout, or before binding a row for which
+             * IsDeferred() returns true.
+             */
+            void FlushDeferredUpdates()
+            {
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                viewport_filter_.Flush(broadcaster_);
+            }
+
+            /**
+             * @brief Whether off-screen updates are waiting to be dispatched
+             */
+            bool HasDeferredUpdates() const
+            {
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                return viewport_filter_.HasDeferredUpdates();
+            }
+
+            /**
+             * @brief Whether observers may hold stale state for the row at position
+             */
+            bool IsDeferred(int position) const
+            {
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                return viewport_filter_.IsDeferred(position);
+            }
+
             // ========== Notification Methods ==========
 
             /**
@@ -252,10 +329,13 @@ namespace pandora
              */
             void NotifyChanged()
             {
-                NotifyObservers([](std::shared_ptr<DataObserver> obs)
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyChanged", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()));
                 {
-                    obs->OnDataSetChanged();
-                });
+                    std::lock_guard<std::mutex> lock(viewport_mutex_);
+                    viewport_filter_.Reset(GetCount());
+                }
+                broadcaster_.OnDataSetChanged();
             }
 
             /**
@@ -263,10 +343,13 @@ namespace pandora
              */
             void NotifyItemChanged(int position)
             {
-                NotifyObservers([position](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemChanged(position);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemChanged", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(1));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeChanged(position, 1, nullptr, broadcaster_);
+                else
+                    broadcaster_.NotifyItemChanged(position);
             }
 
             /**
@@ -274,10 +357,13 @@ namespace pandora
              */
             void NotifyItemChanged(int position, std::shared_ptr<void> payload)
             {
-                NotifyObservers([position, payload](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemChanged(position, payload);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemChanged", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(1));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeChanged(position, 1, payload, broadcaster_);
+                else
+                    broadcaster_.NotifyItemChanged(position, payload);
             }
 
             /**
@@ -285,10 +371,13 @@ namespace pandora
              */
             void NotifyItemRangeChanged(int position_start, int item_count)
             {
-                NotifyObservers([position_start, item_count](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemRangeChanged(position_start, item_count);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemRangeChanged", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(item_count));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeChanged(position_start, item_count, nullptr, broadcaster_);
+                else
+                    broadcaster_.NotifyItemRangeChanged(position_start, item_count);
             }
 
             /**
@@ -296,10 +385,13 @@ namespace pandora
              */
             void NotifyItemRangeChanged(int position_start, int item_count, std::shared_ptr<void> payload)
             {
-                NotifyObservers([position_start, item_count, payload](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemRangeChanged(position_start, item_count, payload);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemRangeChanged", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(item_count));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeChanged(position_start, item_count, payload, broadcaster_);
+                else
+                    broadcaster_.NotifyItemRangeChanged(position_start, item_count, payload);
             }
 
             /**
@@ -307,10 +399,13 @@ namespace pandora
              */
             void NotifyItemInserted(int position)
             {
-                NotifyObservers([position](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemInserted(position);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemInserted", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(1));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeInserted(position, 1, broadcaster_);
+                else
+                    broadcaster_.NotifyItemInserted(position);
             }
 
             /**
@@ -318,10 +413,13 @@ namespace pandora
              */
             void NotifyItemMoved(int from_position, int to_position)
             {
-                NotifyObservers([from_position, to_position](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemMoved(from_position, to_position);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemMoved", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(1));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemMoved(from_position, to_position, broadcaster_);
+                else
+                    broadcaster_.NotifyItemMoved(from_position, to_position);
             }
 
             /**
@@ -329,10 +427,13 @@ namespace pandora
              */
             void NotifyItemRangeInserted(int position_start, int item_count)
             {
-                NotifyObservers([position_start, item_count](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemRangeInserted(position_start, item_count);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemRangeInserted", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(item_count));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeInserted(position_start, item_count, broadcaster_);
+                else
+                    broadcaster_.NotifyItemRangeInserted(position_start, item_count);
             }
 
             /**
@@ -340,10 +441,13 @@ namespace pandora
              */
             void NotifyItemRemoved(int position)
             {
-                NotifyObservers([position](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemRemoved(position);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemRemoved", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(1));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeRemoved(position, 1, broadcaster_);
+                else
+                    broadcaster_.NotifyItemRemoved(position);
             }
 
             /**
@@ -351,10 +455,13 @@ namespace pandora
              */
             void NotifyItemRangeRemoved(int position_start, int item_count)
             {
-                NotifyObservers([position_start, item_count](std::shared_ptr<DataObserver> obs)
-                {
-                    obs->NotifyItemRangeRemoved(position_start, item_count);
-                });
+                PANDORA_TRACE_SPAN(trace_span, "pandora.rv", "NotifyItemRangeRemoved", std::string());
+                PANDORA_TRACE(trace_span.SetSizes(TraceEvent::kNoValue, GetCount()), trace_span.SetEdits(item_count));
+                std::lock_guard<std::mutex> lock(viewport_mutex_);
+                if (viewport_filter_.IsActive())
+                    viewport_filter_.OnItemRangeRemoved(position_start, item_count, broadcaster_);
+                else
+                    broadcaster_.NotifyItemRangeRemoved(position_start, item_count);
             }
 
             /**
@@ -380,6 +487,105 @@ namespace pandora
             DataSet() = default;
 
         private:
+            /**
+             * @brief Forwards every callback to all registered observers
+             *
+             * Lets the ViewportFilter emit into the observer list as if it were a
+             * single observer.
+             */
+            class Broadcaster final : public DataObserver
+            {
+            public:
+                explicit Broadcaster(DataSet* owner) : owner_(owner)
+                {
+                }
+
+                void OnDataSetChanged() override
+                {
+                    owner_->NotifyObservers([](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->OnDataSetChanged();
+                    });
+                }
+
+                void NotifyItemChanged(int position) override
+                {
+                    owner_->NotifyObservers([position](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemChanged(position);
+                    });
+                }
+
+                void NotifyItemChanged(int position, std::shared_ptr<void> payload) override
+                {
+                    owner_->NotifyObservers([position, &payload](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemChanged(position, payload);
+                    });
+                }
+
+                void NotifyItemRangeChanged(int position_start, int item_count) override
+                {
+                    owner_->NotifyObservers([position_start, item_count](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemRangeChanged(position_start, item_count);
+                    });
+                }
+
+                void NotifyItemRangeChanged(int position_start, int item_count,
+                                            std::shared_ptr<void> payload) override
+                {
+                    owner_->NotifyObservers(
+                        [position_start, item_count, &payload](const std::shared_ptr<DataObserver>& obs)
+                        {
+                            obs->NotifyItemRangeChanged(position_start, item_count, payload);
+                        });
+                }
+
+                void NotifyItemInserted(int position) override
+                {
+                    owner_->NotifyObservers([position](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemInserted(position);
+                    });
+                }
+
+                void NotifyItemMoved(int from_position, int to_position) override
+                {
+                    owner_->NotifyObservers([from_position, to_position](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemMoved(from_position, to_position);
+                    });
+                }
+
+                void NotifyItemRangeInserted(int position_start, int item_count) override
+                {
+                    owner_->NotifyObservers([position_start, item_count](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemRangeInserted(position_start, item_count);
+                    });
+                }
+
+                void NotifyItemRemoved(int position) override
+                {
+                    owner_->NotifyObservers([position](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemRemoved(position);
+                    });
+                }
+
+                void NotifyItemRangeRemoved(int position_start, int item_count) override
+                {
+                    owner_->NotifyObservers([position_start, item_count](const std::shared_ptr<DataObserver>& obs)
+                    {
+                        obs->NotifyItemRangeRemoved(position_start, item_count);
+                    });
+                }
+
+            private:
+                DataSet* owner_;
+            };
+
             /**
              * @brief Notify all observers with a given action
              *
@@ -410,6 +616,66 @@ namespace pandora
             DataVhMappingPool mapping_pool_;
             std::vector<std::weak_ptr<DataObserver>> observers_;
             mutable std::mutex observers_mutex_;
+            Broadcaster broadcaster_{this};
+            ViewportFilter viewport_filter_;
+            mutable std::mutex viewport_mutex_;
+        };
+
+        /**
+         * @brief ListUpdateCallback that forwards DiffUtil updates to a DataSet
+         *
+         * Install it on the underlying PandoraBoxAdapter so that
+         * DiffResult::DispatchUpdatesTo goes through DataSet::Notify* and
+         * therefore through the viewport filter.
+         *
+         * @tparam T The data type of the DataSet
+         *
+         * Example:
+         * @code
+         * real_ds->SetListUpdateCallback(
+         *     std::make_unique<DataSetUpdateCallback<MyData>>(rv_data_set.get()));
+         * rv_data_set->SetViewport(first, last, 4);
+         * @endcode
+         */
+        template <typename T>
+        class DataSetUpdateCallback : public ListUpdateCallback
+        {
+        public:
+            explicit DataSetUpdateCallback(DataSet<T>* data_set) : data_set_(data_set)
+            {
+            }
+
+            void OnInserted(int position, int count) override
+            {
+                data_set_->NotifyItemRangeInserted(position, count);
+            }
+
+            void OnRemoved(int position, int count) override
+            {
+                data_set_->NotifyItemRangeRemoved(position, count);
+            }
+
+            void OnMoved(int from_position, int to_position) override
+            {
+                data_set_->NotifyItemMoved(from_position, to_position);
+            }
+
+            void OnChanged(int position, int count, void* payload = nullptr) override
+            {
+                if (payload)
+                {
+                    // Non-owning: the payload only has to live for the duration of the dispatch
+                    data_set_->NotifyItemRangeChanged(position, count,
+                                                      std::shared_ptr<void>(std::shared_ptr<void>(), payload));
+                }
+                else
+                {
+                    data_set_->NotifyItemRangeChanged(position, count);
+                }
+            }
+
+        private:
+            DataSet<T>* data_set_;
         };
     } // namespace rv
 } // namespace pandora
@@ -18,6 +18,7 @@
 #define PANDORA_RV_I_REACTIVE_VIEW_HOLDER_H
 
 #include <memory>
+#include <type_traits>
 #include "i_view_holder.h"
 #include "reactive_data.h"
 #include "../logger.h"
@@ -81,6 +82,23 @@ public:
      * @param property_id The ID of the property that changed
      */
     virtual void OnPropertyChanged(std::shared_ptr<DATA> data, int property_id) = 0;
+
+    /**
+     * @brief Called once for a batch of property changes
+     *
+     * The default implementation forwards every set bit to OnPropertyChanged().
+     * Override it to rebind all changed properties in a single pass.
+     *
+     * @param data The data that changed
+     * @param mask The changed properties, see PropertyBit()
+     */
+    virtual void OnPropertiesChanged(std::shared_ptr<DATA> data, PropertyMask mask) {
+        for (int property_id = 0; mask != 0; ++property_id, mask >>= 1) {
+            if (mask & 1) {
+                OnPropertyChanged(data, property_id);
+            }
+        }
+    }
 };
 
 /**
@@ -170,6 +188,61 @@ void HelpSetToReactiveViewHolder(std::shared_ptr<ReactiveData<DATA>> data,
     view_holder->accept(MAKE_SURE_BIND_VISITOR);
 }
 
+/**
+ * @brief Statically typed variant of HelpSetToReactiveViewHolder
+ *
+ * Takes the concrete data type instead of ReactiveData<DATA>, so neither the
+ * data nor the ViewHolder has to be recovered through accept(),
+ * shared_from_this() or dynamic_pointer_cast. Binds like
+ * HelpSetToReactiveViewHolder: the old data is always unbound and the new
+ * data bound, and null data leaves the holder with its current data.
+ *
+ * @tparam DATA The data type, deriving from ReactiveData<DATA>
+ * @tparam VH The ViewHolder type, deriving from IReactiveViewHolder<DATA>
+ * @param data The data to set
+ * @param view_holder The ViewHolder to set data to
+ *
+ * @note Assumes GetReactiveDataIfExist() returns the data last passed to SetData().
+ */
+template<typename DATA, typename VH>
+void HelpSetToReactiveViewHolderStatic(std::shared_ptr<DATA> data,
+                                       std::shared_ptr<VH> view_holder) {
+    static_assert(std::is_base_of<ReactiveData<DATA>, DATA>::value,
+                  "DATA must inherit from ReactiveData<DATA>");
+    static_assert(std::is_base_of<IReactiveViewHolder<DATA>, VH>::value,
+                  "VH must inherit from IReactiveViewHolder<DATA>");
+
+    if (!view_holder) {
+        return;
+    }
+
+    // Ensure unbind from old data
+    const std::shared_ptr<ReactiveData<DATA>> old_binding = view_holder->GetReactiveDataIfExist();
+    if (old_binding) {
+        old_binding->UnbindReactiveVh();
+    }
+
+    // Set and bind the new data; without one the holder stays bound to its current data
+    if (data) {
+        view_holder->SetData(data);
+        data->BindReactiveVh(view_holder);
+    } else if (old_binding) {
+        old_binding->BindReactiveVh(view_holder);
+    }
+}
+
+/**
+ * @brief Statically typed bind for callers holding a ReactiveData<DATA>
+ *
+ * ReactiveData<DATA> is only ever a base of DATA, so the downcast needs no RTTI.
+ */
+template<typename DATA, typename VH>
+void HelpSetToReactiveViewHolderStatic(std::shared_ptr<ReactiveData<DATA>> data,
+                                       std::shared_ptr<VH> view_holder) {
+    HelpSetToReactiveViewHolderStatic<DATA, VH>(std::static_pointer_cast<DATA>(std::move(data)),
+                                                std::move(view_holder));
+}
+
 } // namespace rv
 } // namespace pandora
 
@@ -133,6 +133,23 @@ protected:
     IViewHolderVisitor() = default;
 };
 
+namespace detail {
+
+template<typename DATA>
+struct DataTypeKey {
+    static constexpr char id = 0;
+};
+
+} // namespace detail
+
+/**
+ * @brief Get the key of DATA, unique per type
+ */
+template<typename DATA>
+const void* DataTypeKeyOf() {
+    return &detail::DataTypeKey<DATA>::id;
+}
+
 /**
  * @brief Type-erased ViewHolder wrapper
  *
@@ -150,6 +167,14 @@ public:
     virtual void OnViewDetachedFromWindow() = 0;
     virtual void accept(IViewHolderVisitor& visitor) = 0;
 
+    /**
+     * @brief Identity of the data type bound by this holder, nullptr if unknown
+     *
+     * ViewHolderWrapper<DATA> returns DataTypeKeyOf<DATA>(), which lets callers
+     * check the wrapper type before a static_cast without RTTI.
+     */
+    virtual const void* GetDataTypeKey() const { return nullptr; }
+
 protected:
     IViewHolderBase() = default;
 };
@@ -178,6 +203,10 @@ public:
         if (holder_) holder_->accept(visitor);
     }
 
+    const void* GetDataTypeKey() const override {
+        return DataTypeKeyOf<DATA>();
+    }
+
     std::shared_ptr<IViewHolder<DATA>> GetHolder() const {
         return holder_;
     }
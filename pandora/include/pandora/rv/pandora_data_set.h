@@ -80,8 +80,9 @@ public:
 
     std::shared_ptr<T> GetItem(int position) const override {
         T* raw_ptr = data_set_->GetDataByIndex(position);
-        // Non-owning shared_ptr for compatibility with DataSet interface
-        return raw_ptr ? std::shared_ptr<T>(raw_ptr, [](T*){}) : nullptr;
+        // Non-owning shared_ptr for compatibility with DataSet interface; aliasing
+        // an empty owner needs no control block, so no allocation
+        return std::shared_ptr<T>(std::shared_ptr<T>(), raw_ptr);
     }
 
     // ========== PandoraBoxAdapter Delegation ==========
@@ -17,12 +17,25 @@
 #ifndef PANDORA_RV_REACTIVE_DATA_H
 #define PANDORA_RV_REACTIVE_DATA_H
 
+#include <cstdint>
 #include <memory>
 #include "data_set.h"
 
 namespace pandora {
 namespace rv {
 
+/**
+ * @brief A set of property ids, one bit per id in [0, 64)
+ */
+using PropertyMask = uint64_t;
+
+/**
+ * @brief Get the mask bit of a property id, or 0 for ids outside [0, 64)
+ */
+constexpr PropertyMask PropertyBit(int property_id) {
+    return (property_id >= 0 && property_id < 64) ? (PropertyMask(1) << property_id) : 0;
+}
+
 // Forward declaration
 template<typename DA>
 class IReactiveViewHolder;
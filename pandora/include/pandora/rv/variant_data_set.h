@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 leobert-lan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ */
+
+#ifndef PANDORA_RV_VARIANT_DATA_SET_H
+#define PANDORA_RV_VARIANT_DATA_SET_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include "pandora_real_rv_data_set.h"
+#include "view_holder_creator.h"
+#include "../pandora_exception.h"
+
+namespace pandora {
+namespace rv {
+
+namespace detail {
+
+template<typename U, typename... Ts>
+struct VariantIndexOf;
+
+template<typename U, typename... Ts>
+struct VariantIndexOf<U, U, Ts...> : std::integral_constant<std::size_t, 0> {};
+
+template<typename U, typename T, typename... Ts>
+struct VariantIndexOf<U, T, Ts...>
+    : std::integral_constant<std::size_t, 1 + VariantIndexOf<U, Ts...>::value> {};
+
+} // namespace detail
+
+/**
+ * @brief Multi-type DataSet storing items by value in a std::variant
+ *
+ * Items live contiguously in a RealDataSet<std::variant<Ts...>>, so there is
+ * no heap allocation per item and no Data hierarchy. The view type of an item
+ * is its variant::index(), and binding dispatches with std::visit to the
+ * holder registered for that alternative.
+ *
+ * @tparam Ts The item types; each must be unique and provide operator== and
+ *            a ContentHasher (e.g. a Hash() member)
+ *
+ * Example:
+ * @code
+ * VariantDataSet<TextItem, ImageItem> data_set;
+ * data_set.RegisterViewHolder<TextItem>(make_lambda_creator<TextItem>(
+ *     [](void* parent) { return std::make_shared<TextViewHolder>(parent); }));
+ * data_set.RegisterViewHolder<ImageItem>(make_lambda_creator<ImageItem>(
+ *     [](void* parent) { return std::make_shared<ImageViewHolder>(parent); }));
+ *
+ * data_set.Add(TextItem{"title"});
+ * data_set.Add(ImageItem{"cover.png"});
+ *
+ * int view_type = data_set.GetItemViewType(1);
+ * auto holder = data_set.CreateViewHolder(parent, view_type);
+ * data_set.BindViewHolder(1, *holder);
+ * @endcode
+ *
+ * @note Items are stored without a heap allocation each; binding hands the
+ *       holder an owning copy of the item, which it may keep.
+ */
+template<typename... Ts>
+class VariantDataSet : public PandoraRealRvDataSet<std::variant<Ts...>> {
+public:
+    using ValueType = std::variant<Ts...>;
+
+    static constexpr int VIEW_TYPE_COUNT = static_cast<int>(sizeof...(Ts));
+
+    VariantDataSet()
+        : VariantDataSet(std::make_shared<RealDataSet<ValueType>>()) {}
+
+    explicit VariantDataSet(std::shared_ptr<RealDataSet<ValueType>> real_data_set)
+        : PandoraRealRvDataSet<ValueType>(std::move(real_data_set)) {}
+
+    /**
+     * @brief Get the view type of alternative U
+     */
+    template<typename U>
+    static constexpr int ViewTypeOf() {
+        return static_cast<int>(detail::VariantIndexOf<U, Ts...>::value);
+    }
+
+    /**
+     * @brief Register the ViewHolder creator for alternative U
+     *
+     * The creator must produce a ViewHolderWrapper<U>, as make_lambda_creator<U>()
+     * and make_typed_creator<U, VH>() do.
+     */
+    template<typename U>
+    VariantDataSet& RegisterViewHolder(std::shared_ptr<ViewHolderCreator> creator) {
+        creators_[ViewTypeOf<U>()] = std::move(creator);
+        return *this;
+    }
+
+    /**
+     * @brief Get the view type at position, which is the variant index of the item
+     */
+    int GetItemViewType(int position) {
+        const ValueType* item = this->data_set_->GetDataByIndex(position);
+        if (!item) {
+            throw PandoraException("Data at position " + std::to_string(position) + " is null");
+        }
+        return static_cast<int>(item->index());
+    }
+
+    int GetViewTypeCount() const {
+        return VIEW_TYPE_COUNT;
+    }
+
+    std::shared_ptr<IViewHolderBase> CreateViewHolder(void* parent, int view_type) {
+        if (view_type < 0 || view_type >= VIEW_TYPE_COUNT || !creators_[view_type]) {
+            throw PandoraException("No creator found for view type: " + std::to_string(view_type));
+        }
+        return creators_[view_type]->CreateViewHolder(parent);
+    }
+
+    /**
+     * @brief Bind the item at position to a holder created for its view type
+     *
+     * @param position The adapter position
+     * @param holder A holder returned by CreateViewHolder() for GetItemViewType(position)
+     * @throws PandoraException if holder was created for another view type
+     */
+    void BindViewHolder(int position, IViewHolderBase& holder) {
+        ValueType* item = this->data_set_->GetDataByIndex(position);
+        if (!item) {
+            throw PandoraException("Data at position " + std::to_string(position) + " is null");
+        }
+        std::visit([&holder, position](const auto& value) {
+            using U = std::decay_t<decltype(value)>;
+            if (holder.GetDataTypeKey() != DataTypeKeyOf<U>()) {
+                throw PandoraException("ViewHolder does not bind the view type of position " +
+                                       std::to_string(position));
+            }
+            auto& wrapper = static_cast<ViewHolderWrapper<U>&>(holder);
+            if (auto typed_holder = wrapper.GetHolder()) {
+                // Holders may keep the data, so they get their own copy
+                typed_holder->SetData(std::make_shared<U>(value));
+            }
+        }, *item);
+    }
+
+    /**
+     * @brief Visit the item at position with a callable accepting every alternative
+     */
+    template<typename Visitor>
+    decltype(auto) VisitItem(int position, Visitor&& visitor) {
+        ValueType* item = this->data_set_->GetDataByIndex(position);
+        if (!item) {
+            throw PandoraException("Data at position " + std::to_string(position) + " is null");
+        }
+        return std::visit(std::forward<Visitor>(visitor), *item);
+    }
+
+private:
+    std::array<std::shared_ptr<ViewHolderCreator>, sizeof...(Ts)> creators_;
+};
+
+} // namespace rv
+} // namespace pandora
+
+#endif // PANDORA_RV_VARIANT_DATA_SET_H
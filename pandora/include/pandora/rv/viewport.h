@@ -0,0 +1,309 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 leobert-lan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ */
+
+#ifndef PANDORA_RV_VIEWPORT_H
+#define PANDORA_RV_VIEWPORT_H
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include "data_observer.h"
+
+namespace pandora {
+namespace rv {
+
+/**
+ * @brief The range of positions currently shown by the host view
+ *
+ * Positions within [first_visible - prefetch, last_visible + prefetch] form the
+ * "window": rows that are bound or about to be bound and therefore need precise
+ * notifications. Everything else is off-screen.
+ */
+struct Viewport {
+    static constexpr int NO_POSITION = -1;
+
+    int first_visible = NO_POSITION;
+    int last_visible = NO_POSITION;
+    int prefetch = 0;
+
+    bool IsValid() const {
+        return first_visible >= 0 && last_visible >= first_visible;
+    }
+
+    int WindowStart() const {
+        return std::max(0, first_visible - prefetch);
+    }
+
+    int WindowEnd() const {
+        return last_visible + prefetch;
+    }
+
+    bool Contains(int position) const {
+        return IsValid() && position >= WindowStart() && position <= WindowEnd();
+    }
+};
+
+/**
+ * @brief Filters DataSet notifications against a Viewport
+ *
+ * Changes that touch the window are forwarded precisely. Changes outside of it
+ * are collapsed into two dirty spans, one before and one after the window, each
+ * made of the lowest affected position and the net count delta. A span is flushed
+ * as at most one insert/remove plus one range change, so thousands of off-screen
+ * updates cost the observer a handful of calls, and the stale rows are rebound
+ * lazily when they scroll into view.
+ *
+ * Positions handed to this class follow the usual sequential notification
+ * contract: each one is relative to the list after all previous notifications.
+ *
+ * @note Not thread-safe; DataSet serializes access to it.
+ */
+class ViewportFilter {
+public:
+    /**
+     * @brief Whether a viewport is installed and notifications are being filtered
+     */
+    bool IsActive() const {
+        return viewport_.IsValid();
+    }
+
+    const Viewport& GetViewport() const {
+        return viewport_;
+    }
+
+    /**
+     * @brief Install a new viewport, flushing whatever was deferred for the old one
+     *
+     * @param viewport The new viewport; an invalid one disables filtering
+     * @param item_count The current item count of the data set
+     * @param out Receives the flushed notifications
+     */
+    void SetViewport(const Viewport& viewport, int item_count, DataObserver& out) {
+        Flush(out);
+        viewport_ = viewport;
+        count_ = item_count;
+    }
+
+    /**
+     * @brief Whether any off-screen change is waiting to be flushed
+     */
+    bool HasDeferredUpdates() const {
+        return before_.IsDirty() || after_.IsDirty();
+    }
+
+    /**
+     * @brief Whether the row at position may be stale because of a deferred change
+     *
+     * Binders can check this before binding a prefetched row and flush first.
+     */
+    bool IsDeferred(int position) const {
+        if (before_.IsDirty() && position >= before_.start && position < viewport_.WindowStart()) {
+            return true;
+        }
+        return after_.IsDirty() && position >= after_.start;
+    }
+
+    /**
+     * @brief Forward every deferred change to out
+     */
+    void Flush(DataObserver& out) {
+        FlushBefore(out);
+        FlushAfter(out);
+    }
+
+    /**
+     * @brief Drop deferred state after the observers have been told to reload everything
+     */
+    void Reset(int item_count) {
+        before_ = DirtySpan();
+        after_ = DirtySpan();
+        count_ = item_count;
+    }
+
+    void OnItemRangeChanged(int position_start, int item_count,
+                            const std::shared_ptr<void>& payload, DataObserver& out) {
+        if (item_count <= 0) return;
+        const int end = position_start + item_count;
+        const int window_start = viewport_.WindowStart();
+        const int window_end = viewport_.WindowEnd() + 1;
+
+        if (position_start < window_start) {
+            before_.Touch(position_start);
+        }
+        if (end > window_end) {
+            after_.Touch(std::max(position_start, window_end));
+        }
+
+        const int visible_start = std::max(position_start, window_start);
+        const int visible_end = std::min(end, window_end);
+        if (visible_start < visible_end) {
+            PrepareForPrecise(visible_end, out);
+            EmitChanged(visible_start, visible_end - visible_start, payload, out);
+        }
+    }
+
+    void OnItemRangeInserted(int position_start, int item_count, DataObserver& out) {
+        if (item_count <= 0) return;
+        count_ += item_count;
+
+        if (position_start < viewport_.WindowStart()) {
+            before_.Touch(position_start);
+            before_.delta += item_count;
+            ShiftAfter(position_start, item_count);
+            viewport_.first_visible += item_count;
+            viewport_.last_visible += item_count;
+        } else if (position_start > viewport_.WindowEnd()) {
+            after_.Touch(position_start);
+            after_.delta += item_count;
+        } else {
+            PrepareForPrecise(position_start + 1, out);
+            ShiftAfter(position_start, item_count);
+            EmitInserted(position_start, item_count, out);
+        }
+    }
+
+    void OnItemRangeRemoved(int position_start, int item_count, DataObserver& out) {
+        if (item_count <= 0) return;
+        const int end = position_start + item_count;
+        const int window_start = viewport_.WindowStart();
+        const int window_end = viewport_.WindowEnd() + 1;
+
+        // Split into after, window and before parts, removed back to front so the
+        // positions of the remaining parts stay valid.
+        const int after_start = std::max(position_start, window_end);
+        if (end > after_start) {
+            const int removed = end - after_start;
+            after_.Touch(after_start);
+            after_.delta -= removed;
+            count_ -= removed;
+        }
+
+        const int visible_start = std::max(position_start, window_start);
+        const int visible_end = std::min(end, window_end);
+        if (visible_start < visible_end) {
+            const int removed = visible_end - visible_start;
+            PrepareForPrecise(visible_end, out);
+            ShiftAfter(visible_start, -removed);
+            count_ -= removed;
+            EmitRemoved(visible_start, removed, out);
+        }
+
+        const int before_end = std::min(end, window_start);
+        if (position_start < before_end) {
+            const int removed = before_end - position_start;
+            before_.Touch(position_start);
+            before_.delta -= removed;
+            ShiftAfter(position_start, -removed);
+            viewport_.first_visible = std::max(0, viewport_.first_visible - removed);
+            viewport_.last_visible = std::max(viewport_.first_visible, viewport_.last_visible - removed);
+            count_ -= removed;
+        }
+    }
+
+    void OnItemMoved(int from_position, int to_position, DataObserver& out) {
+        if (viewport_.Contains(from_position) && viewport_.Contains(to_position)) {
+            PrepareForPrecise(std::max(from_position, to_position) + 1, out);
+            out.NotifyItemMoved(from_position, to_position);
+            return;
+        }
+        // A move across the window boundary is a removal followed by an insertion.
+        OnItemRangeRemoved(from_position, 1, out);
+        OnItemRangeInserted(to_position, 1, out);
+    }
+
+private:
+    struct DirtySpan {
+        int start = INT_MAX;  // Lowest affected position, in current coordinates
+        int delta = 0;        // Net number of rows inserted (positive) or removed (negative)
+
+        bool IsDirty() const {
+            return start != INT_MAX;
+        }
+
+        void Touch(int position) {
+            start = std::min(start, position);
+        }
+    };
+
+    // Observers must agree with us on every position up to precise_end before a
+    // precise notification can be forwarded.
+    void PrepareForPrecise(int precise_end, DataObserver& out) {
+        FlushBefore(out);
+        if (after_.IsDirty() && after_.start < precise_end) {
+            FlushAfter(out);
+        }
+    }
+
+    void ShiftAfter(int position, int delta) {
+        if (after_.IsDirty() && after_.start >= position) {
+            after_.start = std::max(position, after_.start + delta);
+        }
+    }
+
+    void FlushBefore(DataObserver& out) {
+        if (!before_.IsDirty()) return;
+        const DirtySpan span = before_;
+        before_ = DirtySpan();
+        EmitSpan(span, std::max(span.start, viewport_.WindowStart()), out);
+    }
+
+    void FlushAfter(DataObserver& out) {
+        if (!after_.IsDirty()) return;
+        const DirtySpan span = after_;
+        after_ = DirtySpan();
+        EmitSpan(span, count_, out);
+    }
+
+    static void EmitSpan(const DirtySpan& span, int span_end, DataObserver& out) {
+        if (span.delta > 0) {
+            EmitInserted(span.start, span.delta, out);
+        } else if (span.delta < 0) {
+            EmitRemoved(span.start, -span.delta, out);
+        }
+        if (span_end > span.start) {
+            EmitChanged(span.start, span_end - span.start, nullptr, out);
+        }
+    }
+
+    // Single rows keep using the single-item callbacks, as an unfiltered DataSet would.
+    static void EmitChanged(int position, int count, const std::shared_ptr<void>& payload,
+                            DataObserver& out) {
+        if (count == 1) {
+            payload ? out.NotifyItemChanged(position, payload) : out.NotifyItemChanged(position);
+        } else {
+            payload ? out.NotifyItemRangeChanged(position, count, payload)
+                    : out.NotifyItemRangeChanged(position, count);
+        }
+    }
+
+    static void EmitInserted(int position, int count, DataObserver& out) {
+        count == 1 ? out.NotifyItemInserted(position) : out.NotifyItemRangeInserted(position, count);
+    }
+
+    static void EmitRemoved(int position, int count, DataObserver& out) {
+        count == 1 ? out.NotifyItemRemoved(position) : out.NotifyItemRangeRemoved(position, count);
+    }
+
+    Viewport viewport_;
+    DirtySpan before_;
+    DirtySpan after_;
+    int count_ = 0;  // Item count as of the last notification seen
+};
+
+} // namespace rv
+} // namespace pandora
+
+#endif // PANDORA_RV_VIEWPORT_H
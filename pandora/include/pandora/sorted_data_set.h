@@ -0,0 +1,524 @@
+#ifndef PANDORA_SORTED_DATA_SET_H_
+#define PANDORA_SORTED_DATA_SET_H_
+
+#include "pandora_box_adapter.h"
+#include "pandora_traits.h"
+#include "diff_util.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+namespace pandora
+{
+    /**
+     * @brief A data set kept sorted by Compare, similar to Android's SortedList
+     *
+     * Single-item operations locate their position by binary search and report
+     * precise updates instead of diffing: Add() inserts (or replaces an item
+     * that is the same by Pandora::Equals and sorts equal), UpdateItemAt()
+     * repositions an item whose sort key changed and reports a move, and
+     * IndexOf()/Remove() run in O(log N). AddAll() sorts the batch and merges
+     * it linearly. Inside a transaction the data set falls back to the usual
+     * snapshot and diff, like RealDataSet.
+     *
+     * It is a regular PandoraBoxAdapter and can be added to a WrapperDataSet.
+     *
+     * @tparam T The data type
+     * @tparam Compare Strict weak ordering of T
+     *
+     * Example:
+     * @code
+     * struct ByTimestamp {
+     *     bool operator()(const Message& a, const Message& b) const { return a.timestamp > b.timestamp; }
+     * };
+     * SortedDataSet<Message, ByTimestamp> messages;
+     * messages.AddAll(page);
+     * messages.UpdateItemAt(messages.IndexOf(edited), edited_with_new_timestamp);
+     * @endcode
+     *
+     * @note Add(pos, item) cannot honour the position; the item is inserted in order.
+     */
+    template <typename T, typename Compare = std::less<T>>
+    class SortedDataSet final : public PandoraBoxAdapter<T>
+    {
+    public:
+        explicit SortedDataSet(Compare compare = Compare()) : compare_(std::move(compare))
+        {
+        }
+
+        [[nodiscard]] int GetDataCount() const override { return static_cast<int>(data_.size()); }
+
+        T* GetDataByIndex(int index) override
+        {
+            if (index < 0 || index >= static_cast<int>(data_.size())) return nullptr;
+            return &data_[index];
+        }
+
+        void ClearAllData() override
+        {
+            const int count = GetDataCount();
+            if (count == 0) return;
+            BeginChange();
+            data_.clear();
+            EndChange([count](ListUpdateCallback* callback) { callback->OnRemoved(0, count); });
+        }
+
+        /**
+         * @brief Insert item in order, or replace the same item if it sorts equal
+         */
+        void Add(const T& item) override
+        {
+            const auto range = std::equal_range(data_.begin(), data_.end(), item, compare_);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (Pandora::Equals(*it, item))
+                {
+                    const int index = static_cast<int>(it - data_.begin());
+                    if (Pandora::Hash(*it) == Pandora::Hash(item)) return;
+                    BeginChange();
+                    *it = item;
+                    EndChange([index](ListUpdateCallback* callback) { callback->OnChanged(index, 1, nullptr); });
+                    return;
+                }
+            }
+
+            const int index = static_cast<int>(range.second - data_.begin());
+            BeginChange();
+            data_.insert(range.second, item);
+            EndChange([index](ListUpdateCallback* callback) { callback->OnInserted(index, 1); });
+        }
+
+        void Add(int pos, const T& item) override
+        {
+            Logger::Println(Logger::WARN, "SortedDataSet", "add at position is not supported, inserting in order");
+            Add(item);
+        }
+
+        /**
+         * @brief Sort the batch and merge it into the data in one linear pass
+         */
+        void AddAll(const std::vector<T>& collection) override
+        {
+            if (collection.empty()) return;
+
+            std::vector<T> batch(collection);
+            std::stable_sort(batch.begin(), batch.end(), compare_);
+
+            std::vector<T> merged;
+            merged.reserve(data_.size() + batch.size());
+            std::vector<std::pair<bool, int>> runs;  // (inserted, start) of every touched position
+
+            size_t i = 0;
+            size_t j = 0;
+            while (i < data_.size() || j < batch.size())
+            {
+                if (j == batch.size() || (i < data_.size() && compare_(data_[i], batch[j])))
+                {
+                    merged.push_back(data_[i++]);  // Copied: data_ is untouched until BeginChange()
+                }
+                else if (i == data_.size() || compare_(batch[j], data_[i]))
+                {
+                    runs.emplace_back(true, static_cast<int>(merged.size()));
+                    merged.push_back(batch[j++]);
+                }
+                else
+                {
+                    MergeEqualGroup(i, batch, j, merged, runs);
+                }
+            }
+
+            // Only identical items: nothing changed, as in UpdateItemAt()
+            if (runs.empty()) return;
+            BeginChange();
+            data_.swap(merged);
+            EndChange([&runs](ListUpdateCallback* callback)
+            {
+                // Final positions, reported front to back: each insertion is already in place
+                // for the ones after it, so runs of consecutive positions merge.
+                size_t k = 0;
+                while (k < runs.size())
+                {
+                    size_t end = k + 1;
+                    while (end < runs.size() && runs[end].first == runs[k].first &&
+                        runs[end].second == runs[end - 1].second + 1)
+                    {
+                        ++end;
+                    }
+                    const int count = static_cast<int>(end - k);
+                    if (runs[k].first) callback->OnInserted(runs[k].second, count);
+                    else callback->OnChanged(runs[k].second, count, nullptr);
+                    k = end;
+                }
+            });
+        }
+
+        void Remove(const T& item) override
+        {
+            const int index = IndexOf(item);
+            if (index >= 0) RemoveAtPos(index);
+        }
+
+        void RemoveAtPos(int position) override
+        {
+            if (position < 0 || position >= static_cast<int>(data_.size())) return;
+            BeginChange();
+            data_.erase(data_.begin() + position);
+            EndChange([position](ListUpdateCallback* callback) { callback->OnRemoved(position, 1); });
+        }
+
+        /**
+         * @brief Replace the item at position and move it to where it now sorts
+         *
+         * Reports a move when the sort key changed, and a change when the content did.
+         *
+         * @return The new position of the item, or -1 if position is out of range
+         */
+        int UpdateItemAt(int position, const T& item)
+        {
+            if (position < 0 || position >= static_cast<int>(data_.size())) return -1;
+
+            const bool changed = !Pandora::Equals(data_[position], item) ||
+                Pandora::Hash(data_[position]) != Pandora::Hash(item);
+
+            // Find the new position among the other items
+            int target = position;
+            if (position > 0 && compare_(item, data_[position - 1]))
+            {
+                target = static_cast<int>(std::upper_bound(data_.begin(), data_.begin() + position, item, compare_) -
+                    data_.begin());
+            }
+            else if (position + 1 < static_cast<int>(data_.size()) && compare_(data_[position + 1], item))
+            {
+                target = static_cast<int>(std::lower_bound(data_.begin() + position + 1, data_.end(), item, compare_) -
+                    data_.begin()) - 1;
+            }
+
+            if (target == position && !changed) return position;
+
+            BeginChange();
+            data_[position] = item;
+            if (target < position)
+            {
+                std::rotate(data_.begin() + target, data_.begin() + position, data_.begin() + position + 1);
+            }
+            else if (target > position)
+            {
+                std::rotate(data_.begin() + position, data_.begin() + position + 1, data_.begin() + target + 1);
+            }
+            EndChange([position, target, changed](ListUpdateCallback* callback)
+            {
+                if (target != position) callback->OnMoved(position, target);
+                if (changed) callback->OnChanged(target, 1, nullptr);
+            });
+            return target;
+        }
+
+        bool ReplaceAtPosIfExist(int position, const T& item) override
+        {
+            return UpdateItemAt(position, item) >= 0;
+        }
+
+        /**
+         * @brief Replace all items; the collection does not need to be sorted
+         */
+        void SetData(const std::vector<T>& collection) override
+        {
+            OnBeforeChanged();
+            data_ = collection;
+            std::stable_sort(data_.begin(), data_.end(), compare_);
+            OnAfterChanged();
+        }
+
+        /**
+         * @brief Binary search for an item that sorts equal and is the same by Pandora::Equals
+         */
+        int IndexOf(const T& item) const override
+        {
+            const auto range = std::equal_range(data_.begin(), data_.end(), item, compare_);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (Pandora::Equals(*it, item)) return static_cast<int>(it - data_.begin());
+            }
+            return -1;
+        }
+
+        // Node interface implementation
+        [[nodiscard]] int GetGroupIndex() const override { return group_index_; }
+        void SetGroupIndex(int group_index) override { group_index_ = group_index; }
+
+        void AddChild(std::unique_ptr<PandoraBoxAdapter<T>> sub) override
+        {
+            throw PandoraException("SortedDataSet does not support AddChild");
+        }
+
+        [[nodiscard]] bool HasBindToParent() const override { return parent_ != nullptr; }
+
+        void RemoveFromOriginalParent() override
+        {
+            if (parent_)
+            {
+                parent_->RemoveChild(this);
+                parent_ = nullptr;
+            }
+        }
+
+        void RemoveChild(PandoraBoxAdapter<T>* sub) override
+        {
+            throw PandoraException("SortedDataSet does not support RemoveChild");
+        }
+
+        // Index management
+        [[nodiscard]] int GetStartIndex() const override { return start_index_; }
+        void SetStartIndex(const int start_index) override { start_index_ = start_index; }
+
+        PandoraBoxAdapter<T>* RetrieveAdapterByDataIndex(const int index) override
+        {
+            if (0 <= index && index < GetDataCount())
+                return this;
+            return nullptr;
+        }
+
+        std::pair<PandoraBoxAdapter<T>*, int> RetrieveAdapterByDataIndex2(int index) override
+        {
+            auto temp = RetrieveAdapterByDataIndex(index);
+            if (temp == nullptr)
+                return {nullptr, -1};
+
+            return {temp, index};
+        }
+
+        // Parent-child relationship notifications
+        void NotifyHasAddToParent(PandoraBoxAdapter<T>* parent) override
+        {
+            parent_ = parent;
+        }
+
+        void NotifyHasRemoveFromParent() override
+        {
+            parent_ = nullptr;
+        }
+
+        PandoraBoxAdapter<T>* GetParent() override { return parent_; }
+
+        // Alias support
+        PandoraBoxAdapter<T>* FindByAlias(const std::string& target_alias) override
+        {
+            if (target_alias.empty()) return nullptr;
+            if (this->GetAlias() == target_alias) return this;
+            return nullptr;
+        }
+
+        bool IsAliasConflict(const std::string& alias) override
+        {
+            return this->GetAlias() == alias;
+        }
+
+        // Transaction support
+        void StartTransaction() override
+        {
+            use_transaction_ = true;
+            Snapshot();
+        }
+
+        void EndTransaction() override
+        {
+            use_transaction_ = false;
+            CalcChangeAndNotify();
+        }
+
+        void EndTransactionSilently() override
+        {
+            use_transaction_ = false;
+        }
+
+        [[nodiscard]] bool InTransaction() const override
+        {
+            return use_transaction_ || IsParentInTransaction();
+        }
+
+    protected:
+        void OnBeforeChanged() override
+        {
+            if (!InTransaction())
+            {
+                Snapshot();
+            }
+            if (parent_)
+            {
+                parent_->OnBeforeChanged();
+            }
+        }
+
+        void RebuildSubNodes() override
+        {
+        }
+
+        void OnAfterChanged() override
+        {
+            if (parent_)
+            {
+                parent_->OnAfterChanged();
+            }
+            if (!InTransaction())
+            {
+                CalcChangeAndNotify();
+            }
+        }
+
+        void Restore() override
+        {
+            data_.assign(old_data_.begin(), old_data_.end());
+        }
+
+    private:
+        /**
+         * @brief Merge the items of data_ and batch that sort equal to batch[j]
+         *
+         * As with Add() one by one: a batch item replaces the same item
+         * anywhere in the group, or goes after the group.
+         */
+        void MergeEqualGroup(size_t& i, const std::vector<T>& batch, size_t& j, std::vector<T>& merged,
+                             std::vector<std::pair<bool, int>>& runs)
+        {
+            std::vector<T> group;
+            std::vector<size_t> origins;  // Index in data_, or npos for an inserted item
+            const size_t npos = static_cast<size_t>(-1);
+            for (; i < data_.size() && !compare_(batch[j], data_[i]); ++i)
+            {
+                group.push_back(data_[i]);
+                origins.push_back(i);
+            }
+
+            const T& key = batch[j];
+            for (; j < batch.size() && !compare_(key, batch[j]); ++j)
+            {
+                size_t k = 0;
+                while (k < group.size() && !Pandora::Equals(group[k], batch[j])) ++k;
+                if (k == group.size())
+                {
+                    group.push_back(batch[j]);
+                    origins.push_back(npos);
+                }
+                else
+                {
+                    group[k] = batch[j];
+                }
+            }
+
+            for (size_t k = 0; k < group.size(); ++k)
+            {
+                if (origins[k] == npos)
+                {
+                    runs.emplace_back(true, static_cast<int>(merged.size()));
+                }
+                else if (Pandora::Hash(data_[origins[k]]) != Pandora::Hash(group[k]))
+                {
+                    runs.emplace_back(false, static_cast<int>(merged.size()));
+                }
+                merged.push_back(std::move(group[k]));
+            }
+        }
+
+        // Precise counterpart of OnBeforeChanged(): no snapshot is needed outside transactions
+        void BeginChange()
+        {
+            if (parent_)
+            {
+                parent_->OnBeforeChanged();
+            }
+        }
+
+        // Precise counterpart of OnAfterChanged()
+        template <typename Dispatch>
+        void EndChange(const Dispatch& dispatch)
+        {
+            if (parent_)
+            {
+                parent_->OnAfterChanged();
+            }
+            if (!InTransaction())
+            {
+                if (auto callback = PandoraBoxAdapter<T>::GetListUpdateCallback())
+                {
+                    dispatch(callback);
+                    callback->OnUpdatesDispatched();
+                }
+            }
+        }
+
+        // DiffCallback implementation for change detection
+        class DiffCallbackImpl : public DiffCallback {
+        private:
+            SortedDataSet* dataset_;
+            const std::vector<T>& old_list_;
+            const std::vector<size_t>& old_hashes_;
+
+        public:
+            DiffCallbackImpl(SortedDataSet* dataset,
+                           const std::vector<T>& old_list,
+                           const std::vector<size_t>& old_hashes)
+                : dataset_(dataset), old_list_(old_list), old_hashes_(old_hashes) {}
+
+            int GetOldListSize() const override {
+                return static_cast<int>(old_list_.size());
+            }
+
+            int GetNewListSize() const override {
+                return dataset_->GetDataCount();
+            }
+
+            bool AreItemsTheSame(int old_item_position, int new_item_position) const override {
+                const T* new_item = dataset_->GetDataByIndex(new_item_position);
+                if (old_item_position >= static_cast<int>(old_list_.size()) || new_item == nullptr) return false;
+                return Pandora::Equals(old_list_[old_item_position], *new_item);
+            }
+
+            bool AreContentsTheSame(int old_item_position, int new_item_position) const override {
+                if (!AreItemsTheSame(old_item_position, new_item_position)) return false;
+                const T* new_item = dataset_->GetDataByIndex(new_item_position);
+                return old_hashes_[old_item_position] == Pandora::Hash(*new_item);
+            }
+        };
+
+        void Snapshot()
+        {
+            old_data_.assign(data_.begin(), data_.end());
+            old_data_hashes_.clear();
+            old_data_hashes_.reserve(data_.size());
+            for (const auto& item : data_)
+            {
+                old_data_hashes_.push_back(Pandora::Hash(item));
+            }
+        }
+
+        // Calculate changes and notify observers
+        void CalcChangeAndNotify()
+        {
+            if (auto callback = PandoraBoxAdapter<T>::GetListUpdateCallback())
+            {
+                DiffCallbackImpl diff_callback(this, old_data_, old_data_hashes_);
+                const auto result = DiffUtil::CalculateDiff(&diff_callback);
+                if (result)
+                {
+                    if (auto ref = result.get()) ref->DispatchUpdatesTo(callback);
+                }
+            }
+        }
+
+        [[nodiscard]] bool IsParentInTransaction() const
+        {
+            return parent_ != nullptr && parent_->InTransaction();
+        }
+
+        Compare compare_;
+        std::vector<T> data_;
+        std::vector<T> old_data_; // Snapshot for transaction rollback
+        std::vector<size_t> old_data_hashes_; // Snapshot of content hashes
+        bool use_transaction_ = false;
+        int group_index_ = Node<PandoraBoxAdapter<T>>::kNoGroupIndex;
+        int start_index_ = 0;
+        PandoraBoxAdapter<T>* parent_ = nullptr;
+    };
+} // namespace pandora
+
+#endif  // PANDORA_SORTED_DATA_SET_H_
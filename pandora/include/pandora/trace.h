@@ -0,0 +1,283 @@
+#ifndef PANDORA_TRACE_H_
+#define PANDORA_TRACE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief One completed span, fixed-size so recording never allocates
+     */
+    struct TraceEvent
+    {
+        static constexpr int kAliasCapacity = 32;
+        static constexpr int64_t kNoValue = -1;
+
+        const char* category = "";
+        const char* name = "";
+        uint64_t start_nanos = 0;
+        uint64_t duration_nanos = 0;
+        uint32_t thread_id = 0;
+        char alias[kAliasCapacity] = {};  // Truncated, always terminated
+        int64_t old_size = kNoValue;
+        int64_t new_size = kNoValue;
+        int64_t edits = kNoValue;
+    };
+
+    /**
+     * @brief Lock-free ring buffer of the most recent trace events
+     *
+     * Writers claim a slot with one atomic increment and publish it with a
+     * per-slot sequence number, so recording never blocks. When full, the
+     * oldest events are overwritten. Snapshot() skips slots being written.
+     */
+    class TraceBuffer
+    {
+    public:
+        explicit TraceBuffer(size_t capacity)
+            : capacity_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2))),
+              slots_(new Slot[capacity_]) {}
+
+        [[nodiscard]] size_t GetCapacity() const { return capacity_; }
+
+        void Record(const TraceEvent& event)
+        {
+            const uint64_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots_[ticket & (capacity_ - 1)];
+            slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.event = event;
+            slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief Copy the recorded events, oldest first
+         */
+        [[nodiscard]] std::vector<TraceEvent> Snapshot() const
+        {
+            std::vector<TraceEvent> events;
+            const uint64_t end = next_.load(std::memory_order_acquire);
+            const uint64_t begin = std::max<uint64_t>(end > capacity_ ? end - capacity_ : 0, cleared_);
+            events.reserve(static_cast<size_t>(end - begin));
+            for (uint64_t ticket = begin; ticket < end; ++ticket)
+            {
+                const Slot& slot = slots_[ticket & (capacity_ - 1)];
+                if (slot.sequence.load(std::memory_order_acquire) != 2 * ticket + 2) continue;
+                TraceEvent event = slot.event;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != 2 * ticket + 2) continue;
+                events.push_back(event);
+            }
+            return events;
+        }
+
+        /**
+         * @brief Forget the events recorded so far
+         */
+        void Clear()
+        {
+            cleared_ = next_.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{0};
+            TraceEvent event;
+        };
+
+        static size_t RoundUpToPowerOfTwo(size_t value)
+        {
+            size_t result = 1;
+            while (result < value) result <<= 1;
+            return result;
+        }
+
+        const size_t capacity_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<uint64_t> next_{0};
+        uint64_t cleared_ = 0;
+    };
+
+    namespace detail
+    {
+        inline std::atomic<bool> tracing_enabled{false};
+
+        inline uint32_t CurrentTraceThreadId()
+        {
+            static std::atomic<uint32_t> next_thread_id{1};
+            thread_local const uint32_t id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+            return id;
+        }
+
+        inline uint64_t TraceNowNanos()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        inline void AppendJsonString(std::ostream& out, const char* text)
+        {
+            out << '"';
+            for (const char* c = text; *c; ++c)
+            {
+                switch (*c)
+                {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                default:
+                    if (static_cast<unsigned char>(*c) < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+                        out << escaped;
+                    }
+                    else
+                    {
+                        out << *c;
+                    }
+                }
+            }
+            out << '"';
+        }
+    } // namespace detail
+
+    /**
+     * @brief The process-wide trace buffer, holding the last 64K spans
+     */
+    inline TraceBuffer& GetTraceBuffer()
+    {
+        static TraceBuffer buffer(1 << 16);
+        return buffer;
+    }
+
+    /**
+     * @brief Start or stop recording spans; off by default
+     *
+     * Has no effect unless PANDORA_ENABLE_TRACING is defined to a non-zero
+     * value, with the same caveat as PANDORA_ENABLE_PHASE_TIMING; otherwise
+     * the span sites compile to nothing.
+     */
+    inline void SetTracingEnabled(bool enabled)
+    {
+        detail::tracing_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline bool IsTracingEnabled()
+    {
+        return detail::tracing_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Records a complete ("X") event for its scope into the trace buffer
+     *
+     * @param category Category shown by the viewer; must be a string literal
+     * @param name Span name; must be a string literal
+     * @param alias Alias of the adapter, copied and truncated to 31 characters
+     */
+    class ScopedTraceSpan
+    {
+    public:
+        ScopedTraceSpan(const char* category, const char* name, const std::string& alias = std::string())
+            : active_(IsTracingEnabled())
+        {
+            if (!active_) return;
+            event_.category = category;
+            event_.name = name;
+            const size_t length = std::min(alias.size(), static_cast<size_t>(TraceEvent::kAliasCapacity - 1));
+            std::memcpy(event_.alias, alias.data(), length);
+            event_.alias[length] = '\0';
+            event_.start_nanos = detail::TraceNowNanos();
+        }
+
+        ~ScopedTraceSpan()
+        {
+            if (!active_) return;
+            event_.duration_nanos = detail::TraceNowNanos() - event_.start_nanos;
+            event_.thread_id = detail::CurrentTraceThreadId();
+            GetTraceBuffer().Record(event_);
+        }
+
+        ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+        ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+        void SetSizes(int64_t old_size, int64_t new_size)
+        {
+            event_.old_size = old_size;
+            event_.new_size = new_size;
+        }
+
+        void SetEdits(int64_t edits) { event_.edits = edits; }
+
+    private:
+        bool active_;
+        TraceEvent event_;
+    };
+
+    /**
+     * @brief Write events in the Chrome trace_event JSON format, loadable by Perfetto
+     */
+    inline void WriteChromeTrace(std::ostream& out, const std::vector<TraceEvent>& events)
+    {
+        const uint64_t origin = events.empty() ? 0 : std::min_element(
+            events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b)
+            {
+                return a.start_nanos < b.start_nanos;
+            })->start_nanos;
+
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (const TraceEvent& event : events)
+        {
+            if (!first) out << ',';
+            first = false;
+
+            out << "{\"name\":";
+            detail::AppendJsonString(out, event.name);
+            out << ",\"cat\":";
+            detail::AppendJsonString(out, event.category);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id
+                << ",\"ts\":" << static_cast<double>(event.start_nanos - origin) / 1000.0
+                << ",\"dur\":" << static_cast<double>(event.duration_nanos) / 1000.0
+                << ",\"args\":{\"alias\":";
+            detail::AppendJsonString(out, event.alias);
+            if (event.old_size != TraceEvent::kNoValue) out << ",\"old_size\":" << event.old_size;
+            if (event.new_size != TraceEvent::kNoValue) out << ",\"new_size\":" << event.new_size;
+            if (event.edits != TraceEvent::kNoValue) out << ",\"edits\":" << event.edits;
+            out << "}}";
+        }
+        out << "],\"displayTimeUnit\":\"ms\"}";
+    }
+
+    /**
+     * @brief Export the trace buffer as Chrome trace_event JSON
+     */
+    inline std::string ExportChromeTrace()
+    {
+        std::ostringstream out;
+        WriteChromeTrace(out, GetTraceBuffer().Snapshot());
+        return out.str();
+    }
+} // namespace pandora
+
+#if defined(PANDORA_ENABLE_TRACING) && PANDORA_ENABLE_TRACING
+#define PANDORA_TRACE(...) __VA_ARGS__
+#define PANDORA_TRACE_SPAN(variable, category, name, alias) \
+    ::pandora::ScopedTraceSpan variable(category, name, alias)
+#else
+#define PANDORA_TRACE(...) ((void)0)
+#define PANDORA_TRACE_SPAN(variable, category, name, alias) ((void)0)
+#endif
+
+#endif  // PANDORA_TRACE_H_
@@ -0,0 +1,263 @@
+#ifndef PANDORA_TREE_SERIALIZER_H_
+#define PANDORA_TREE_SERIALIZER_H_
+
+#include "binary_io.h"
+#include "pandora_box_adapter.h"
+#include "pandora_exception.h"
+#include "real_data_set.h"
+#include "wrapper_data_set.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pandora
+{
+    /**
+     * @brief Item encoding of TreeSerializer; specialize it for your item type
+     *
+     * @code
+     * template <>
+     * struct pandora::Serializer<Article> {
+     *     static void Write(BinaryWriter& writer, const Article& item) {
+     *         writer.WriteVarint(item.id);
+     *         writer.WriteString(item.title);
+     *     }
+     *     static Article Read(BinaryReader& reader) {
+     *         const auto id = reader.ReadVarint();
+     *         return Article{id, reader.ReadString()};
+     *     }
+     * };
+     * @endcode
+     *
+     * Trivially copyable, default constructible items with a unique object
+     * representation (no padding, no floating point members) need no
+     * specialization: each leaf is then stored as one block of raw bytes and
+     * restored with a single memcpy. Such items must not hold pointers, and a
+     * raw snapshot only loads on a build with the same item layout and byte
+     * order. Items with padding need a Serializer, so that uninitialized
+     * bytes never reach the snapshot.
+     */
+    template <typename T>
+    struct Serializer;
+
+    template <typename T, typename = void>
+    struct HasSerializer : std::false_type {};
+
+    template <typename T>
+    struct HasSerializer<T, std::void_t<decltype(Serializer<T>::Read(std::declval<BinaryReader&>()))>>
+        : std::true_type {};
+
+    /// Whether TreeSerializer copies items of T as raw bytes
+    template <typename T>
+    struct IsRawSerializable
+        : std::bool_constant<!HasSerializer<T>::value && std::is_trivially_copyable_v<T> &&
+                             std::has_unique_object_representations_v<T> &&
+                             std::is_default_constructible_v<T> && !std::is_pointer_v<T>> {};
+
+    constexpr uint32_t kTreeSnapshotMagic = 0x45525450;  // "PTRE"
+    constexpr uint64_t kTreeSnapshotVersion = 1;
+
+    /**
+     * @brief Saves a PandoraBoxAdapter tree to a compact binary snapshot and restores it
+     *
+     * The snapshot holds the structure, the alias and group index of every
+     * node and the items of every leaf. Nodes with children, and
+     * WrapperDataSets, are restored as WrapperDataSet; every other node is a
+     * leaf, restored as RealDataSet<T> unless a MakeLeaf factory is given.
+     *
+     * Restoring builds the whole tree in one pass inside a transaction that
+     * ends silently: no snapshot is taken per item and no change is notified.
+     * Attach list update callbacks afterwards.
+     *
+     * @tparam T The data type, with a Serializer<T> or raw serializable
+     */
+    template <typename T>
+    class TreeSerializer
+    {
+    public:
+        static_assert(HasSerializer<T>::value || IsRawSerializable<T>::value,
+                      "TreeSerializer needs a pandora::Serializer<T> specialization for this item type");
+
+        /// Creates a leaf holding items, e.g. over another storage
+        using MakeLeaf = std::function<std::unique_ptr<PandoraBoxAdapter<T>>(std::vector<T> items)>;
+
+        /**
+         * @brief Appends the snapshot of the tree under root to out
+         */
+        static void Save(PandoraBoxAdapter<T>& root, std::vector<uint8_t>& out)
+        {
+            BinaryWriter writer(out);
+            writer.WriteFixed32(kTreeSnapshotMagic);
+            writer.WriteVarint(kTreeSnapshotVersion);
+            writer.WriteU8(IsRawSerializable<T>::value ? kRawItems : kSerializedItems);
+            writer.WriteVarint(IsRawSerializable<T>::value ? sizeof(T) : 0);
+            WriteNode(writer, root);
+        }
+
+        static std::vector<uint8_t> Save(PandoraBoxAdapter<T>& root)
+        {
+            std::vector<uint8_t> out;
+            Save(root, out);
+            return out;
+        }
+
+        /**
+         * @brief Rebuilds a tree saved by Save
+         *
+         * @param make_leaf Creates every leaf, RealDataSet<T> by default
+         * @throws PandoraException if data is not a tree snapshot of this item encoding, or is truncated
+         */
+        static std::unique_ptr<PandoraBoxAdapter<T>> Restore(const uint8_t* data, size_t size,
+                                                             const MakeLeaf& make_leaf = nullptr)
+        {
+            BinaryReader reader(data, size);
+            if (reader.ReadFixed32() != kTreeSnapshotMagic)
+            {
+                throw PandoraException("TreeSerializer: not a tree snapshot");
+            }
+            const uint64_t version = reader.ReadVarint();
+            if (version != kTreeSnapshotVersion)
+            {
+                throw PandoraException("TreeSerializer: unsupported snapshot version " + std::to_string(version));
+            }
+            const uint8_t encoding = reader.ReadU8();
+            const uint64_t item_size = reader.ReadVarint();
+            if (encoding != (IsRawSerializable<T>::value ? kRawItems : kSerializedItems) ||
+                item_size != (IsRawSerializable<T>::value ? sizeof(T) : 0))
+            {
+                throw PandoraException("TreeSerializer: snapshot was saved with another item encoding");
+            }
+
+            const MakeLeaf& leaf_factory = make_leaf ? make_leaf : DefaultMakeLeaf();
+            std::unique_ptr<PandoraBoxAdapter<T>> root = ReadNode(reader, nullptr, leaf_factory);
+            if (!reader.AtEnd())
+            {
+                throw PandoraException("TreeSerializer: trailing bytes after the tree");
+            }
+            return root;
+        }
+
+        static std::unique_ptr<PandoraBoxAdapter<T>> Restore(const std::vector<uint8_t>& data,
+                                                             const MakeLeaf& make_leaf = nullptr)
+        {
+            return Restore(data.data(), data.size(), make_leaf);
+        }
+
+    private:
+        enum : uint8_t
+        {
+            kSerializedItems = 0,
+            kRawItems = 1,
+        };
+
+        enum : uint8_t
+        {
+            kLeaf = 0,
+            kWrapper = 1,
+        };
+
+        static const MakeLeaf& DefaultMakeLeaf()
+        {
+            static const MakeLeaf make_leaf = [](std::vector<T> items)
+            {
+                return std::unique_ptr<PandoraBoxAdapter<T>>(new RealDataSet<T>(std::move(items)));
+            };
+            return make_leaf;
+        }
+
+        static bool IsWrapper(PandoraBoxAdapter<T>& node)
+        {
+            return node.GetChildCount() > 0 || dynamic_cast<WrapperDataSet<T>*>(&node) != nullptr;
+        }
+
+        static void WriteNode(BinaryWriter& writer, PandoraBoxAdapter<T>& node)
+        {
+            const bool wrapper = IsWrapper(node);
+            writer.WriteU8(wrapper ? kWrapper : kLeaf);
+            writer.WriteString(node.GetAlias());
+            writer.WriteSignedVarint(node.GetGroupIndex());
+            if (wrapper)
+            {
+                const int child_count = node.GetChildCount();
+                writer.WriteVarint(static_cast<uint64_t>(child_count));
+                for (int i = 0; i < child_count; ++i) WriteNode(writer, *node.GetChild(i));
+                return;
+            }
+
+            const int count = node.GetDataCount();
+            writer.WriteVarint(static_cast<uint64_t>(count));
+            for (int i = 0; i < count; ++i)
+            {
+                const T& item = *node.GetDataByIndex(i);
+                if constexpr (IsRawSerializable<T>::value) writer.WriteBytes(&item, sizeof(T));
+                else Serializer<T>::Write(writer, item);
+            }
+        }
+
+        static std::unique_ptr<PandoraBoxAdapter<T>> ReadNode(BinaryReader& reader, PandoraBoxAdapter<T>* parent,
+                                                              const MakeLeaf& make_leaf)
+        {
+            const uint8_t kind = reader.ReadU8();
+            const std::string alias = reader.ReadString();
+            const auto group_index = static_cast<int>(reader.ReadSignedVarint());
+            if (kind != kLeaf && kind != kWrapper)
+            {
+                throw PandoraException("TreeSerializer: unknown node kind " + std::to_string(kind));
+            }
+
+            std::unique_ptr<PandoraBoxAdapter<T>> node;
+            if (kind == kLeaf)
+            {
+                node = make_leaf(ReadItems(reader));
+            }
+            else
+            {
+                node = std::make_unique<WrapperDataSet<T>>();
+            }
+            // Aliases were unique in the saved tree, so the check only needs the node itself
+            if (!alias.empty()) node->SetAlias(alias);
+
+            PandoraBoxAdapter<T>* raw = node.get();
+            if (parent != nullptr) parent->AddChild(std::move(node));
+            raw->SetGroupIndex(group_index);
+            if (kind == kWrapper)
+            {
+                // Children join inside the root's transaction: no snapshots, no notifications
+                if (parent == nullptr) raw->StartTransaction();
+                const uint64_t child_count = reader.ReadVarint();
+                for (uint64_t i = 0; i < child_count; ++i) ReadNode(reader, raw, make_leaf);
+                if (parent == nullptr) raw->EndTransactionSilently();
+            }
+            return node;
+        }
+
+        static std::vector<T> ReadItems(BinaryReader& reader)
+        {
+            const uint64_t count = reader.ReadVarint();
+            std::vector<T> items;
+            if constexpr (IsRawSerializable<T>::value)
+            {
+                if (count > std::numeric_limits<uint64_t>::max() / sizeof(T))
+                {
+                    throw PandoraException("TreeSerializer: item count out of range");
+                }
+                const uint8_t* bytes = reader.ReadBytes(count * sizeof(T));
+                items.resize(static_cast<size_t>(count));
+                if (count > 0) std::memcpy(items.data(), bytes, static_cast<size_t>(count) * sizeof(T));
+            }
+            else
+            {
+                for (uint64_t i = 0; i < count; ++i) items.push_back(Serializer<T>::Read(reader));
+            }
+            return items;
+        }
+    };
+} // namespace pandora
+
+#endif // PANDORA_TREE_SERIALIZER_H_
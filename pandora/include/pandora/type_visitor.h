@@ -1,8 +1,321 @@
 #ifndef PANDORA_TYPE_VISITOR_H_
 #define PANDORA_TYPE_VISITOR_H_
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "pandora_box_adapter.h"
+#include "pandora_exception.h"
+
 namespace pandora
 {
+    /**
+     * @brief Compact runtime identifier of an element type
+     *
+     * Tags are small dense integers handed out on first use, so they can index
+     * dispatch tables directly.
+     */
+    using TypeTag = uint32_t;
+
+    constexpr TypeTag INVALID_TYPE_TAG = 0;
+
+    namespace detail
+    {
+        constexpr TypeTag MAX_TYPE_TAGS = 1024;
+
+        inline std::atomic<TypeTag> next_type_tag{1};
+
+        // Parent tag of every tag, written once when the first instance is constructed
+        inline std::array<std::atomic<TypeTag>, MAX_TYPE_TAGS> type_tag_parents{};
+
+        inline TypeTag NextTypeTag()
+        {
+            const TypeTag tag = next_type_tag.fetch_add(1, std::memory_order_relaxed);
+            if (tag >= MAX_TYPE_TAGS)
+            {
+                throw PandoraException("Too many type tags, the limit is " + std::to_string(MAX_TYPE_TAGS));
+            }
+            return tag;
+        }
+
+        inline bool RegisterTypeTagParent(TypeTag tag, TypeTag parent)
+        {
+            type_tag_parents[tag].store(parent, std::memory_order_release);
+            return true;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Get the tag of type U
+     */
+    template <typename U>
+    TypeTag TypeTagOf()
+    {
+        static const TypeTag tag = detail::NextTypeTag();
+        return tag;
+    }
+
+    /**
+     * @brief Get the tag of the base U was declared with through TypeTagged, if any
+     */
+    inline TypeTag ParentTypeTagOf(TypeTag tag)
+    {
+        return tag < detail::MAX_TYPE_TAGS
+                   ? detail::type_tag_parents[tag].load(std::memory_order_acquire)
+                   : INVALID_TYPE_TAG;
+    }
+
+    /**
+     * @brief Whether an element with tag is a target, directly or through TypeTagged bases
+     */
+    inline bool TypeTagIsA(TypeTag tag, TypeTag target)
+    {
+        for (; tag != INVALID_TYPE_TAG; tag = ParentTypeTagOf(tag))
+        {
+            if (tag == target) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Root of element types carrying a TypeTag
+     *
+     * Derive element types through TypeTagged rather than directly.
+     */
+    class TypeTaggedBase
+    {
+    public:
+        [[nodiscard]] TypeTag GetTypeTag() const { return type_tag_; }
+
+    protected:
+        TypeTaggedBase() = default;
+        TypeTaggedBase(const TypeTaggedBase&) = default;
+        TypeTaggedBase& operator=(const TypeTaggedBase&) { return *this; }
+        ~TypeTaggedBase() = default;
+
+        void SetTypeTag(TypeTag tag) { type_tag_ = tag; }
+
+    private:
+        TypeTag type_tag_ = INVALID_TYPE_TAG;
+    };
+
+    /**
+     * @brief Stamps the tag of Derived on every instance
+     *
+     * @tparam Derived The element type being defined
+     * @tparam Base TypeTaggedBase, or another TypeTagged element type
+     *
+     * Example:
+     * @code
+     * class Message : public TypeTagged<Message> { ... };
+     * class ImageMessage : public TypeTagged<ImageMessage, Message> { ... };
+     * @endcode
+     */
+    template <typename Derived, typename Base = TypeTaggedBase>
+    class TypeTagged : public Base
+    {
+        static_assert(std::is_base_of<TypeTaggedBase, Base>::value,
+                      "Base must be TypeTaggedBase or derive from it");
+
+    public:
+        template <typename... Args>
+        explicit TypeTagged(Args&&... args) : Base(std::forward<Args>(args)...)
+        {
+            static const bool registered = detail::RegisterTypeTagParent(TypeTagOf<Derived>(), BaseTag());
+            (void)registered;
+            this->SetTypeTag(TypeTagOf<Derived>());
+        }
+
+        TypeTagged(const TypeTagged& other) : Base(other)
+        {
+            this->SetTypeTag(TypeTagOf<Derived>());
+        }
+
+        TypeTagged& operator=(const TypeTagged& other)
+        {
+            Base::operator=(other);
+            return *this;
+        }
+
+    private:
+        static TypeTag BaseTag()
+        {
+            if constexpr (std::is_same<Base, TypeTaggedBase>::value)
+            {
+                return INVALID_TYPE_TAG;
+            }
+            else
+            {
+                return TypeTagOf<Base>();
+            }
+        }
+    };
+
+    /**
+     * @brief Resolves the tagged object behind a list element
+     *
+     * Handles raw pointers, smart pointers and elements held by value.
+     */
+    template <typename T, typename Enable = void>
+    struct TypeTagTraits
+    {
+        static TypeTaggedBase* Get(T& element)
+        {
+            static_assert(std::is_base_of<TypeTaggedBase, T>::value,
+                          "Element type must derive from TypeTaggedBase");
+            return &element;
+        }
+    };
+
+    template <typename T>
+    struct TypeTagTraits<T*>
+    {
+        static TypeTaggedBase* Get(T* element) { return element; }
+    };
+
+    template <typename T>
+    struct TypeTagTraits<std::shared_ptr<T>>
+    {
+        static TypeTaggedBase* Get(const std::shared_ptr<T>& element) { return element.get(); }
+    };
+
+    template <typename T, typename D>
+    struct TypeTagTraits<std::unique_ptr<T, D>>
+    {
+        static TypeTaggedBase* Get(const std::unique_ptr<T, D>& element) { return element.get(); }
+    };
+
+    /**
+     * @brief Multi-arm visitor dispatching on TypeTag through a jump table
+     *
+     * Each arm handles one element type, including types derived from it
+     * through TypeTagged. The arm for a tag is resolved once and cached in a
+     * table indexed by tag, so every later element costs one lookup.
+     *
+     * @tparam T The element type of the adapter
+     *
+     * Example:
+     * @code
+     * TypeTagDispatcher<Message*> dispatcher;
+     * dispatcher.On<TextMessage>([&](TextMessage& m) { ... })
+     *           .On<ImageMessage>([&](ImageMessage& m) { ... });
+     * dispatcher.Run(adapter);
+     * @endcode
+     *
+     * @note Not thread-safe; use one dispatcher per thread.
+     */
+    template <typename T>
+    class TypeTagDispatcher
+    {
+    public:
+        /**
+         * @brief Add an arm for U; arms added first win when several match
+         */
+        template <typename U, typename Handler>
+        TypeTagDispatcher& On(Handler handler)
+        {
+            static_assert(std::is_base_of<TypeTaggedBase, U>::value, "U must derive from TypeTaggedBase");
+            arms_.push_back(Arm{
+                TypeTagOf<U>(),
+                [handler = std::move(handler)](TypeTaggedBase& element) mutable
+                {
+                    handler(static_cast<U&>(element));
+                }
+            });
+            arm_by_tag_.clear();
+            return *this;
+        }
+
+        /**
+         * @brief Handle elements matching no arm
+         */
+        TypeTagDispatcher& Otherwise(std::function<void(T&)> handler)
+        {
+            otherwise_ = std::move(handler);
+            return *this;
+        }
+
+        /**
+         * @brief Dispatch one element
+         *
+         * @return Whether an arm handled it
+         */
+        bool Dispatch(T& element)
+        {
+            TypeTaggedBase* tagged = TypeTagTraits<T>::Get(element);
+            const int arm = tagged ? ArmFor(tagged->GetTypeTag()) : NO_ARM;
+            if (arm == NO_ARM)
+            {
+                if (otherwise_) otherwise_(element);
+                return false;
+            }
+            arms_[arm].call(*tagged);
+            return true;
+        }
+
+        /**
+         * @brief Dispatch every element of adapter in one pass
+         *
+         * @return The number of elements handled by an arm
+         */
+        int Run(PandoraBoxAdapter<T>& adapter)
+        {
+            int hits = 0;
+            const int count = adapter.GetDataCount();
+            for (int i = 0; i < count; ++i)
+            {
+                if (T* element = adapter.GetDataByIndex(i))
+                {
+                    if (Dispatch(*element)) ++hits;
+                }
+            }
+            return hits;
+        }
+
+    private:
+        static constexpr int NO_ARM = -1;
+        static constexpr int UNRESOLVED = -2;
+
+        struct Arm
+        {
+            TypeTag tag;
+            std::function<void(TypeTaggedBase&)> call;
+        };
+
+        int ArmFor(TypeTag tag)
+        {
+            if (tag == INVALID_TYPE_TAG) return NO_ARM;
+            if (tag >= arm_by_tag_.size())
+            {
+                arm_by_tag_.resize(tag + 1, UNRESOLVED);
+            }
+            int& slot = arm_by_tag_[tag];
+            if (slot == UNRESOLVED)
+            {
+                slot = NO_ARM;
+                for (int i = 0; i < static_cast<int>(arms_.size()); ++i)
+                {
+                    if (TypeTagIsA(tag, arms_[i].tag))
+                    {
+                        slot = i;
+                        break;
+                    }
+                }
+            }
+            return slot;
+        }
+
+        std::vector<Arm> arms_;
+        std::vector<int> arm_by_tag_;
+        std::function<void(T&)> otherwise_;
+    };
+
     template <typename T>
     class TypeVisitor
     {
@@ -18,14 +331,21 @@ namespace pandora
         {
         }
 
-        T* Visit(void* element)
+        /**
+         * @brief Visit an element, calling OnHit() when it is a T
+         *
+         * Tagged elements are matched by TypeTag; other polymorphic elements
+         * fall back to dynamic_cast.
+         */
+        template <typename E>
+        T* Visit(E* element)
         {
             if (!element)
             {
                 OnMissed();
                 return nullptr;
             }
-            if (T* ret = dynamic_cast<T*>(element))
+            if (T* ret = Match(element))
             {
                 OnHit(ret);
                 return ret;
@@ -36,6 +356,26 @@ namespace pandora
                 return nullptr;
             }
         }
+
+    private:
+        template <typename E>
+        static T* Match(E* element)
+        {
+            if constexpr (std::is_base_of<T, E>::value)
+            {
+                return element;
+            }
+            else if constexpr (std::is_base_of<TypeTaggedBase, E>::value && std::is_base_of<TypeTaggedBase, T>::value)
+            {
+                return TypeTagIsA(element->GetTypeTag(), TypeTagOf<T>()) ? static_cast<T*>(element) : nullptr;
+            }
+            else
+            {
+                static_assert(std::is_polymorphic<E>::value,
+                              "Untagged element types must be polymorphic to be visited");
+                return dynamic_cast<T*>(element);
+            }
+        }
     };
 } // namespace pandora
 
@@ -6,9 +6,13 @@
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "diff_util.h"
+#include "field_hashers.h"
+#include "instrumentation.h"
+#include "mutation_recorder.h"
 
 namespace pandora
 {
@@ -38,8 +42,11 @@ namespace pandora
         T* GetDataByIndex(const int index) override
         {
             int real_index = index + start_index_;
-            Log(Logger::VERBOSE, "getDataByResolvedIndex " + std::to_string(index) +
-                " ; real index: " + std::to_string(real_index));
+            if (Logger::IsLoggable(Logger::VERBOSE))
+            {
+                Log(Logger::VERBOSE, "getDataByResolvedIndex " + std::to_string(index) +
+                    " ; real index: " + std::to_string(real_index));
+            }
 
             if (index < 0 || index >= GetDataCount())
             {
@@ -80,8 +87,11 @@ namespace pandora
                 return nullptr;
             }
 
-            Log(Logger::VERBOSE, "getDataByIndex " + std::to_string(real_index) +
-                " " + target_sub->GetAlias() + " - " + std::to_string(reinterpret_cast<uintptr_t>(target_sub)));
+            if (Logger::IsLoggable(Logger::VERBOSE))
+            {
+                Log(Logger::VERBOSE, "getDataByIndex " + std::to_string(real_index) +
+                    " " + target_sub->GetAlias() + " - " + std::to_string(reinterpret_cast<uintptr_t>(target_sub)));
+            }
 
             int resolved_index = real_index - target_sub->GetStartIndex();
             return target_sub->GetDataByIndex(resolved_index);
@@ -112,12 +122,12 @@ namespace pandora
             }
         }
 
-        int GetChildCount() const
+        [[nodiscard]] int GetChildCount() const override
         {
             return static_cast<int>(subs_.size());
         }
 
-        PandoraBoxAdapter<T>* GetChild(int index)
+        PandoraBoxAdapter<T>* GetChild(int index) override
         {
             if (index < 0 || index >= static_cast<int>(subs_.size()))
                 return nullptr;
@@ -356,18 +366,24 @@ namespace pandora
         // Transaction support
         void StartTransaction() override
         {
+            if (auto* recorder = this->FindMutationRecorder()) recorder->Record(this, MutationOp::START_TRANSACTION);
+            PANDORA_TRACE_SPAN(trace_span, "pandora", "StartTransaction", this->GetAlias());
             use_transaction_ = true;
             Snapshot();
         }
 
         void EndTransaction() override
         {
+            if (auto* recorder = this->FindMutationRecorder()) recorder->Record(this, MutationOp::END_TRANSACTION);
+            PANDORA_TRACE_SPAN(trace_span, "pandora", "EndTransaction", this->GetAlias());
+            PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), GetDataCount()));
             use_transaction_ = false;
             CalcChangeAndNotify();
         }
 
         void EndTransactionSilently() override
         {
+            if (auto* recorder = this->FindMutationRecorder()) recorder->Record(this, MutationOp::END_TRANSACTION_SILENTLY);
             use_transaction_ = false;
             // Propagate to children without notifying changes
             for (auto& sub : subs_)
@@ -494,6 +510,17 @@ namespace pandora
 
 
     private:
+        template <typename Callback>
+        void RecordDiffMetrics(const Callback& diff_callback, const DiffUtil::DiffResult* result)
+        {
+            AdapterMetrics& metrics = this->GetOrCreateMetrics();
+            metrics.RecordDiffCalls(diff_callback.items_the_same_calls, diff_callback.contents_the_same_calls);
+            if (result)
+            {
+                metrics.RecordDiff(static_cast<uint64_t>(result->GetEditDistance()));
+            }
+        }
+
         [[nodiscard]] bool IsParentInTransaction() const
         {
             return parent_ != nullptr && parent_->InTransaction();
@@ -504,11 +531,25 @@ namespace pandora
         {
             if (auto callback = PandoraBoxAdapter<T>::GetListUpdateCallback())
             {
-                DiffCallbackImpl diff_callback(this, old_data_, old_data_hashes_);
-                const auto result = DiffUtil::CalculateDiff(&diff_callback);
+                DiffCallbackImpl diff_callback(this, old_data_, old_data_hashes_, old_field_hashes_);
+                std::unique_ptr<DiffUtil::DiffResult> result;
+                {
+                    PANDORA_INSTRUMENT_PHASE(this, Phase::DIFF);
+                    PANDORA_TRACE_SPAN(trace_span, "pandora", "CalculateDiff", this->GetAlias());
+                    result = DiffUtil::CalculateDiff(&diff_callback);
+                    PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), GetDataCount()));
+                    PANDORA_TRACE(if (result) trace_span.SetEdits(result->GetEditDistance()));
+                }
+                PANDORA_METRICS(RecordDiffMetrics(diff_callback, result.get()));
                 if (result)
                 {
-                    if (auto ref = result.get()) ref->DispatchUpdatesTo(callback);
+                    PANDORA_INSTRUMENT_PHASE(this, Phase::DISPATCH);
+                    PANDORA_TRACE_SPAN(trace_span, "pandora", "DispatchUpdatesTo", this->GetAlias());
+                    PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), GetDataCount()));
+                    PANDORA_TRACE(trace_span.SetEdits(result->GetEditDistance()));
+                    PANDORA_METRICS(MetricsListUpdateCallback counted(callback, this->GetOrCreateMetrics()));
+                    PANDORA_METRICS(callback = &counted);
+                    result->DispatchUpdatesTo(callback);
                 }
             }
         }
@@ -516,19 +557,30 @@ namespace pandora
         // Snapshot current state (for transaction support)
         void Snapshot()
         {
+            PANDORA_INSTRUMENT_PHASE(this, Phase::SNAPSHOT);
+            PANDORA_TRACE_SPAN(trace_span, "pandora", "Snapshot", this->GetAlias());
+            // Copies, not pointers: a child mutation moves or frees the items in place.
+            // A missing item keeps its position as an empty slot with hash 0.
             old_data_.clear();
             old_data_hashes_.clear();
             const auto count = GetDataCount();
+            old_data_.reserve(count);
+            old_data_hashes_.reserve(count);
             for (int i = 0; i < count; ++i)
             {
                 auto data = GetDataByIndex(i);
-                old_data_.push_back(data);
                 if (data) {
+                    old_data_.emplace_back(*data);
                     old_data_hashes_.push_back(Pandora::Hash(*data));
                 } else {
+                    old_data_.emplace_back();
                     old_data_hashes_.push_back(0);
                 }
             }
+            old_field_hashes_.Capture(old_data_.data(), old_data_.size());
+            PANDORA_TRACE(trace_span.SetSizes(static_cast<int64_t>(old_data_.size()), TraceEvent::kNoValue));
+            PANDORA_METRICS(this->GetOrCreateMetrics().RecordSnapshot(
+                old_data_.size(), old_data_.size() * (sizeof(std::optional<T>) + sizeof(size_t)) + old_field_hashes_.GetBytes()));
         }
 
         // Dump debug information
@@ -552,8 +604,9 @@ namespace pandora
         }
 
         std::vector<std::unique_ptr<PandoraBoxAdapter<T>>> subs_;
-        std::vector<T*> old_data_; // Snapshot for transaction rollback
+        std::vector<std::optional<T>> old_data_; // Snapshot for transaction rollback
         std::vector<size_t> old_data_hashes_; // Snapshot of content hashes
+        FieldHashSnapshot<T> old_field_hashes_; // Snapshot of per-field hashes, with FieldHashers<T>
         bool use_transaction_ = false;
         int group_index_ = Node<PandoraBoxAdapter<T>>::kNoGroupIndex;
         int start_index_ = 0;
@@ -563,14 +616,20 @@ namespace pandora
         class DiffCallbackImpl : public DiffCallback {
         private:
             WrapperDataSet<T>* dataset_;
-            const std::vector<T*>& old_list_;
+            const std::vector<std::optional<T>>& old_list_;
             const std::vector<size_t>& old_hashes_;
+            const FieldHashSnapshot<T>& old_fields_;
 
         public:
             DiffCallbackImpl(WrapperDataSet<T>* dataset,
-                           const std::vector<T*>& old_list,
-                           const std::vector<size_t>& old_hashes)
-                : dataset_(dataset), old_list_(old_list), old_hashes_(old_hashes) {}
+                           const std::vector<std::optional<T>>& old_list,
+                           const std::vector<size_t>& old_hashes,
+                           const FieldHashSnapshot<T>& old_fields)
+                : dataset_(dataset), old_list_(old_list), old_hashes_(old_hashes), old_fields_(old_fields) {}
+
+            // Call counts, only kept with PANDORA_ENABLE_METRICS
+            mutable uint64_t items_the_same_calls = 0;
+            mutable uint64_t contents_the_same_calls = 0;
 
             int GetOldListSize() const override {
                 return static_cast<int>(old_list_.size());
@@ -581,32 +640,45 @@ namespace pandora
             }
 
             bool AreItemsTheSame(int old_item_position, int new_item_position) const override {
+                PANDORA_METRICS(++items_the_same_calls);
                 if (old_item_position >= static_cast<int>(old_list_.size())) return false;
                 if (new_item_position >= dataset_->GetDataCount()) return false;
 
-                T* old_item = old_list_[old_item_position];
+                const std::optional<T>& old_item = old_list_[old_item_position];
                 T* new_item = dataset_->GetDataByIndex(new_item_position);
 
-                return Pandora::Equals(old_item, new_item);
+                if (!old_item || new_item == nullptr) return !old_item && new_item == nullptr;
+                return Pandora::Equals(*old_item, *new_item);
             }
 
             bool AreContentsTheSame(int old_item_position, int new_item_position) const override {
+                PANDORA_METRICS(++contents_the_same_calls);
                 if (old_item_position >= static_cast<int>(old_list_.size())) return false;
                 if (new_item_position >= dataset_->GetDataCount()) return false;
 
-                T* old_item = old_list_[old_item_position];
+                const std::optional<T>& old_item = old_list_[old_item_position];
                 T* new_item = dataset_->GetDataByIndex(new_item_position);
 
                 // First check if items are the same
-                bool items_same = Pandora::Equals(old_item, new_item);
+                if (!old_item || new_item == nullptr) return !old_item && new_item == nullptr;
+                bool items_same = Pandora::Equals(*old_item, *new_item);
                 if (!items_same) return false;
 
                 // Then check if content hash matches
-                if (new_item == nullptr) return true;
-                
                 size_t new_hash = Pandora::Hash(*new_item);
                 return old_hashes_[old_item_position] == new_hash;
             }
+
+            // An inline FieldChangeMask for types with FieldHashers, otherwise empty
+            Payload GetTypedChangePayload(int old_item_position, int new_item_position) const override {
+                if constexpr (FieldHashSnapshot<T>::kEnabled) {
+                    T* new_item = dataset_->GetDataByIndex(new_item_position);
+                    if (new_item == nullptr) return Payload();
+                    const FieldChangeMask mask = old_fields_.Compare(static_cast<size_t>(old_item_position), *new_item);
+                    if (!mask.Empty()) return Payload(mask);
+                }
+                return Payload();
+            }
         };
     };
 } // namespace pandora
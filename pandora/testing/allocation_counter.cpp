@@ -0,0 +1,106 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> process_allocation_count{0};
+    std::atomic<uint64_t> process_allocated_bytes{0};
+    // Trivial thread_locals, so they are usable from operator new at any time
+    thread_local uint64_t thread_allocation_count = 0;
+    thread_local uint64_t thread_allocated_bytes = 0;
+
+    void Count(std::size_t size)
+    {
+        process_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        process_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        ++thread_allocation_count;
+        thread_allocated_bytes += size;
+    }
+
+    void* TryAllocate(std::size_t size) noexcept
+    {
+        Count(size);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* TryAllocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        Count(size);
+        const auto align = static_cast<std::size_t>(alignment);
+        // aligned_alloc requires the size to be a multiple of the alignment
+        const std::size_t rounded = ((size == 0 ? 1 : size) + align - 1) / align * align;
+        return std::aligned_alloc(align, rounded);
+    }
+
+    void* Allocate(std::size_t size)
+    {
+        if (void* ptr = TryAllocate(size)) return ptr;
+        throw std::bad_alloc();
+    }
+
+    void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        if (void* ptr = TryAllocateAligned(size, alignment)) return ptr;
+        throw std::bad_alloc();
+    }
+} // namespace
+
+namespace pandora
+{
+namespace alloc_counter
+{
+    uint64_t ProcessAllocationCount()
+    {
+        return process_allocation_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t ProcessAllocatedBytes()
+    {
+        return process_allocated_bytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t ThreadAllocationCount()
+    {
+        return thread_allocation_count;
+    }
+
+    uint64_t ThreadAllocatedBytes()
+    {
+        return thread_allocated_bytes;
+    }
+} // namespace alloc_counter
+} // namespace pandora
+
+// Every allocating form is replaced, not only the ones the standard library
+// would forward: sanitizer runtimes provide their own nothrow forms, whose
+// memory must not reach the std::free based operator delete below.
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return TryAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return TryAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return TryAllocateAligned(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return TryAllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
@@ -0,0 +1,35 @@
+#ifndef PANDORA_TESTING_ALLOCATION_COUNTER_H
+#define PANDORA_TESTING_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+namespace pandora
+{
+namespace alloc_counter
+{
+    /**
+     * @brief Global operator new calls since the process started, all threads
+     *
+     * Counted by the replacement operators in allocation_counter.cpp, which
+     * apply to every binary linking the pandora_allocation_counter target.
+     */
+    uint64_t ProcessAllocationCount();
+
+    /**
+     * @brief Bytes requested from global operator new since the process started
+     */
+    uint64_t ProcessAllocatedBytes();
+
+    /**
+     * @brief Global operator new calls made by the current thread
+     */
+    uint64_t ThreadAllocationCount();
+
+    /**
+     * @brief Bytes requested from global operator new by the current thread
+     */
+    uint64_t ThreadAllocatedBytes();
+} // namespace alloc_counter
+} // namespace pandora
+
+#endif // PANDORA_TESTING_ALLOCATION_COUNTER_H
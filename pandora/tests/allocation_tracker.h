@@ -0,0 +1,64 @@
+#ifndef PANDORA_TESTS_ALLOCATION_TRACKER_H
+#define PANDORA_TESTS_ALLOCATION_TRACKER_H
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "allocation_counter.h"
+
+namespace pandora_test
+{
+    /**
+     * @brief Global operator new calls and bytes requested by the current thread
+     *
+     * Counted by the replacement operators in testing/allocation_counter.cpp,
+     * which apply to the whole test binary. Per thread, so gtest or other
+     * threads do not disturb a measurement.
+     */
+    struct AllocationStats
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    inline AllocationStats ThreadAllocations()
+    {
+        AllocationStats stats;
+        stats.count = pandora::alloc_counter::ThreadAllocationCount();
+        stats.bytes = pandora::alloc_counter::ThreadAllocatedBytes();
+        return stats;
+    }
+
+    /**
+     * @brief Counts the allocations of the current thread during its lifetime
+     */
+    class AllocationTracker
+    {
+    public:
+        AllocationTracker() : start_(ThreadAllocations()) {}
+
+        [[nodiscard]] uint64_t GetCount() const { return ThreadAllocations().count - start_.count; }
+        [[nodiscard]] uint64_t GetBytes() const { return ThreadAllocations().bytes - start_.bytes; }
+
+    private:
+        AllocationStats start_;
+    };
+} // namespace pandora_test
+
+/**
+ * Expects statement to allocate at most budget times, e.g.
+ * EXPECT_ALLOCATIONS_LE(0, data_set.GetDataByIndex(3));
+ */
+#define EXPECT_ALLOCATIONS_LE(budget, statement)                                              \
+    do                                                                                        \
+    {                                                                                         \
+        const ::pandora_test::AllocationTracker pandora_allocation_tracker;                  \
+        statement;                                                                            \
+        const uint64_t pandora_allocations = pandora_allocation_tracker.GetCount();           \
+        const uint64_t pandora_allocated_bytes = pandora_allocation_tracker.GetBytes();       \
+        EXPECT_LE(pandora_allocations, static_cast<uint64_t>(budget))                         \
+            << #statement << " allocated " << pandora_allocated_bytes << " bytes";            \
+    } while (0)
+
+#define EXPECT_NO_ALLOCATIONS(statement) EXPECT_ALLOCATIONS_LE(0, statement)
+
+#endif // PANDORA_TESTS_ALLOCATION_TRACKER_H
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "allocation_tracker.h"
+#include "pandora/diff_util.h"
+#include "pandora/pandora_rv.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <memory>
+#include <vector>
+
+using namespace pandora;
+using namespace pandora::rv;
+
+namespace {
+
+struct PlainItem
+{
+    int id;
+    int version;
+
+    bool operator==(const PlainItem& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, id);
+        HashCombine(seed, version);
+        return seed;
+    }
+};
+
+class RowData final : public DataSet<RowData>::Data
+{
+public:
+    explicit RowData(int v) : value(v) {}
+
+    void SetToViewHolder(const std::shared_ptr<IViewHolder<Data>> view_holder) override {}
+
+    size_t Hash() const { return static_cast<size_t>(value); }
+    bool operator==(const RowData& other) const { return value == other.value; }
+
+    int value;
+};
+
+class RowViewHolder : public IViewHolder<RowData>
+{
+public:
+    void SetData(std::shared_ptr<RowData> data) override {}
+    void OnViewAttachedToWindow() override {}
+    void OnViewDetachedFromWindow() override {}
+    void accept(IViewHolderVisitor& visitor) override {}
+};
+
+class NullCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { ++updates; }
+    void OnRemoved(int position, int count) override { ++updates; }
+    void OnMoved(int from_position, int to_position) override { ++updates; }
+    void OnChanged(int position, int count, void* payload) override { ++updates; }
+
+    int updates = 0;
+};
+
+class IntListCallback : public DiffCallback
+{
+public:
+    IntListCallback(std::vector<int> old_list, std::vector<int> new_list)
+        : old_list_(std::move(old_list)), new_list_(std::move(new_list)) {}
+
+    int GetOldListSize() const override { return static_cast<int>(old_list_.size()); }
+    int GetNewListSize() const override { return static_cast<int>(new_list_.size()); }
+    bool AreItemsTheSame(int old_pos, int new_pos) const override { return old_list_[old_pos] == new_list_[new_pos]; }
+    bool AreContentsTheSame(int old_pos, int new_pos) const override { return true; }
+
+private:
+    std::vector<int> old_list_;
+    std::vector<int> new_list_;
+};
+
+std::vector<PlainItem> MakeItems(int count)
+{
+    std::vector<PlainItem> items;
+    for (int i = 0; i < count; ++i) items.push_back(PlainItem{i, 0});
+    return items;
+}
+
+// Allocations of one Add, ReplaceAtPosIfExist and RemoveAtPos on a warmed-up leaf
+uint64_t SingleMutationAllocations(RealDataSet<PlainItem>& leaf)
+{
+    const int middle = leaf.GetDataCount() / 2;
+    // Warm up the snapshot buffers
+    leaf.Add(middle, PlainItem{-1, 0});
+    leaf.RemoveAtPos(middle);
+
+    const pandora_test::AllocationTracker tracker;
+    leaf.Add(middle, PlainItem{-1, 0});
+    leaf.ReplaceAtPosIfExist(middle, PlainItem{-1, 1});
+    leaf.RemoveAtPos(middle);
+    return tracker.GetCount();
+}
+
+} // namespace
+
+TEST(AllocationTest, TrackerCountsAndSizes)
+{
+    const pandora_test::AllocationTracker tracker;
+    auto values = std::make_unique<std::vector<int>>(100);
+    EXPECT_EQ(2u, tracker.GetCount());
+    EXPECT_EQ(sizeof(std::vector<int>) + 100 * sizeof(int), tracker.GetBytes());
+    EXPECT_NO_ALLOCATIONS(values->at(5) = 1);
+}
+
+TEST(AllocationTest, IndexedReadsDoNotAllocate)
+{
+    RealDataSet<PlainItem> leaf;
+    leaf.SetData(MakeItems(100));
+    EXPECT_NO_ALLOCATIONS(leaf.GetDataByIndex(42));
+
+    WrapperDataSet<PlainItem> root;
+    auto section = std::make_unique<WrapperDataSet<PlainItem>>();
+    for (int i = 0; i < 4; ++i)
+    {
+        auto child = std::make_unique<RealDataSet<PlainItem>>();
+        child->SetData(MakeItems(25));
+        section->AddChild(std::move(child));
+    }
+    root.AddChild(std::move(section));
+    EXPECT_NO_ALLOCATIONS(root.GetDataByIndex(42));
+    EXPECT_NO_ALLOCATIONS(root.GetDataByIndex(1000));
+}
+
+TEST(AllocationTest, RvItemAccessDoesNotAllocate)
+{
+    auto real = std::make_shared<RealDataSet<RowData>>();
+    auto rv_data_set = std::make_shared<PandoraRealRvDataSet<RowData>>(real);
+    rv_data_set->RegisterDvRelation<RowData>(make_lambda_creator<RowData>([](void*)
+    {
+        return std::make_shared<RowViewHolder>();
+    }));
+    for (int i = 0; i < 10; ++i) rv_data_set->Add(RowData(i));
+    const int view_type = rv_data_set->GetItemViewTypeV2(0);  // Registers the sub-type token
+
+    EXPECT_NO_ALLOCATIONS(rv_data_set->GetItem(3));
+    int read_type = -1;
+    EXPECT_NO_ALLOCATIONS(read_type = rv_data_set->GetItemViewTypeV2(7));
+    EXPECT_EQ(view_type, read_type);
+    EXPECT_EQ(nullptr, rv_data_set->GetItem(10));
+}
+
+TEST(AllocationTest, DispatchWithoutMovesDoesNotAllocate)
+{
+    IntListCallback callback({1, 2, 3, 4, 5, 6}, {1, 7, 3, 4, 6, 8});
+    auto result = DiffUtil::CalculateDiff(&callback);
+    NullCallback updates;
+    EXPECT_NO_ALLOCATIONS(result->DispatchUpdatesTo(&updates));
+    EXPECT_GT(updates.updates, 0);
+
+    // Moves hold their postponed half in a single growing vector
+    IntListCallback moves({1, 2, 3, 4, 5, 6}, {6, 2, 3, 4, 5, 1});
+    auto moved = DiffUtil::CalculateDiff(&moves);
+    EXPECT_ALLOCATIONS_LE(2, moved->DispatchUpdatesTo(&updates));
+}
+
+TEST(AllocationTest, DiffAllocationsDoNotDependOnEditCount)
+{
+    std::vector<int> old_list(200);
+    for (int i = 0; i < 200; ++i) old_list[i] = i;
+    std::vector<int> one_edit = old_list;
+    one_edit[100] = -1;
+    std::vector<int> many_edits = old_list;
+    for (int i = 0; i < 200; i += 10) many_edits[i] = -i - 1;
+
+    IntListCallback few(old_list, one_edit);
+    IntListCallback many(old_list, many_edits);
+    pandora_test::AllocationTracker few_tracker;
+    DiffUtil::CalculateDiff(&few, false);
+    const uint64_t few_allocations = few_tracker.GetCount();
+    pandora_test::AllocationTracker many_tracker;
+    DiffUtil::CalculateDiff(&many, false);
+    // Only the snake and range stacks grow, by doubling
+    EXPECT_LE(many_tracker.GetCount(), few_allocations + 12);
+}
+
+TEST(AllocationTest, SingleMutationsAllocateIndependentlyOfSize)
+{
+    RealDataSet<PlainItem> small;
+    small.SetData(MakeItems(100));
+    small.SetListUpdateCallback(std::make_unique<NullCallback>());
+    RealDataSet<PlainItem> large;
+    large.SetData(MakeItems(10000));
+    large.SetListUpdateCallback(std::make_unique<NullCallback>());
+
+    const uint64_t small_allocations = SingleMutationAllocations(small);
+    const uint64_t large_allocations = SingleMutationAllocations(large);
+    EXPECT_EQ(small_allocations, large_allocations);
+    // Per mutation: the diff's working vectors and result, nothing per item
+    EXPECT_LE(large_allocations, 3u * 9u);
+}
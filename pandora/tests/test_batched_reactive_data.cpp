@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include "pandora/pandora_rv.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora::rv;
+
+namespace {
+
+class Profile : public BatchedReactiveData<Profile>
+{
+public:
+    static constexpr int PROPERTY_NAME = 0;
+    static constexpr int PROPERTY_AGE = 3;
+    static constexpr int PROPERTY_AVATAR = 63;
+    static constexpr int PROPERTY_BADGE = 64;  // Beyond the mask
+
+    explicit Profile(ReactiveFlushQueue* queue = nullptr)
+        : BatchedReactiveData(queue)
+    {}
+
+    void SetToViewHolder(std::shared_ptr<IViewHolder<Data>>) override {}
+
+    void SetName(const std::string& name)
+    {
+        name_ = name;
+        NotifyPropertyChanged(PROPERTY_NAME);
+    }
+
+    void SetAge(int age)
+    {
+        age_ = age;
+        NotifyPropertyChanged(PROPERTY_AGE);
+    }
+
+    void SetAvatar(const std::string& avatar)
+    {
+        avatar_ = avatar;
+        NotifyPropertyChanged(PROPERTY_AVATAR);
+    }
+
+    void SetBadge(const std::string& badge)
+    {
+        badge_ = badge;
+        NotifyPropertyChanged(PROPERTY_BADGE);
+    }
+
+private:
+    std::string name_;
+    int age_ = 0;
+    std::string avatar_;
+    std::string badge_;
+};
+
+class ProfileViewHolder : public IReactiveViewHolder<Profile>
+{
+public:
+    std::vector<PropertyMask> batches;
+    std::vector<int> singles;
+
+    void SetData(std::shared_ptr<Profile> data) override
+    {
+        data_ = std::move(data);
+    }
+
+    void OnViewAttachedToWindow() override {}
+    void OnViewDetachedFromWindow() override {}
+    void accept(IViewHolderVisitor&) override {}
+
+    std::shared_ptr<ReactiveData<Profile>> GetReactiveDataIfExist() override
+    {
+        return data_;
+    }
+
+    void OnPropertyChanged(std::shared_ptr<Profile>, int property_id) override
+    {
+        singles.push_back(property_id);
+    }
+
+    void OnPropertiesChanged(std::shared_ptr<Profile> data, PropertyMask mask) override
+    {
+        batches.push_back(mask);
+        IReactiveViewHolder<Profile>::OnPropertiesChanged(data, mask);
+    }
+
+private:
+    std::shared_ptr<Profile> data_;
+};
+
+} // namespace
+
+TEST(BatchedReactiveDataTest, WithoutQueueDeliversImmediately)
+{
+    auto profile = std::make_shared<Profile>();
+    auto vh = std::make_shared<ProfileViewHolder>();
+    profile->BindReactiveVh(vh);
+
+    profile->SetName("a");
+    profile->SetAge(1);
+
+    EXPECT_EQ(vh->batches, (std::vector<PropertyMask>{PropertyBit(0), PropertyBit(3)}));
+    EXPECT_EQ(vh->singles, (std::vector<int>{0, 3}));
+}
+
+TEST(BatchedReactiveDataTest, OutOfRangePropertyIsDeliveredById)
+{
+    ReactiveFlushQueue queue;
+    auto profile = std::make_shared<Profile>(&queue);
+    auto vh = std::make_shared<ProfileViewHolder>();
+    profile->BindReactiveVh(vh);
+
+    profile->SetBadge("new");
+    profile->SetAge(1);
+    profile->SetBadge("newer");
+    EXPECT_EQ(profile->GetDirtyProperties(), PropertyBit(Profile::PROPERTY_AGE));
+    queue.Flush();
+
+    // The mask carries only real bits; the badge arrives once, by its own id
+    EXPECT_EQ(vh->batches, (std::vector<PropertyMask>{PropertyBit(Profile::PROPERTY_AGE)}));
+    EXPECT_EQ(vh->singles, (std::vector<int>{Profile::PROPERTY_AGE, Profile::PROPERTY_BADGE}));
+    EXPECT_EQ(PropertyBit(64), 0u);
+    EXPECT_EQ(PropertyBit(-1), 0u);
+
+    vh->singles.clear();
+    profile->SetBadge("newest");
+    EXPECT_FALSE(queue.IsEmpty());
+    queue.Flush();
+    EXPECT_EQ(vh->batches.size(), 1u);
+    EXPECT_EQ(vh->singles, (std::vector<int>{Profile::PROPERTY_BADGE}));
+}
+
+TEST(BatchedReactiveDataTest, QueueCoalescesUntilFlush)
+{
+    ReactiveFlushQueue queue;
+    auto profile = std::make_shared<Profile>(&queue);
+    auto vh = std::make_shared<ProfileViewHolder>();
+    profile->BindReactiveVh(vh);
+
+    profile->SetName("a");
+    profile->SetAge(1);
+    profile->SetName("b");
+    profile->SetAvatar("c");
+    EXPECT_TRUE(vh->batches.empty());
+    EXPECT_EQ(profile->GetDirtyProperties(),
+              PropertyBit(Profile::PROPERTY_NAME) | PropertyBit(Profile::PROPERTY_AGE) |
+                  PropertyBit(Profile::PROPERTY_AVATAR));
+
+    EXPECT_EQ(queue.Flush(), 1);
+    ASSERT_EQ(vh->batches.size(), 1u);
+    EXPECT_EQ(vh->singles, (std::vector<int>{0, 3, 63}));
+    EXPECT_EQ(profile->GetDirtyProperties(), 0u);
+    EXPECT_TRUE(queue.IsEmpty());
+
+    // Nothing new, nothing delivered
+    EXPECT_EQ(queue.Flush(), 0);
+    profile->SetAge(2);
+    queue.Flush();
+    EXPECT_EQ(vh->batches.size(), 2u);
+}
+
+TEST(BatchedReactiveDataTest, BatchFlushesAtOutermostEnd)
+{
+    ReactiveFlushQueue queue;
+    auto profile = std::make_shared<Profile>(&queue);
+    auto vh = std::make_shared<ProfileViewHolder>();
+    profile->BindReactiveVh(vh);
+
+    profile->StartBatch();
+    profile->SetName("a");
+    profile->StartBatch();
+    profile->SetAge(1);
+    profile->EndBatch();
+    EXPECT_TRUE(vh->batches.empty());
+    EXPECT_TRUE(profile->InBatch());
+    profile->EndBatch();
+
+    EXPECT_EQ(vh->batches, (std::vector<PropertyMask>{PropertyBit(0) | PropertyBit(3)}));
+    EXPECT_TRUE(queue.IsEmpty());
+
+    // Unbalanced EndBatch is ignored
+    profile->EndBatch();
+    EXPECT_FALSE(profile->InBatch());
+}
+
+TEST(BatchedReactiveDataTest, UnboundOrDestroyedDataIsSkipped)
+{
+    ReactiveFlushQueue queue;
+    auto vh = std::make_shared<ProfileViewHolder>();
+    {
+        auto profile = std::make_shared<Profile>(&queue);
+        profile->BindReactiveVh(vh);
+        profile->SetName("a");
+    }
+    EXPECT_EQ(queue.Flush(), 0);
+
+    auto profile = std::make_shared<Profile>(&queue);
+    profile->BindReactiveVh(vh);
+    profile->UnbindReactiveVh();
+    profile->SetName("b");
+    queue.Flush();
+    EXPECT_TRUE(vh->batches.empty());
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "pandora/pandora_rv.h"
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using namespace pandora::rv;
+
+namespace {
+
+using std::chrono::microseconds;
+
+// A clock that only moves when a bind "costs" time
+class FakeClock
+{
+public:
+    BindScheduler::Clock::time_point Now() const
+    {
+        return now_;
+    }
+
+    void Advance(microseconds d)
+    {
+        now_ += d;
+    }
+
+private:
+    BindScheduler::Clock::time_point now_{};
+};
+
+class BindSchedulerTest : public ::testing::Test
+{
+protected:
+    BindSchedulerTest()
+        : scheduler_(microseconds(100), [this] { return clock_.Now(); })
+    {}
+
+    void ScheduleBind(int position, int view_type, microseconds cost)
+    {
+        scheduler_.Schedule(position, view_type, [this, position, cost] {
+            clock_.Advance(cost);
+            bound_.push_back(position);
+        });
+    }
+
+    FakeClock clock_;
+    BindScheduler scheduler_;
+    std::vector<int> bound_;
+};
+
+} // namespace
+
+TEST_F(BindSchedulerTest, VisibleRowsIgnoreBudget)
+{
+    scheduler_.UpdateViewport(0, 4, ScrollDirection::NONE, 0);
+    for (int i = 4; i >= 0; --i) {
+        ScheduleBind(i, 0, microseconds(50));
+    }
+
+    EXPECT_EQ(scheduler_.RunFrame(), 5);
+    EXPECT_EQ(bound_, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(scheduler_.GetPendingCount(), 0);
+}
+
+TEST_F(BindSchedulerTest, PrefetchFollowsScrollDirectionWithinBudget)
+{
+    // Measure the cost of view type 0 first
+    scheduler_.UpdateViewport(10, 10, ScrollDirection::NONE, 0);
+    ScheduleBind(10, 0, microseconds(30));
+    scheduler_.RunFrame();
+    bound_.clear();
+
+    scheduler_.UpdateViewport(10, 12, ScrollDirection::FORWARD, 5);
+    for (int i = 5; i <= 17; ++i) {
+        ScheduleBind(i, 0, microseconds(30));
+    }
+
+    // Visible 10..12 are forced in, then 13, 14, 15 fit in the 100us budget
+    scheduler_.RunFrame();
+    EXPECT_EQ(bound_, (std::vector<int>{10, 11, 12, 13, 14, 15}));
+
+    // Next frame continues ahead of the viewport before going backwards
+    bound_.clear();
+    scheduler_.RunFrame();
+    EXPECT_EQ(bound_, (std::vector<int>{16, 17, 9}));
+
+    scheduler_.UpdateViewport(4, 6, ScrollDirection::BACKWARD, 2);
+    bound_.clear();
+    scheduler_.RunFrame();
+    EXPECT_EQ(bound_, (std::vector<int>{5, 6, 7, 8}));
+    EXPECT_EQ(scheduler_.GetPendingCount(), 0);
+}
+
+TEST_F(BindSchedulerTest, HeavyViewTypeIsDeferred)
+{
+    scheduler_.UpdateViewport(0, 0, ScrollDirection::NONE, 0);
+    ScheduleBind(0, 1, microseconds(150));
+    scheduler_.RunFrame();
+
+    scheduler_.UpdateViewport(0, 0, ScrollDirection::FORWARD, 2);
+    ScheduleBind(1, 1, microseconds(150));
+    ScheduleBind(2, 0, microseconds(10));
+    bound_.clear();
+
+    // The predicted cost of row 1 exceeds the budget; it waits for a later frame
+    EXPECT_EQ(scheduler_.RunFrame(), 0);
+    EXPECT_TRUE(scheduler_.IsPending(1));
+
+    scheduler_.SetFrameBudget(microseconds(200));
+    EXPECT_EQ(scheduler_.RunFrame(), 2);
+    EXPECT_EQ(bound_, (std::vector<int>{1, 2}));
+}
+
+TEST_F(BindSchedulerTest, RescheduleAndCancel)
+{
+    scheduler_.UpdateViewport(0, 3, ScrollDirection::NONE, 0);
+    ScheduleBind(0, 0, microseconds(1));
+    ScheduleBind(1, 0, microseconds(1));
+    ScheduleBind(1, 0, microseconds(1));
+    ScheduleBind(2, 0, microseconds(1));
+    scheduler_.Cancel(2);
+
+    EXPECT_EQ(scheduler_.GetPendingCount(), 2);
+    scheduler_.RunFrame();
+    EXPECT_EQ(bound_, (std::vector<int>{0, 1}));
+}
+
+TEST_F(BindSchedulerTest, TaskMayCancelOtherPendingBinds)
+{
+    scheduler_.UpdateViewport(0, 2, ScrollDirection::NONE, 0);
+    scheduler_.Schedule(0, 0, [this] {
+        bound_.push_back(0);
+        scheduler_.Cancel(1);  // the next visible position
+    });
+    ScheduleBind(1, 0, microseconds(1));
+    ScheduleBind(2, 0, microseconds(1));
+    scheduler_.Schedule(10, 0, [this] {
+        bound_.push_back(10);
+        scheduler_.Cancel(20);  // a later candidate of the same frame
+    });
+    ScheduleBind(20, 0, microseconds(1));
+
+    EXPECT_EQ(scheduler_.RunFrame(), 3);
+    EXPECT_EQ(bound_, (std::vector<int>{0, 2, 10}));
+    EXPECT_EQ(scheduler_.GetPendingCount(), 0);
+}
+
+TEST_F(BindSchedulerTest, CostStatsPerViewType)
+{
+    scheduler_.UpdateViewport(0, 3, ScrollDirection::NONE, 0);
+    ScheduleBind(0, 0, microseconds(10));
+    ScheduleBind(1, 0, microseconds(30));
+    ScheduleBind(2, 7, microseconds(80));
+    scheduler_.Schedule(3, 7, [] { throw std::runtime_error("bind failed"); });
+    scheduler_.RunFrame();
+
+    const BindCostStats light = scheduler_.GetBindCost(0);
+    EXPECT_EQ(light.count, 2);
+    EXPECT_EQ(light.total, microseconds(40));
+    EXPECT_EQ(light.max, microseconds(30));
+    EXPECT_EQ(light.Average(), microseconds(20));
+
+    const BindCostStats heavy = scheduler_.GetBindCost(7);
+    EXPECT_EQ(heavy.count, 2);
+    EXPECT_EQ(heavy.max, microseconds(80));
+
+    EXPECT_EQ(scheduler_.GetBindCost(3).count, 0);
+    EXPECT_EQ(scheduler_.GetAllBindCosts().size(), 2u);
+}
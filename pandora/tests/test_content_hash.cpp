@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include "pandora/pandora_traits.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct PodRow
+{
+    int32_t id;
+    int32_t version;
+    int64_t timestamp;
+
+    bool operator==(const PodRow& other) const { return id == other.id; }
+};
+
+struct WithHashMethod
+{
+    int32_t id;
+
+    size_t Hash() const { return 42; }
+};
+
+struct Padded
+{
+    char tag;
+    int value;
+};
+
+enum class Color : uint8_t { RED, GREEN };
+
+template <size_t N>
+struct Bytes
+{
+    uint8_t data[N];
+};
+
+class CountingCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { inserted += count; }
+    void OnRemoved(int position, int count) override { removed += count; }
+    void OnMoved(int from_position, int to_position) override { ++moved; }
+    void OnChanged(int position, int count, void* payload) override { changed += count; }
+
+    int inserted = 0;
+    int removed = 0;
+    int moved = 0;
+    int changed = 0;
+};
+
+template <size_t N>
+void ExpectEveryByteMatters()
+{
+    Bytes<N> bytes{};
+    std::set<size_t> hashes{Pandora::Hash(bytes)};
+    for (size_t i = 0; i < N; ++i)
+    {
+        Bytes<N> flipped = bytes;
+        flipped.data[i] = 1;
+        hashes.insert(Pandora::Hash(flipped));
+    }
+    EXPECT_EQ(N + 1, hashes.size()) << "size " << N;
+}
+
+} // namespace
+
+TEST(ContentHashTest, SelectsBytewiseHasherForPlainTypes)
+{
+    static_assert(IsBytewiseHashable<PodRow>::value);
+    static_assert(IsBytewiseHashable<Color>::value);
+    static_assert(!IsBytewiseHashable<WithHashMethod>::value);
+    static_assert(!IsBytewiseHashable<Padded>::value);
+    static_assert(!IsBytewiseHashable<int>::value);
+    static_assert(!IsBytewiseHashable<PodRow*>::value);
+
+    EXPECT_EQ(42u, Pandora::Hash(WithHashMethod{1}));
+    EXPECT_EQ(std::hash<int>{}(7), Pandora::Hash(7));
+    EXPECT_NE(Pandora::Hash(Color::RED), Pandora::Hash(Color::GREEN));
+}
+
+TEST(ContentHashTest, EqualValuesHashEqual)
+{
+    const PodRow a{1, 2, 3};
+    const PodRow b{1, 2, 3};
+    EXPECT_EQ(Pandora::Hash(a), Pandora::Hash(b));
+    EXPECT_NE(Pandora::Hash(a), Pandora::Hash(PodRow{1, 3, 3}));
+    EXPECT_NE(Pandora::Hash(a), Pandora::Hash(PodRow{1, 2, 4}));
+}
+
+TEST(ContentHashTest, EveryByteContributesAtEveryLength)
+{
+    // Covers the 1-3, 4-16, 17-48 and over 48 byte paths
+    ExpectEveryByteMatters<1>();
+    ExpectEveryByteMatters<3>();
+    ExpectEveryByteMatters<4>();
+    ExpectEveryByteMatters<7>();
+    ExpectEveryByteMatters<16>();
+    ExpectEveryByteMatters<17>();
+    ExpectEveryByteMatters<48>();
+    ExpectEveryByteMatters<49>();
+    ExpectEveryByteMatters<100>();
+}
+
+TEST(ContentHashTest, HashRangeMatchesSingleHashes)
+{
+    std::vector<PodRow> rows;
+    for (int i = 0; i < 11; ++i) rows.push_back(PodRow{i, i * 3, i * 1000LL});
+    for (size_t count = 0; count <= rows.size(); ++count)
+    {
+        std::vector<size_t> hashes(count + 1, 0);
+        Pandora::HashRange(rows.data(), count, hashes.data());
+        for (size_t i = 0; i < count; ++i) EXPECT_EQ(Pandora::Hash(rows[i]), hashes[i]);
+        EXPECT_EQ(0u, hashes[count]);  // Nothing written past the range
+    }
+
+    std::vector<WithHashMethod> others{{1}, {2}};
+    std::vector<size_t> other_hashes(2);
+    Pandora::HashRange(others.data(), others.size(), other_hashes.data());
+    EXPECT_EQ(42u, other_hashes[1]);
+}
+
+TEST(ContentHashTest, DataSetsDetectChangesOfPlainRows)
+{
+    WrapperDataSet<PodRow> root;
+    auto leaf = std::make_unique<RealDataSet<PodRow>>();
+    RealDataSet<PodRow>* leaf_ptr = leaf.get();
+    leaf->SetData({PodRow{1, 0, 0}, PodRow{2, 0, 0}, PodRow{3, 0, 0}});
+    root.AddChild(std::move(leaf));
+    auto callback = std::make_unique<CountingCallback>();
+    CountingCallback* counting = callback.get();
+    root.SetListUpdateCallback(std::move(callback));
+
+    leaf_ptr->ReplaceAtPosIfExist(1, PodRow{2, 1, 0});
+    EXPECT_EQ(1, counting->changed);
+    leaf_ptr->ReplaceAtPosIfExist(1, PodRow{2, 1, 0});
+    EXPECT_EQ(1, counting->changed);
+}
+
+namespace {
+
+struct NoEqualsRow
+{
+    int32_t a;
+    int32_t b;
+};
+
+struct IdEqualsRow
+{
+    int32_t id;
+    int32_t version;
+
+    bool operator==(const IdEqualsRow& other) const { return id == other.id; }
+};
+
+struct MemberwiseRow
+{
+    int32_t id;
+    int32_t version;
+
+    bool operator==(const MemberwiseRow& other) const { return id == other.id && version == other.version; }
+};
+
+} // namespace
+
+template <>
+struct pandora::UseBytewiseEquals<MemberwiseRow> : std::true_type {};
+
+TEST(ContentEqualsTest, BytewiseOnlyWhereItMatchesOperatorEquals)
+{
+    static_assert(IsBytewiseComparable<int>::value);
+    static_assert(IsBytewiseComparable<Color>::value);
+    static_assert(IsBytewiseComparable<NoEqualsRow>::value);
+    static_assert(IsBytewiseComparable<MemberwiseRow>::value);
+    // An identity operator== must keep deciding AreItemsTheSame
+    static_assert(!IsBytewiseComparable<IdEqualsRow>::value);
+    static_assert(!IsBytewiseComparable<double>::value);
+
+    EXPECT_TRUE(Pandora::Equals(NoEqualsRow{1, 2}, NoEqualsRow{1, 2}));
+    EXPECT_FALSE(Pandora::Equals(NoEqualsRow{1, 2}, NoEqualsRow{1, 3}));
+    EXPECT_TRUE(Pandora::Equals(IdEqualsRow{1, 2}, IdEqualsRow{1, 3}));
+    EXPECT_FALSE(Pandora::Equals(MemberwiseRow{1, 2}, MemberwiseRow{1, 3}));
+}
+
+TEST(ContentEqualsTest, MismatchLengthFindsFirstDifference)
+{
+    // Long enough for several memcmp blocks, with differences inside and at the edges of blocks
+    std::vector<NoEqualsRow> lhs;
+    for (int i = 0; i < 200; ++i) lhs.push_back(NoEqualsRow{i, -i});
+    for (size_t mismatch : {size_t{0}, size_t{1}, size_t{31}, size_t{32}, size_t{100}, size_t{199}})
+    {
+        std::vector<NoEqualsRow> rhs = lhs;
+        rhs[mismatch].b = 7;
+        EXPECT_EQ(mismatch, Pandora::MismatchLength(lhs.data(), rhs.data(), lhs.size()));
+        EXPECT_EQ(lhs.size() - mismatch - 1,
+                  Pandora::MismatchLengthBackward(lhs.data() + lhs.size(), rhs.data() + rhs.size(), lhs.size()));
+    }
+    EXPECT_EQ(lhs.size(), Pandora::MismatchLength(lhs.data(), lhs.data(), lhs.size()));
+    EXPECT_EQ(0u, Pandora::MismatchLength(lhs.data(), lhs.data(), 0));
+
+    std::vector<IdEqualsRow> ids{{1, 0}, {2, 0}, {3, 0}};
+    std::vector<IdEqualsRow> versions{{1, 5}, {2, 5}, {4, 5}};
+    EXPECT_EQ(2u, Pandora::MismatchLength(ids.data(), versions.data(), 3));
+    EXPECT_EQ(0u, Pandora::MismatchLengthBackward(ids.data() + 3, versions.data() + 3, 3));
+}
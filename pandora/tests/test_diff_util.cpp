@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include "pandora/diff_util.h"
@@ -281,3 +282,236 @@ TEST(DiffUtilTest, OldFilledNewEmpty) {
   EXPECT_EQ(update_callback.updates[0].type, TestListUpdateCallback::Update::REMOVE);
 }
 
+
+TEST(DiffUtilTest, ReplaceInTheMiddle) {
+  std::vector<TestItem> old_list;
+  for (int i = 0; i < 10; ++i) old_list.emplace_back(i, "Item");
+  std::vector<TestItem> new_list = old_list;
+  new_list[3] = TestItem(100, "Other");
+
+  TestDiffCallback callback(old_list, new_list);
+  auto result = DiffUtil::CalculateDiff(&callback);
+
+  TestListUpdateCallback update_callback;
+  result->DispatchUpdatesTo(&update_callback);
+
+  // Snakes found in sub-ranges must be stored in global coordinates
+  ASSERT_EQ(update_callback.updates.size(), 2);
+  EXPECT_EQ(update_callback.updates[0].type, TestListUpdateCallback::Update::REMOVE);
+  EXPECT_EQ(update_callback.updates[0].position, 3);
+  EXPECT_EQ(update_callback.updates[1].type, TestListUpdateCallback::Update::INSERT);
+  EXPECT_EQ(update_callback.updates[1].position, 3);
+  EXPECT_EQ(result->ConvertOldPositionToNew(9), 9);
+}
+
+// Compares whole runs of ids, and counts how DiffUtil asks for them
+class RunDiffCallback : public TestDiffCallback {
+ public:
+  RunDiffCallback(const std::vector<TestItem>& old_list,
+                  const std::vector<TestItem>& new_list)
+      : TestDiffCallback(old_list, new_list), old_list_(old_list), new_list_(new_list) {}
+
+  int CountItemsTheSame(int old_item_position, int new_item_position, int max_count) const override {
+    ++run_calls;
+    int count = 0;
+    while (count < max_count &&
+           old_list_[old_item_position + count].id == new_list_[new_item_position + count].id) {
+      ++count;
+    }
+    return count;
+  }
+
+  int CountItemsTheSameBackward(int old_item_end, int new_item_end, int max_count) const override {
+    ++run_calls;
+    int count = 0;
+    while (count < max_count &&
+           old_list_[old_item_end - count - 1].id == new_list_[new_item_end - count - 1].id) {
+      ++count;
+    }
+    return count;
+  }
+
+  bool AreItemsTheSame(int old_item_position, int new_item_position) const override {
+    ++single_calls;
+    return TestDiffCallback::AreItemsTheSame(old_item_position, new_item_position);
+  }
+
+  mutable int run_calls = 0;
+  mutable int single_calls = 0;
+
+ private:
+  const std::vector<TestItem>& old_list_;
+  const std::vector<TestItem>& new_list_;
+};
+
+TEST(DiffUtilTest, SnakesExtendThroughRunCallbacks) {
+  std::vector<TestItem> old_list;
+  for (int i = 0; i < 50; ++i) old_list.emplace_back(i, "Item");
+  std::vector<TestItem> new_list = old_list;
+  new_list.erase(new_list.begin() + 10);
+  new_list.insert(new_list.begin() + 30, TestItem(100, "New"));
+  new_list[40].name = "Changed";
+
+  TestDiffCallback plain(old_list, new_list);
+  TestListUpdateCallback plain_updates;
+  DiffUtil::CalculateDiff(&plain)->DispatchUpdatesTo(&plain_updates);
+
+  RunDiffCallback runs(old_list, new_list);
+  TestListUpdateCallback run_updates;
+  DiffUtil::CalculateDiff(&runs)->DispatchUpdatesTo(&run_updates);
+
+  EXPECT_GT(runs.run_calls, 0);
+  ASSERT_EQ(plain_updates.updates.size(), run_updates.updates.size());
+  for (size_t i = 0; i < plain_updates.updates.size(); ++i) {
+    EXPECT_EQ(plain_updates.updates[i].type, run_updates.updates[i].type);
+    EXPECT_EQ(plain_updates.updates[i].position, run_updates.updates[i].position);
+    EXPECT_EQ(plain_updates.updates[i].count, run_updates.updates[i].count);
+  }
+}
+
+TEST(DiffUtilTest, BatchPositionConversionMatchesSingleCalls) {
+  std::vector<TestItem> old_list;
+  for (int i = 0; i < 40; ++i) old_list.emplace_back(i, "Item");
+  std::vector<TestItem> new_list = old_list;
+  new_list.erase(new_list.begin() + 5, new_list.begin() + 8);
+  std::rotate(new_list.begin(), new_list.begin() + 20, new_list.begin() + 21);  // Move 23 to the front
+  new_list.insert(new_list.begin() + 12, TestItem(100, "New"));
+
+  TestDiffCallback callback(old_list, new_list);
+  auto result = DiffUtil::CalculateDiff(&callback, true);
+
+  std::vector<int> old_positions;
+  for (int i = 0; i < 40; ++i) old_positions.push_back(i);
+  std::vector<int> converted = old_positions;
+  result->ConvertOldPositionsToNew(converted);
+  for (int i = 0; i < 40; ++i) {
+    EXPECT_EQ(result->ConvertOldPositionToNew(i), converted[i]) << "old position " << i;
+  }
+  EXPECT_EQ(0, converted[23]);
+
+  std::vector<int> new_positions;
+  for (int i = 0; i < static_cast<int>(new_list.size()); ++i) new_positions.push_back(i);
+  result->ConvertNewPositionsToOld(new_positions);
+  for (int i = 0; i < static_cast<int>(new_list.size()); ++i) {
+    EXPECT_EQ(result->ConvertNewPositionToOld(i), new_positions[i]) << "new position " << i;
+  }
+
+  // Out of range positions map to NO_POSITION instead of throwing
+  std::vector<int> out_of_range = {-1, 40, 1 << 30};
+  result->ConvertOldPositionsToNew(out_of_range);
+  for (int position : out_of_range) EXPECT_EQ(DiffUtil::DiffResult::NO_POSITION, position);
+
+  const std::vector<int>& statuses = result->GetOldItemStatuses();
+  ASSERT_EQ(40u, statuses.size());
+  EXPECT_EQ(DiffUtil::DiffResult::NO_POSITION, DiffUtil::DiffResult::StatusToPosition(statuses[6]));
+  EXPECT_EQ(converted[30], DiffUtil::DiffResult::StatusToPosition(statuses[30]));
+}
+
+TEST(DiffUtilTest, NearestSurvivingPositionKeepsAnchor) {
+  std::vector<TestItem> old_list;
+  for (int i = 0; i < 6; ++i) old_list.emplace_back(i, "Item");
+  // Remove 2, 3 and 5
+  std::vector<TestItem> new_list = {old_list[0], old_list[1], old_list[4]};
+
+  TestDiffCallback callback(old_list, new_list);
+  auto result = DiffUtil::CalculateDiff(&callback);
+
+  EXPECT_EQ(1, result->ConvertOldPositionToNearestNew(1));
+  EXPECT_EQ(2, result->ConvertOldPositionToNearestNew(2));  // Next survivor is 4
+  EXPECT_EQ(2, result->ConvertOldPositionToNearestNew(5));  // None after, last one before is 4
+  EXPECT_EQ(DiffUtil::DiffResult::NO_POSITION, result->ConvertOldPositionToNearestNew(6));
+
+  std::vector<int> anchors = {0, 3, 5};
+  result->ConvertOldPositionsToNearestNew(anchors.data(), anchors.size());
+  EXPECT_EQ((std::vector<int>{0, 2, 2}), anchors);
+
+  std::vector<TestItem> empty;
+  TestDiffCallback cleared(old_list, empty);
+  EXPECT_EQ(DiffUtil::DiffResult::NO_POSITION, DiffUtil::CalculateDiff(&cleared)->ConvertOldPositionToNearestNew(0));
+}
+
+namespace {
+
+// Applies pulled updates the way DispatchUpdatesTo reports them
+void Apply(const DiffUtil::UpdateOp& op, TestListUpdateCallback& callback) {
+  switch (op.type) {
+    case DiffUtil::UpdateOp::INSERTED: callback.OnInserted(op.position, op.count); break;
+    case DiffUtil::UpdateOp::REMOVED: callback.OnRemoved(op.position, op.count); break;
+    case DiffUtil::UpdateOp::MOVED: callback.OnMoved(op.position, op.to_position); break;
+    case DiffUtil::UpdateOp::CHANGED: callback.OnChanged(op.position, op.count, nullptr); break;
+  }
+}
+
+void ExpectSameUpdates(const TestListUpdateCallback& expected, const TestListUpdateCallback& actual) {
+  ASSERT_EQ(expected.updates.size(), actual.updates.size());
+  for (size_t i = 0; i < expected.updates.size(); ++i) {
+    EXPECT_EQ(expected.updates[i].type, actual.updates[i].type) << "update " << i;
+    EXPECT_EQ(expected.updates[i].position, actual.updates[i].position) << "update " << i;
+    EXPECT_EQ(expected.updates[i].count, actual.updates[i].count) << "update " << i;
+    EXPECT_EQ(expected.updates[i].to_position, actual.updates[i].to_position) << "update " << i;
+  }
+}
+
+}  // namespace
+
+TEST(DiffUtilTest, PulledUpdatesMatchDispatchedOnes) {
+  std::vector<TestItem> old_list;
+  for (int i = 0; i < 30; ++i) old_list.emplace_back(i, "Item");
+  std::vector<TestItem> new_list = old_list;
+  new_list.erase(new_list.begin() + 3, new_list.begin() + 5);
+  std::rotate(new_list.begin() + 2, new_list.begin() + 20, new_list.begin() + 21);
+  new_list[2].name = "Moved and changed";
+  new_list[10].name = "Changed";
+  new_list.insert(new_list.begin() + 15, TestItem(100, "New"));
+
+  for (bool detect_moves : {true, false}) {
+    TestDiffCallback callback(old_list, new_list);
+    auto result = DiffUtil::CalculateDiff(&callback, detect_moves);
+    TestListUpdateCallback dispatched;
+    result->DispatchUpdatesTo(&dispatched);
+
+    TestListUpdateCallback pulled;
+    for (const DiffUtil::UpdateOp& op : result->GetUpdates()) Apply(op, pulled);
+    ExpectSameUpdates(dispatched, pulled);
+
+    TestListUpdateCallback chunked;
+    DiffUtil::DiffResult::UpdateStream updates = result->GetUpdates();
+    DiffUtil::UpdateOp ops[4];
+    while (const size_t count = updates.Next(ops, 4)) {
+      for (size_t i = 0; i < count; ++i) Apply(ops[i], chunked);
+    }
+    ExpectSameUpdates(dispatched, chunked);
+  }
+}
+
+TEST(DiffUtilTest, PulledUpdatesResumeWhereTheyStopped) {
+  std::vector<TestItem> old_list;
+  for (int i = 0; i < 20; ++i) old_list.emplace_back(i, "Item");
+  std::vector<TestItem> new_list;
+  for (int i = 19; i >= 0; i -= 2) new_list.emplace_back(i, i % 3 == 0 ? "Changed" : "Item");
+
+  TestDiffCallback callback(old_list, new_list);
+  auto result = DiffUtil::CalculateDiff(&callback, true);
+  TestListUpdateCallback dispatched;
+  result->DispatchUpdatesTo(&dispatched);
+  ASSERT_GT(dispatched.updates.size(), 6u);
+
+  // Three updates per frame
+  DiffUtil::DiffResult::UpdateStream updates = result->GetUpdates();
+  TestListUpdateCallback pulled;
+  int frames = 0;
+  while (!updates.Done()) {
+    int budget = 3;
+    for (const DiffUtil::UpdateOp& op : updates) {
+      Apply(op, pulled);
+      if (--budget == 0) break;
+    }
+    frames++;
+  }
+  EXPECT_GT(frames, 2);
+  ExpectSameUpdates(dispatched, pulled);
+
+  DiffUtil::UpdateOp op;
+  EXPECT_FALSE(updates.Next(op));
+  EXPECT_TRUE(updates.begin() == updates.end());
+}
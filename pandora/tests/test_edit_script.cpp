@@ -0,0 +1,333 @@
+#include <gtest/gtest.h>
+#include "pandora/diff_util.h"
+#include "pandora/edit_script.h"
+#include "pandora/field_hashers.h"
+#include "pandora/real_data_set.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct Row
+{
+    int32_t id;
+    int32_t version;
+
+    bool operator==(const Row& other) const { return id == other.id; }
+};
+
+struct Article
+{
+    uint64_t id;
+    std::string title;
+    int likes;
+
+    bool operator==(const Article& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, title);
+        HashCombine(seed, likes);
+        return seed;
+    }
+};
+
+struct Update
+{
+    char type;
+    int first;
+    int second;
+    uint64_t mask;
+
+    bool operator==(const Update& other) const
+    {
+        return type == other.type && first == other.first && second == other.second && mask == other.mask;
+    }
+};
+
+class RecordingCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { updates.push_back({'I', position, count, 0}); }
+    void OnRemoved(int position, int count) override { updates.push_back({'R', position, count, 0}); }
+    void OnMoved(int from_position, int to_position) override { updates.push_back({'M', from_position, to_position, 0}); }
+    void OnChanged(int position, int count, void* payload) override { updates.push_back({'C', position, count, 0}); }
+    void OnChangedWithPayload(int position, int count, const Payload& payload) override
+    {
+        const auto* mask = payload.Get<FieldChangeMask>();
+        updates.push_back({'C', position, count, mask ? mask->bits : 0});
+    }
+    void OnUpdatesDispatched() override { updates.push_back({'D', 0, 0, 0}); }
+
+    std::vector<Update> updates;
+};
+
+// Journals the updates of a source data set while recording them for comparison
+class TeeCallback : public ListUpdateCallback
+{
+public:
+    TeeCallback(ListUpdateCallback* first, ListUpdateCallback* second) : first_(first), second_(second) {}
+
+    void OnInserted(int position, int count) override
+    {
+        first_->OnInserted(position, count);
+        second_->OnInserted(position, count);
+    }
+    void OnRemoved(int position, int count) override
+    {
+        first_->OnRemoved(position, count);
+        second_->OnRemoved(position, count);
+    }
+    void OnMoved(int from_position, int to_position) override
+    {
+        first_->OnMoved(from_position, to_position);
+        second_->OnMoved(from_position, to_position);
+    }
+    void OnChanged(int position, int count, void* payload) override
+    {
+        OnChangedWithPayload(position, count, Payload::Borrow(payload));
+    }
+    void OnChangedWithPayload(int position, int count, const Payload& payload) override
+    {
+        first_->OnChangedWithPayload(position, count, payload);
+        second_->OnChangedWithPayload(position, count, payload);
+    }
+    void OnUpdatesDispatched() override
+    {
+        first_->OnUpdatesDispatched();
+        second_->OnUpdatesDispatched();
+    }
+
+private:
+    ListUpdateCallback* first_;
+    ListUpdateCallback* second_;
+};
+
+class RowDiffCallback : public DiffCallback
+{
+public:
+    RowDiffCallback(const std::vector<Row>& old_list, const std::vector<Row>& new_list)
+        : old_list_(old_list), new_list_(new_list) {}
+
+    int GetOldListSize() const override { return static_cast<int>(old_list_.size()); }
+    int GetNewListSize() const override { return static_cast<int>(new_list_.size()); }
+    bool AreItemsTheSame(int old_pos, int new_pos) const override { return old_list_[old_pos].id == new_list_[new_pos].id; }
+    bool AreContentsTheSame(int old_pos, int new_pos) const override
+    {
+        return old_list_[old_pos].version == new_list_[new_pos].version;
+    }
+    Payload GetTypedChangePayload(int old_pos, int new_pos) const override
+    {
+        return Payload(FieldChangeMask{static_cast<uint64_t>(new_list_[new_pos].version)});
+    }
+
+private:
+    const std::vector<Row>& old_list_;
+    const std::vector<Row>& new_list_;
+};
+
+std::vector<Row> MakeRows(int count)
+{
+    std::vector<Row> rows;
+    for (int i = 0; i < count; ++i) rows.push_back(Row{i, 0});
+    return rows;
+}
+
+void ExpectSameRows(const std::vector<Row>& expected, const std::vector<Row>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].id, actual[i].id) << "at " << i;
+        EXPECT_EQ(expected[i].version, actual[i].version) << "at " << i;
+    }
+}
+
+} // namespace
+
+template <>
+struct pandora::Serializer<Article>
+{
+    static void Write(BinaryWriter& writer, const Article& item)
+    {
+        writer.WriteVarint(item.id);
+        writer.WriteString(item.title);
+        writer.WriteSignedVarint(item.likes);
+    }
+
+    static Article Read(BinaryReader& reader)
+    {
+        const uint64_t id = reader.ReadVarint();
+        std::string title = reader.ReadString();
+        return Article{id, std::move(title), static_cast<int>(reader.ReadSignedVarint())};
+    }
+};
+
+template <>
+struct pandora::FieldHashers<Article> : FieldList<&Article::title, &Article::likes>
+{
+};
+
+TEST(EditScriptTest, ReplaysDiffResultUpdates)
+{
+    const std::vector<Row> old_list = MakeRows(8);
+    // Remove 1, move 6 to the front, change 3 and 6, insert 20 and 21
+    const std::vector<Row> new_list = {{6, 2}, {0, 0}, {2, 0}, {3, 1}, {20, 0}, {4, 0}, {5, 0}, {21, 0}, {7, 0}};
+
+    RowDiffCallback diff_callback(old_list, new_list);
+    auto result = DiffUtil::CalculateDiff(&diff_callback, true);
+    RecordingCallback expected;
+    result->DispatchUpdatesTo(&expected);
+
+    const std::vector<uint8_t> script = EditScriptEncoder<Row>::Encode(*result, new_list);
+
+    RealDataSet<Row> replica(old_list);
+    auto callback = std::make_unique<RecordingCallback>();
+    RecordingCallback* actual = callback.get();
+    replica.SetListUpdateCallback(std::move(callback));
+    EditScriptDecoder<Row>::Apply(script, replica);
+
+    ExpectSameRows(new_list, replica.GetStorage());
+    EXPECT_EQ(expected.updates, actual->updates);
+    EXPECT_EQ(2u, std::count_if(actual->updates.begin(), actual->updates.end(),
+                                [](const Update& update) { return update.type == 'C' && update.mask != 0; }));
+}
+
+TEST(EditScriptTest, ReplaysJournaledMutations)
+{
+    RealDataSet<Row> source(MakeRows(5));
+    RealDataSet<Row> replica(MakeRows(5));
+
+    EditScriptEncoder<Row> encoder(source.GetDataCount());
+    RecordingCallback source_updates;
+    source.SetListUpdateCallback(std::make_unique<TeeCallback>(&encoder, &source_updates));
+
+    source.Add(Row{10, 0});
+    source.Add(0, Row{11, 0});
+    source.RemoveAtPos(3);
+    source.ReplaceAtPosIfExist(1, Row{0, 7});
+    source.StartTransaction();
+    source.RemoveAtPos(4);
+    source.Add(1, Row{4, 0});
+    source.Add(Row{12, 0});
+    source.EndTransaction();
+    const std::vector<uint8_t>& script = encoder.Finish(source);
+
+    auto callback = std::make_unique<RecordingCallback>();
+    RecordingCallback* replica_updates = callback.get();
+    replica.SetListUpdateCallback(std::move(callback));
+    EditScriptDecoder<Row>::Apply(script, replica);
+
+    ExpectSameRows(source.GetStorage(), replica.GetStorage());
+    EXPECT_EQ(source_updates.updates, replica_updates->updates);
+
+    // The next batch starts from the current size
+    encoder.Reset(source.GetDataCount());
+    source.RemoveAtPos(0);
+    EditScriptDecoder<Row>::Apply(encoder.Finish(source), replica);
+    ExpectSameRows(source.GetStorage(), replica.GetStorage());
+}
+
+TEST(EditScriptTest, CarriesSerializedItemsAndFieldMasks)
+{
+    const std::vector<Article> items = {{1, "one", 0}, {2, "two", 0}, {3, "three", 0}};
+    RealDataSet<Article> source(items);
+    std::vector<Article> mirror = items;
+
+    auto journal = std::make_unique<EditScriptEncoder<Article>>(source.GetDataCount());
+    EditScriptEncoder<Article>* journal_ptr = journal.get();
+    source.SetListUpdateCallback(std::move(journal));
+
+    source.ReplaceAtPosIfExist(1, Article{2, "two", 5});
+    source.Add(Article{4, "four", 1});
+
+    RecordingCallback updates;
+    const std::vector<uint8_t>& script = journal_ptr->Finish(source);
+    EditScriptDecoder<Article>::Apply(script.data(), script.size(), mirror, &updates);
+
+    ASSERT_EQ(4u, mirror.size());
+    EXPECT_EQ(5, mirror[1].likes);
+    EXPECT_EQ("four", mirror[3].title);
+    ASSERT_FALSE(updates.updates.empty());
+    EXPECT_EQ('C', updates.updates[0].type);
+    EXPECT_EQ(uint64_t{1} << 1, updates.updates[0].mask);
+}
+
+TEST(EditScriptTest, ScriptSizeScalesWithTheChange)
+{
+    RealDataSet<Row> source(MakeRows(10000));
+    RealDataSet<Row> replica(MakeRows(10000));
+    source.SetListUpdateCallback(std::make_unique<EditScriptEncoder<Row>>(source.GetDataCount()));
+
+    source.ReplaceAtPosIfExist(5000, Row{5000, 3});
+    auto* encoder = static_cast<EditScriptEncoder<Row>*>(source.GetListUpdateCallback());
+    const std::vector<uint8_t>& script = encoder->Finish(source);
+
+    EXPECT_LT(script.size(), 48u);
+    EditScriptDecoder<Row>::Apply(script, replica);
+    EXPECT_EQ(3, replica.GetDataByIndex(5000)->version);
+}
+
+TEST(EditScriptTest, RejectsMalformedScripts)
+{
+    const std::vector<Row> old_list = MakeRows(4);
+    std::vector<Row> new_list = old_list;
+    new_list.insert(new_list.begin() + 2, Row{9, 0});
+    RowDiffCallback diff_callback(old_list, new_list);
+    auto result = DiffUtil::CalculateDiff(&diff_callback);
+    const std::vector<uint8_t> script = EditScriptEncoder<Row>::Encode(*result, new_list);
+
+    RealDataSet<Row> replica(old_list);
+    auto callback = std::make_unique<RecordingCallback>();
+    RecordingCallback* updates = callback.get();
+    replica.SetListUpdateCallback(std::move(callback));
+
+    std::vector<uint8_t> bad_magic = script;
+    bad_magic[0] ^= 0xff;
+    EXPECT_THROW(EditScriptDecoder<Row>::Apply(bad_magic, replica), PandoraException);
+
+    const std::vector<uint8_t> truncated(script.begin(), script.end() - 1);
+    EXPECT_THROW(EditScriptDecoder<Row>::Apply(truncated, replica), PandoraException);
+
+    RealDataSet<Row> other_size(MakeRows(3));
+    EXPECT_THROW(EditScriptDecoder<Row>::Apply(script, other_size), PandoraException);
+
+    ExpectSameRows(old_list, replica.GetStorage());
+    EXPECT_TRUE(updates->updates.empty());
+}
+
+TEST(EditScriptTest, RejectsChangedItemsWithoutContentsOrUnknownPayload)
+{
+    const std::vector<Row> old_list = MakeRows(4);
+    std::vector<Row> new_list = old_list;
+    new_list[1].version = 3;
+    EditScriptEncoder<Row> encoder(4);
+    encoder.OnChanged(1, 1, nullptr);
+    const std::vector<uint8_t> script = encoder.Finish(new_list);
+
+    RealDataSet<Row> replica(old_list);
+    EditScriptDecoder<Row>::Apply(script, replica);
+    ExpectSameRows(new_list, replica.GetStorage());
+
+    // Tail: END, size 4, 1 item, delta 1, then the 8 bytes of the row
+    const size_t tail = 1 + 1 + 1 + 1 + sizeof(Row);
+    ASSERT_GT(script.size(), tail);
+
+    // The changed row is omitted: the stale old row must not be kept
+    std::vector<uint8_t> missing_item(script.begin(), script.end() - 2 - sizeof(Row));
+    missing_item.push_back(0);
+    RealDataSet<Row> stale(old_list);
+    EXPECT_THROW(EditScriptDecoder<Row>::Apply(missing_item, stale), PandoraException);
+    ExpectSameRows(old_list, stale.GetStorage());
+
+    // The payload kind byte right before END
+    std::vector<uint8_t> unknown_payload = script;
+    ASSERT_EQ(0, unknown_payload[script.size() - tail - 1]);
+    unknown_payload[script.size() - tail - 1] = 7;
+    RealDataSet<Row> other(old_list);
+    EXPECT_THROW(EditScriptDecoder<Row>::Apply(unknown_payload, other), PandoraException);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "pandora/field_hashers.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct Article
+{
+    int id;
+    std::string title;
+    int likes;
+    int views;  // Not declared as a field: changes rebind fully
+
+    bool operator==(const Article& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, title);
+        HashCombine(seed, likes);
+        HashCombine(seed, views);
+        return seed;
+    }
+};
+
+struct Counter
+{
+    int id;
+    int value;
+
+    bool operator==(const Counter& other) const { return id == other.id; }
+    size_t Hash() const { return static_cast<size_t>(value); }
+};
+
+constexpr int kTitleField = 0;
+constexpr int kLikesField = 1;
+
+} // namespace
+
+template <>
+struct pandora::FieldHashers<Article> : FieldList<&Article::title, &Article::likes>
+{
+};
+
+namespace {
+
+class PayloadCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override {}
+    void OnRemoved(int position, int count) override {}
+    void OnMoved(int from_position, int to_position) override {}
+    void OnChanged(int position, int count, void* payload) override
+    {
+        positions.push_back(position);
+        const auto* mask = static_cast<const FieldChangeMask*>(payload);
+        masks.push_back(mask ? mask->bits : kNoPayload);
+    }
+
+    static constexpr uint64_t kNoPayload = ~uint64_t{0};
+    std::vector<int> positions;
+    std::vector<uint64_t> masks;
+};
+
+std::vector<Article> MakeArticles()
+{
+    return {Article{1, "a", 0, 0}, Article{2, "b", 0, 0}, Article{3, "c", 0, 0}};
+}
+
+} // namespace
+
+TEST(FieldHashersTest, FieldListHashesEachMember)
+{
+    static_assert(HasFieldHashers<Article>::value);
+    static_assert(!HasFieldHashers<Counter>::value);
+    static_assert(FieldHashers<Article>::kCount == 2);
+
+    uint32_t first[2];
+    uint32_t second[2];
+    FieldHashers<Article>::HashFields(Article{1, "a", 5, 0}, first);
+    FieldHashers<Article>::HashFields(Article{1, "a", 6, 9}, second);
+    EXPECT_EQ(first[kTitleField], second[kTitleField]);
+    EXPECT_NE(first[kLikesField], second[kLikesField]);
+}
+
+TEST(FieldHashersTest, RealDataSetReportsChangedFields)
+{
+    RealDataSet<Article> data_set;
+    data_set.SetData(MakeArticles());
+    auto callback = std::make_unique<PayloadCallback>();
+    PayloadCallback* payloads = callback.get();
+    data_set.SetListUpdateCallback(std::move(callback));
+
+    data_set.ReplaceAtPosIfExist(1, Article{2, "b", 1, 0});
+    ASSERT_EQ(1u, payloads->masks.size());
+    EXPECT_EQ(1, payloads->positions[0]);
+    EXPECT_EQ(uint64_t{1} << kLikesField, payloads->masks[0]);
+
+    data_set.StartTransaction();
+    data_set.ReplaceAtPosIfExist(0, Article{1, "A", 1, 0});
+    data_set.ReplaceAtPosIfExist(2, Article{3, "c", 0, 1});  // Only an undeclared field
+    data_set.EndTransaction();
+    ASSERT_EQ(3u, payloads->masks.size());
+    // Changes are dispatched from the end of the list
+    EXPECT_EQ(2, payloads->positions[1]);
+    EXPECT_EQ(PayloadCallback::kNoPayload, payloads->masks[1]);
+    EXPECT_EQ(0, payloads->positions[2]);
+    EXPECT_EQ((uint64_t{1} << kTitleField) | (uint64_t{1} << kLikesField), payloads->masks[2]);
+}
+
+TEST(FieldHashersTest, WrapperDataSetReportsChangedFields)
+{
+    WrapperDataSet<Article> root;
+    auto leaf = std::make_unique<RealDataSet<Article>>();
+    RealDataSet<Article>* leaf_ptr = leaf.get();
+    root.AddChild(std::make_unique<RealDataSet<Article>>());
+    root.AddChild(std::move(leaf));
+    leaf_ptr->SetData(MakeArticles());
+    auto callback = std::make_unique<PayloadCallback>();
+    PayloadCallback* payloads = callback.get();
+    root.SetListUpdateCallback(std::move(callback));
+
+    leaf_ptr->ReplaceAtPosIfExist(2, Article{3, "C", 0, 0});
+    ASSERT_EQ(1u, payloads->masks.size());
+    EXPECT_EQ(2, payloads->positions[0]);
+    EXPECT_EQ(uint64_t{1} << kTitleField, payloads->masks[0]);
+}
+
+TEST(FieldHashersTest, TypesWithoutFieldHashersSendNoPayload)
+{
+    RealDataSet<Counter> data_set;
+    data_set.SetData({Counter{1, 0}, Counter{2, 0}});
+    auto callback = std::make_unique<PayloadCallback>();
+    PayloadCallback* payloads = callback.get();
+    data_set.SetListUpdateCallback(std::move(callback));
+
+    data_set.ReplaceAtPosIfExist(0, Counter{1, 5});
+    ASSERT_EQ(1u, payloads->masks.size());
+    EXPECT_EQ(PayloadCallback::kNoPayload, payloads->masks[0]);
+}
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include "pandora/filtered_view.h"
+#include "pandora/real_data_set.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+// Applies the view's updates to a mirror of its contents, like an observer would
+class MirrorCallback : public ListUpdateCallback
+{
+public:
+    static constexpr int kUnknown = -1;
+
+    explicit MirrorCallback(std::vector<int>& mirror) : mirror_(mirror) {}
+
+    void OnInserted(int position, int count) override
+    {
+        ASSERT_LE(position, static_cast<int>(mirror_.size()));
+        mirror_.insert(mirror_.begin() + position, count, kUnknown);
+        ++calls;
+    }
+
+    void OnRemoved(int position, int count) override
+    {
+        ASSERT_LE(position + count, static_cast<int>(mirror_.size()));
+        mirror_.erase(mirror_.begin() + position, mirror_.begin() + position + count);
+        ++calls;
+    }
+
+    void OnMoved(int from_position, int to_position) override
+    {
+        const int value = mirror_[from_position];
+        mirror_.erase(mirror_.begin() + from_position);
+        mirror_.insert(mirror_.begin() + to_position, value);
+        ++calls;
+    }
+
+    void OnChanged(int position, int count, void*) override
+    {
+        ASSERT_LE(position + count, static_cast<int>(mirror_.size()));
+        std::fill(mirror_.begin() + position, mirror_.begin() + position + count, kUnknown);
+        ++calls;
+    }
+
+    int calls = 0;
+
+private:
+    std::vector<int>& mirror_;
+};
+
+class CountingCallback : public ListUpdateCallback
+{
+public:
+    explicit CountingCallback(int& calls) : calls_(calls) {}
+
+    void OnInserted(int, int) override { ++calls_; }
+    void OnRemoved(int, int) override { ++calls_; }
+    void OnMoved(int, int) override { ++calls_; }
+    void OnChanged(int, int, void*) override { ++calls_; }
+
+private:
+    int& calls_;
+};
+
+std::vector<int> Contents(FilteredView<int>& view)
+{
+    std::vector<int> result;
+    for (int i = 0; i < view.GetDataCount(); ++i)
+    {
+        result.push_back(*view.GetDataByIndex(i));
+    }
+    return result;
+}
+
+// Every entry the observer did not have to refresh must still be right
+void ExpectMirrorMatches(std::vector<int>& mirror, FilteredView<int>& view)
+{
+    const std::vector<int> actual = Contents(view);
+    ASSERT_EQ(mirror.size(), actual.size());
+    for (size_t i = 0; i < mirror.size(); ++i)
+    {
+        if (mirror[i] != MirrorCallback::kUnknown)
+        {
+            EXPECT_EQ(mirror[i], actual[i]) << "at " << i;
+        }
+        mirror[i] = actual[i];
+    }
+}
+
+bool IsEven(const int& value)
+{
+    return value % 2 == 0;
+}
+
+class FilteredViewTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        source_.SetData({1, 2, 3, 4, 5, 6});
+        view_ = std::make_unique<FilteredView<int>>(&source_, IsEven);
+        mirror_ = Contents(*view_);
+        auto callback = std::make_unique<MirrorCallback>(mirror_);
+        callback_ = callback.get();
+        view_->SetListUpdateCallback(std::move(callback));
+    }
+
+    RealDataSet<int> source_;
+    std::unique_ptr<FilteredView<int>> view_;
+    std::vector<int> mirror_;
+    MirrorCallback* callback_ = nullptr;
+};
+
+} // namespace
+
+TEST_F(FilteredViewTest, InitialFilterAndIndexMap)
+{
+    EXPECT_EQ(Contents(*view_), (std::vector<int>{2, 4, 6}));
+    EXPECT_EQ(view_->GetSourceIndex(1), 3);
+    EXPECT_EQ(view_->GetVisibleIndex(5), 2);
+    EXPECT_EQ(view_->GetVisibleIndex(0), -1);
+    EXPECT_EQ(view_->GetDataByIndex(3), nullptr);
+}
+
+TEST_F(FilteredViewTest, SourceUpdatesArePropagatedPrecisely)
+{
+    source_.Add(8);
+    source_.Add(9);
+    EXPECT_EQ(callback_->calls, 1);
+    ExpectMirrorMatches(mirror_, *view_);
+
+    source_.Add(0, 10);
+    source_.RemoveAtPos(2);  // 2
+    ExpectMirrorMatches(mirror_, *view_);
+    EXPECT_EQ(Contents(*view_), (std::vector<int>{10, 4, 6, 8}));
+
+    // Hidden -> visible, visible -> hidden
+    source_.ReplaceAtPosIfExist(1, 12);
+    source_.ReplaceAtPosIfExist(3, 7);
+    ExpectMirrorMatches(mirror_, *view_);
+    EXPECT_EQ(Contents(*view_), (std::vector<int>{10, 12, 6, 8}));
+}
+
+TEST_F(FilteredViewTest, FilteredOutChangesAreSilent)
+{
+    source_.Add(7);
+    source_.RemoveAtPos(0);
+    EXPECT_EQ(callback_->calls, 0);
+}
+
+TEST_F(FilteredViewTest, PredicateChangeIsReportedAsMerge)
+{
+    view_->SetPredicate([](const int& v) { return v > 3; });
+    ExpectMirrorMatches(mirror_, *view_);
+    EXPECT_EQ(Contents(*view_), (std::vector<int>{4, 5, 6}));
+
+    view_->SetPredicate(nullptr);
+    ExpectMirrorMatches(mirror_, *view_);
+    EXPECT_EQ(Contents(*view_), (std::vector<int>{1, 2, 3, 4, 5, 6}));
+}
+
+TEST(FilteredViewParallelTest, ParallelEvaluationMatchesSerial)
+{
+    std::vector<int> data(20000);
+    for (int i = 0; i < static_cast<int>(data.size()); ++i) data[i] = i;
+    RealDataSet<int> source;
+    source.SetData(data);
+
+    FilteredView<int> view(&source, IsEven, 64);
+    EXPECT_EQ(view.GetDataCount(), 10000);
+
+    std::vector<int> mirror = Contents(view);
+    view.SetListUpdateCallback(std::make_unique<MirrorCallback>(mirror));
+    view.SetPredicate([](const int& v) { return v % 3 == 0; });
+    ExpectMirrorMatches(mirror, view);
+    EXPECT_EQ(view.GetDataCount(), 6667);
+    for (int i = 0; i < view.GetDataCount(); ++i)
+    {
+        ASSERT_EQ(*view.GetDataByIndex(i), i * 3);
+    }
+}
+
+TEST(FilteredViewChainTest, PreviousCallbackIsKeptAndRestored)
+{
+    RealDataSet<int> source;
+    int source_calls = 0;
+    source.SetListUpdateCallback(std::make_unique<CountingCallback>(source_calls));
+    ListUpdateCallback* original = source.GetListUpdateCallback();
+    {
+        FilteredView<int> view(&source, IsEven);
+        source.Add(1);
+        EXPECT_EQ(source_calls, 1);
+        EXPECT_EQ(view.GetDataCount(), 0);
+    }
+    EXPECT_EQ(source.GetListUpdateCallback(), original);
+    source.Add(2);
+    EXPECT_EQ(source_calls, 2);
+}
+
+TEST(FilteredViewFuzzTest, RandomEditsKeepObserversConsistent)
+{
+    std::mt19937 rng(7);
+    RealDataSet<int> source;
+    std::vector<int> initial;
+    int next_value = 0;
+    for (int i = 0; i < 50; ++i) initial.push_back(next_value++);
+    source.SetData(initial);
+
+    FilteredView<int> view(&source, [](const int& v) { return v % 3 != 0; });
+    std::vector<int> mirror = Contents(view);
+    view.SetListUpdateCallback(std::make_unique<MirrorCallback>(mirror));
+
+    for (int round = 0; round < 300; ++round)
+    {
+        const int count = source.GetDataCount();
+        switch (rng() % 5)
+        {
+        case 0:
+            source.Add(count == 0 ? 0 : static_cast<int>(rng() % (count + 1)), next_value++);
+            break;
+        case 1:
+            if (count > 0) source.RemoveAtPos(static_cast<int>(rng() % count));
+            break;
+        case 2:
+            if (count > 0) source.ReplaceAtPosIfExist(static_cast<int>(rng() % count), next_value++);
+            break;
+        case 3:
+        {
+            // A batch mixing moves, removals and insertions
+            std::vector<int> items;
+            for (int i = 0; i < count; ++i) items.push_back(*source.GetDataByIndex(i));
+            std::shuffle(items.begin(), items.end(), rng);
+            if (!items.empty()) items.pop_back();
+            items.push_back(next_value++);
+            source.SetData(items);
+            break;
+        }
+        default:
+            view.SetPredicate([mod = 2 + static_cast<int>(rng() % 3)](const int& v) { return v % mod != 0; });
+            break;
+        }
+        ExpectMirrorMatches(mirror, view);
+    }
+}
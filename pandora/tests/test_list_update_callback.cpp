@@ -385,8 +385,90 @@ TEST(WrapperDataSetCallbackTest, ContentChangeInChild)
     // Modify content
     ds1Ptr->ReplaceAtPosIfExist(0, TestData(1, "v2"));
 
-    // Should detect content change and propagate to wrapper
-    EXPECT_TRUE(callbackPtr->HasEvent(MockListUpdateCallback::Event::CHANGED, 0, 1));
+    // As for a bare RealDataSet (ReplaceCallback), operator== compares the
+    // name too, so the wrapper sees REMOVE + INSERT. It used to see CHANGED
+    // only because its snapshot pointed at the replaced slot itself.
+    bool hasRemoved = callbackPtr->HasEvent(MockListUpdateCallback::Event::REMOVED, 0, 1);
+    bool hasInserted = callbackPtr->HasEvent(MockListUpdateCallback::Event::INSERTED, 0, 1);
+    EXPECT_TRUE(hasRemoved && hasInserted);
+}
+
+// The wrapper snapshot holds copies: a child mutation inside the transaction
+// moves or frees the items in place, which stale pointers would then read.
+TEST(WrapperDataSetCallbackTest, SnapshotSurvivesChildShiftInTransaction)
+{
+    WrapperDataSet<TestData> wrapper;
+    auto ds = std::make_unique<RealDataSet<TestData>>();
+    auto dsPtr = ds.get();
+    dsPtr->SetData({TestData(1, "a"), TestData(2, "b"), TestData(3, "c")});
+    wrapper.AddChild(std::move(ds));
+    auto callback = std::make_unique<MockListUpdateCallback>();
+    auto callbackPtr = callback.get();
+    wrapper.SetListUpdateCallback(std::move(callback));
+
+    wrapper.StartTransaction();
+    dsPtr->RemoveAtPos(0);
+    wrapper.EndTransaction();
+
+    ASSERT_EQ(callbackPtr->events.size(), 1u);
+    EXPECT_TRUE(callbackPtr->HasEvent(MockListUpdateCallback::Event::REMOVED, 0, 1));
+}
+
+TEST(WrapperDataSetCallbackTest, SnapshotSurvivesChildReallocationInTransaction)
+{
+    WrapperDataSet<TestData> wrapper;
+    auto ds = std::make_unique<RealDataSet<TestData>>();
+    auto dsPtr = ds.get();
+    dsPtr->SetData({TestData(1, "a"), TestData(2, "b")});
+    wrapper.AddChild(std::move(ds));
+    auto callback = std::make_unique<MockListUpdateCallback>();
+    auto callbackPtr = callback.get();
+    wrapper.SetListUpdateCallback(std::move(callback));
+
+    wrapper.StartTransaction();
+    dsPtr->Add(0, TestData(0, "z"));
+    for (int i = 3; i < 64; ++i) dsPtr->Add(TestData(i, "n"));
+    wrapper.EndTransaction();
+
+    int inserted = 0;
+    for (const auto& e : callbackPtr->events)
+    {
+        EXPECT_EQ(e.type, MockListUpdateCallback::Event::INSERTED);
+        inserted += e.count;
+    }
+    EXPECT_EQ(inserted, 62);
+}
+
+// A wrapper that reports no item at one position, as a lazily filled adapter may
+class SparseWrapperDataSet : public WrapperDataSet<TestData>
+{
+public:
+    int hole = -1;
+
+    TestData* GetDataByIndex(const int index) override
+    {
+        return index == hole ? nullptr : WrapperDataSet<TestData>::GetDataByIndex(index);
+    }
+};
+
+TEST(WrapperDataSetCallbackTest, SnapshotKeepsPositionOfMissingItem)
+{
+    SparseWrapperDataSet wrapper;
+    wrapper.hole = 1;
+    auto ds = std::make_unique<RealDataSet<TestData>>();
+    auto dsPtr = ds.get();
+    dsPtr->SetData({TestData(1, "a"), TestData(2, "b"), TestData(3, "c")});
+    wrapper.AddChild(std::move(ds));
+    auto callback = std::make_unique<MockListUpdateCallback>();
+    auto callbackPtr = callback.get();
+    wrapper.SetListUpdateCallback(std::move(callback));
+
+    wrapper.StartTransaction();
+    dsPtr->RemoveAtPos(2);
+    wrapper.EndTransaction();
+
+    ASSERT_EQ(callbackPtr->events.size(), 1u);
+    EXPECT_TRUE(callbackPtr->HasEvent(MockListUpdateCallback::Event::REMOVED, 2, 1));
 }
 
 TEST(WrapperDataSetCallbackTest, AddAllCallback)
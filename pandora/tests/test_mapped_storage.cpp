@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include "pandora/mapped_storage.h"
+#include "pandora/real_data_set.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct Record
+{
+    int id;
+    double value;
+
+    bool operator==(const Record& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, id);
+        HashCombine(seed, value);
+        return seed;
+    }
+};
+
+class CountingCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { inserted += count; }
+    void OnRemoved(int position, int count) override { removed += count; }
+    void OnMoved(int from_position, int to_position) override {}
+    void OnChanged(int position, int count, void* payload) override { changed += count; }
+
+    int inserted = 0;
+    int removed = 0;
+    int changed = 0;
+};
+
+using MappedDataSet = RealDataSet<Record, MappedStorage<Record>>;
+
+// What a reader would find after a crash: the committed count and the first record
+struct FileState
+{
+    uint64_t count = 0;
+    int first_id = -1;
+};
+
+FileState ReadFile(const std::string& path)
+{
+    // Header: magic, record size, then the 64-bit committed count
+    std::ifstream in(path, std::ios::binary);
+    uint32_t magic_and_size[2];
+    FileState state;
+    Record first{};
+    in.read(reinterpret_cast<char*>(magic_and_size), sizeof(magic_and_size));
+    in.read(reinterpret_cast<char*>(&state.count), sizeof(state.count));
+    in.read(reinterpret_cast<char*>(&first), sizeof(first));
+    state.first_id = first.id;
+    return state;
+}
+
+} // namespace
+
+class MappedStorageTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path_ = ::testing::TempDir() + "pandora_mapped_storage_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+        std::remove(path_.c_str());
+    }
+
+    void TearDown() override
+    {
+        std::remove(path_.c_str());
+    }
+
+    std::string path_;
+};
+
+TEST_F(MappedStorageTest, VectorOperations)
+{
+    auto storage = MappedStorage<Record>::Open(path_, 2);
+    EXPECT_TRUE(storage.IsOpen());
+    EXPECT_TRUE(storage.empty());
+
+    for (int i = 0; i < 5; ++i) storage.push_back(Record{i, i * 1.5});
+    EXPECT_EQ(5u, storage.size());
+    EXPECT_GE(storage.capacity(), 5u);
+
+    storage.insert(storage.begin() + 1, Record{10, 0});
+    storage.erase(storage.begin() + 3);
+    std::vector<int> ids;
+    for (const auto& record : storage) ids.push_back(record.id);
+    EXPECT_EQ((std::vector<int>{0, 10, 1, 3, 4}), ids);
+
+    const std::vector<Record> batch{{20, 0}, {21, 0}};
+    storage.insert(storage.end(), batch.begin(), batch.end());
+    EXPECT_EQ(7u, storage.size());
+    EXPECT_EQ(21, storage[6].id);
+
+    storage.assign(batch.begin(), batch.end());
+    EXPECT_EQ(2u, storage.size());
+    EXPECT_EQ(20, storage[0].id);
+}
+
+TEST_F(MappedStorageTest, RecordsPersistAcrossReopen)
+{
+    {
+        MappedDataSet data_set(MappedStorage<Record>::Open(path_));
+        std::vector<Record> records;
+        for (int i = 0; i < 3000; ++i) records.push_back(Record{i, i * 0.5});
+        data_set.AddAll(records);
+        data_set.GetStorage().Flush();
+    }
+
+    MappedDataSet reopened(MappedStorage<Record>::Open(path_));
+    ASSERT_EQ(3000, reopened.GetDataCount());
+    EXPECT_EQ(2999, reopened.GetDataByIndex(2999)->id);
+    EXPECT_DOUBLE_EQ(1499.5, reopened.GetDataByIndex(2999)->value);
+    EXPECT_EQ(1234, reopened.IndexOf(Record{1234, 0}));
+}
+
+TEST_F(MappedStorageTest, MutationsNotifyLikeVectorStorage)
+{
+    MappedDataSet data_set(MappedStorage<Record>::Open(path_));
+    auto callback = std::make_unique<CountingCallback>();
+    CountingCallback* counts = callback.get();
+    data_set.SetListUpdateCallback(std::move(callback));
+
+    data_set.SetData({{1, 1}, {2, 2}, {3, 3}});
+    EXPECT_EQ(3, counts->inserted);
+
+    data_set.ReplaceAtPosIfExist(1, Record{2, 20});
+    EXPECT_EQ(1, counts->changed);
+
+    data_set.Remove(Record{1, 0});
+    data_set.Add(0, Record{0, 0});
+    EXPECT_EQ(1, counts->removed);
+    EXPECT_EQ(4, counts->inserted);
+    EXPECT_EQ(0, data_set.GetDataByIndex(0)->id);
+
+    data_set.StartTransaction();
+    data_set.Add(Record{4, 4});
+    data_set.Add(Record{5, 5});
+    data_set.EndTransaction();
+    EXPECT_EQ(6, counts->inserted);
+    EXPECT_EQ(5, data_set.GetDataCount());
+
+    data_set.ClearAllData();
+    EXPECT_EQ(0, data_set.GetDataCount());
+    EXPECT_EQ(6, counts->removed);
+}
+
+TEST_F(MappedStorageTest, OnlyFlushCommitsTheCount)
+{
+    auto storage = MappedStorage<Record>::Open(path_, 2);
+    storage.push_back(Record{0, 0});
+    storage.Flush();
+    EXPECT_EQ(1u, ReadFile(path_).count);
+
+    // Growing the file does not publish the unflushed records
+    for (int i = 1; i < 10; ++i) storage.push_back(Record{i, 0});
+    EXPECT_GE(storage.capacity(), 10u);
+    EXPECT_EQ(1u, ReadFile(path_).count);
+
+    storage.Flush();
+    EXPECT_EQ(10u, ReadFile(path_).count);
+}
+
+TEST_F(MappedStorageTest, MidListEditsStayOutOfTheFileUntilFlush)
+{
+    auto storage = MappedStorage<Record>::Open(path_);
+    for (int i = 0; i < 3; ++i) storage.push_back(Record{i, 0});
+    storage.Flush();
+
+    storage.insert(storage.cbegin(), Record{10, 0});
+    FileState state = ReadFile(path_);
+    EXPECT_EQ(3u, state.count);
+    EXPECT_EQ(0, state.first_id);
+
+    storage.Flush();
+    state = ReadFile(path_);
+    EXPECT_EQ(4u, state.count);
+    EXPECT_EQ(10, state.first_id);
+}
+
+TEST_F(MappedStorageTest, ReopenWithoutFlushSeesOldContents)
+{
+    MappedDataSet data_set(MappedStorage<Record>::Open(path_, 2));
+    data_set.SetData({{1, 1}, {2, 2}, {3, 3}});
+    data_set.GetStorage().Flush();
+
+    data_set.RemoveAtPos(0);
+    data_set.ReplaceAtPosIfExist(0, Record{2, 20});
+    for (int i = 4; i < 10; ++i) data_set.Add(Record{i, 0});  // Grows the file
+    {
+        // Another reader finds the file as of the last Flush()
+        MappedDataSet reopened(MappedStorage<Record>::Open(path_));
+        ASSERT_EQ(3, reopened.GetDataCount());
+        EXPECT_EQ(1, reopened.GetDataByIndex(0)->id);
+        EXPECT_DOUBLE_EQ(2, reopened.GetDataByIndex(1)->value);
+        EXPECT_EQ(3, reopened.GetDataByIndex(2)->id);
+    }
+
+    // Growing kept the unflushed records
+    ASSERT_EQ(8, data_set.GetDataCount());
+    EXPECT_EQ(2, data_set.GetDataByIndex(0)->id);
+    EXPECT_DOUBLE_EQ(20, data_set.GetDataByIndex(0)->value);
+    EXPECT_EQ(9, data_set.GetDataByIndex(7)->id);
+
+    data_set.GetStorage().Flush();
+    MappedDataSet reopened(MappedStorage<Record>::Open(path_));
+    ASSERT_EQ(8, reopened.GetDataCount());
+    EXPECT_DOUBLE_EQ(20, reopened.GetDataByIndex(0)->value);
+    EXPECT_EQ(9, reopened.GetDataByIndex(7)->id);
+}
+
+TEST_F(MappedStorageTest, RejectsFileOfAnotherRecordType)
+{
+    {
+        auto storage = MappedStorage<Record>::Open(path_);
+        storage.push_back(Record{1, 1});
+    }
+    EXPECT_THROW(MappedStorage<int>::Open(path_), PandoraException);
+    EXPECT_EQ(1u, MappedStorage<Record>::Open(path_).size());
+}
+
+TEST_F(MappedStorageTest, UnopenedStorageThrowsOnGrowth)
+{
+    MappedStorage<Record> storage;
+    EXPECT_FALSE(storage.IsOpen());
+    EXPECT_THROW(storage.push_back(Record{1, 1}), PandoraException);
+    EXPECT_NO_THROW(storage.Flush());
+}
@@ -0,0 +1,142 @@
+// Metrics are compiled in for this file only; its element types are local so
+// the data set instantiations do not collide with other test files.
+#define PANDORA_ENABLE_METRICS 1
+
+#include <gtest/gtest.h>
+#include "pandora/metrics.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct MetricsItem
+{
+    int id;
+    int version;
+
+    bool operator==(const MetricsItem& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, id);
+        HashCombine(seed, version);
+        return seed;
+    }
+};
+
+class NullCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { ++updates; }
+    void OnRemoved(int position, int count) override { ++updates; }
+    void OnMoved(int from_position, int to_position) override { ++updates; }
+    void OnChanged(int position, int count, void* payload) override { ++updates; }
+
+    int updates = 0;
+};
+
+} // namespace
+
+TEST(LatencyHistogramTest, BucketsAreLogLinear)
+{
+    for (uint64_t value : std::vector<uint64_t>{0, 1, 7, 8, 9, 15, 16, 1000, 123456789, UINT64_MAX})
+    {
+        const int bucket = LatencyHistogram::BucketOf(value);
+        ASSERT_LT(bucket, LatencyHistogram::kBucketCount);
+        const uint64_t upper = LatencyHistogram::BucketUpperBound(bucket);
+        EXPECT_GE(upper, value);
+        // Within 12.5% of the value
+        EXPECT_LE(upper - value, value / 8) << value;
+    }
+}
+
+TEST(LatencyHistogramTest, Percentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.GetPercentile(50));
+
+    for (uint64_t i = 1; i <= 1000; ++i) histogram.Record(i * 1000);
+    EXPECT_EQ(1000u, histogram.GetCount());
+    EXPECT_EQ(1000u, histogram.GetMin());
+    EXPECT_EQ(1000000u, histogram.GetMax());
+    EXPECT_DOUBLE_EQ(500500.0, histogram.GetMean());
+
+    const uint64_t median = histogram.GetPercentile(50);
+    EXPECT_GE(median, 500000u);
+    EXPECT_LE(median, 500000u + 500000u / 8);
+    EXPECT_EQ(1000000u, histogram.GetPercentile(100));
+
+    histogram.Reset();
+    EXPECT_EQ(0u, histogram.GetCount());
+    EXPECT_EQ(0u, histogram.GetMin());
+}
+
+TEST(AdapterMetricsTest, RealDataSetRecordsEveryPhase)
+{
+    RealDataSet<MetricsItem> data_set;
+    auto callback = std::make_unique<NullCallback>();
+    NullCallback* updates = callback.get();
+    data_set.SetListUpdateCallback(std::move(callback));
+    EXPECT_EQ(nullptr, data_set.GetMetrics());
+
+    data_set.SetData({{1, 0}, {2, 0}, {3, 0}});
+    data_set.RemoveAtPos(0);
+    data_set.ReplaceAtPosIfExist(0, MetricsItem{2, 1});
+
+    const AdapterMetrics* metrics = data_set.GetMetrics();
+    ASSERT_NE(nullptr, metrics);
+    EXPECT_EQ(3u, metrics->snapshots.load());
+    // Snapshots of 0, 3 and 2 items
+    EXPECT_EQ(5 * (sizeof(MetricsItem) + sizeof(size_t)), metrics->snapshot_bytes.load());
+    EXPECT_EQ(3u, metrics->diffs.load());
+    // D-values: 3 inserts, 1 removal, 0 for a change
+    EXPECT_EQ(4u, metrics->diff_d_total.load());
+    EXPECT_EQ(3u, metrics->diff_d_max.load());
+    EXPECT_GT(metrics->items_the_same_calls.load(), 0u);
+    EXPECT_GT(metrics->contents_the_same_calls.load(), 0u);
+    EXPECT_EQ(5u + metrics->contents_the_same_calls.load(), metrics->hash_calls.load());
+    EXPECT_EQ(static_cast<uint64_t>(updates->updates), metrics->updates_dispatched.load());
+    EXPECT_EQ(3u, metrics->snapshot_latency.GetCount());
+    EXPECT_EQ(3u, metrics->diff_latency.GetCount());
+    EXPECT_EQ(3u, metrics->dispatch_latency.GetCount());
+
+    data_set.ResetMetrics();
+    EXPECT_EQ(0u, metrics->snapshots.load());
+    EXPECT_EQ(0u, metrics->diff_latency.GetCount());
+}
+
+TEST(AdapterMetricsTest, RegistryListsLiveAdaptersByAlias)
+{
+    auto count_alias = [](const std::string& alias)
+    {
+        int found = 0;
+        ForEachAdapterMetrics([&](const AdapterMetrics& metrics)
+        {
+            if (metrics.GetAlias() == alias) ++found;
+        });
+        return found;
+    };
+
+    {
+        WrapperDataSet<MetricsItem> wrapper;
+        wrapper.SetAlias("metrics_feed");
+        wrapper.SetListUpdateCallback(std::make_unique<NullCallback>());
+        auto child = std::make_unique<RealDataSet<MetricsItem>>();
+        RealDataSet<MetricsItem>* child_ptr = child.get();
+        wrapper.AddChild(std::move(child));
+        child_ptr->Add(MetricsItem{1, 0});
+
+        ASSERT_NE(nullptr, wrapper.GetMetrics());
+        EXPECT_EQ(1u, wrapper.GetMetrics()->updates_dispatched.load());
+        EXPECT_EQ(1, count_alias("metrics_feed"));
+
+        wrapper.SetAlias("metrics_feed_renamed");
+        EXPECT_EQ(1, count_alias("metrics_feed_renamed"));
+    }
+    EXPECT_EQ(0, count_alias("metrics_feed_renamed"));
+}
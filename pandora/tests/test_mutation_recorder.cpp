@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "pandora/binary_io.h"
+#include "pandora/mutation_recorder.h"
+#include "pandora/mutation_replay.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+// The version is the content hash, so a replayed item equals the recorded one
+struct ReplayItem
+{
+    int id;
+    int version;
+
+    bool operator==(const ReplayItem& other) const { return id == other.id; }
+    size_t Hash() const { return static_cast<size_t>(version); }
+};
+
+ReplayItem MakeItem(uint64_t id, uint64_t content_hash)
+{
+    return ReplayItem{static_cast<int>(id), static_cast<int>(content_hash)};
+}
+
+uint64_t IdOf(const ReplayItem& item) { return static_cast<uint64_t>(item.id); }
+
+class LogCallback : public ListUpdateCallback
+{
+public:
+    explicit LogCallback(std::vector<std::string>& log) : log_(log) {}
+
+    void OnInserted(int position, int count) override
+    {
+        log_.push_back("I" + std::to_string(position) + "," + std::to_string(count));
+    }
+    void OnRemoved(int position, int count) override
+    {
+        log_.push_back("R" + std::to_string(position) + "," + std::to_string(count));
+    }
+    void OnMoved(int from_position, int to_position) override
+    {
+        log_.push_back("M" + std::to_string(from_position) + "," + std::to_string(to_position));
+    }
+    void OnChanged(int position, int count, void* payload) override
+    {
+        log_.push_back("C" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+private:
+    std::vector<std::string>& log_;
+};
+
+std::vector<std::pair<int, int>> Contents(PandoraBoxAdapter<ReplayItem>& adapter)
+{
+    std::vector<std::pair<int, int>> contents;
+    for (int i = 0; i < adapter.GetDataCount(); ++i)
+    {
+        const ReplayItem* item = adapter.GetDataByIndex(i);
+        contents.emplace_back(item->id, item->version);
+    }
+    return contents;
+}
+
+} // namespace
+
+TEST(BinaryIoTest, RoundTrip)
+{
+    std::vector<uint8_t> bytes;
+    BinaryWriter writer(bytes);
+    writer.WriteVarint(0);
+    writer.WriteVarint(127);
+    writer.WriteVarint(128);
+    writer.WriteVarint(UINT64_MAX);
+    writer.WriteSignedVarint(-1);
+    writer.WriteSignedVarint(INT64_MIN);
+    writer.WriteFixed32(0xdeadbeef);
+    writer.WriteFixed64(0x0123456789abcdefULL);
+    writer.WriteString("pandora");
+    EXPECT_EQ(45u, bytes.size());
+
+    BinaryReader reader(bytes);
+    EXPECT_EQ(0u, reader.ReadVarint());
+    EXPECT_EQ(127u, reader.ReadVarint());
+    EXPECT_EQ(128u, reader.ReadVarint());
+    EXPECT_EQ(UINT64_MAX, reader.ReadVarint());
+    EXPECT_EQ(-1, reader.ReadSignedVarint());
+    EXPECT_EQ(INT64_MIN, reader.ReadSignedVarint());
+    EXPECT_EQ(0xdeadbeefu, reader.ReadFixed32());
+    EXPECT_EQ(0x0123456789abcdefULL, reader.ReadFixed64());
+    EXPECT_EQ("pandora", reader.ReadString());
+    EXPECT_TRUE(reader.AtEnd());
+    EXPECT_THROW(reader.ReadU8(), PandoraException);
+}
+
+TEST(MutationRecorderTest, ReplayReproducesStateAndNotifications)
+{
+    WrapperDataSet<ReplayItem> root;
+    root.SetAlias("root");
+    auto first = std::make_unique<RealDataSet<ReplayItem>>();
+    auto second = std::make_unique<RealDataSet<ReplayItem>>();
+    RealDataSet<ReplayItem>* first_ptr = first.get();
+    RealDataSet<ReplayItem>* second_ptr = second.get();
+    first->SetAlias("first");
+    first->SetData({{1, 0}, {2, 0}});
+    root.AddChild(std::move(first));
+    root.AddChild(std::move(second));
+
+    std::vector<std::string> recorded_log;
+    root.SetListUpdateCallback(std::make_unique<LogCallback>(recorded_log));
+
+    MutationRecorder<ReplayItem> recorder(&root, IdOf);
+    first_ptr->Add(ReplayItem{3, 0});
+    second_ptr->AddAll({{10, 0}, {11, 0}, {12, 0}});
+    root.Add(1, ReplayItem{4, 0});
+    root.ReplaceAtPosIfExist(0, ReplayItem{1, 7});
+    root.RemoveAtPos(5);
+    first_ptr->Remove(ReplayItem{2, 0});
+    root.StartTransaction();
+    second_ptr->SetData({{12, 1}, {13, 0}, {10, 0}});
+    first_ptr->ClearAllData();
+    root.EndTransaction();
+    recorder.Stop();
+    const auto expected_contents = Contents(root);
+    const auto expected_log = recorded_log;
+
+    first_ptr->Add(ReplayItem{99, 0});
+    EXPECT_EQ(nullptr, first_ptr->FindMutationRecorder());
+    // Wrapper mutations record their transaction around the leaf operation
+    EXPECT_EQ(16u, recorder.GetMutationCount());
+
+    MutationReplayer<ReplayItem> replayer(recorder.GetTrace(), MakeItem);
+    auto replayed = replayer.BuildTree();
+    EXPECT_EQ(2, replayed->GetChildCount());
+    EXPECT_EQ("root", replayed->GetAlias());
+    EXPECT_EQ("first", replayed->GetChild(0)->GetAlias());
+    EXPECT_EQ((std::vector<std::pair<int, int>>{{1, 0}, {2, 0}}), Contents(*replayed));
+
+    std::vector<std::string> replayed_log;
+    replayed->SetListUpdateCallback(std::make_unique<LogCallback>(replayed_log));
+    LatencyHistogram latency;
+    const ReplayStats stats = replayer.Replay(*replayed, &latency);
+
+    EXPECT_EQ(16u, stats.mutations);
+    EXPECT_EQ(16u, latency.GetCount());
+    EXPECT_GT(stats.GetMutationsPerSecond(), 0.0);
+    EXPECT_EQ(expected_contents, Contents(*replayed));
+    EXPECT_EQ(expected_log, replayed_log);
+}
+
+TEST(MutationRecorderTest, ReplaysOntoAnyLeafFactory)
+{
+    RealDataSet<ReplayItem> root;
+    MutationRecorder<ReplayItem> recorder(&root, IdOf);
+    root.Add(ReplayItem{1, 0});
+    root.Add(0, ReplayItem{2, 0});
+    recorder.Stop();
+
+    MutationReplayer<ReplayItem> replayer(recorder.GetTrace(), MakeItem);
+    int leaves = 0;
+    auto replayed = replayer.BuildTree([&leaves]
+    {
+        ++leaves;
+        return std::unique_ptr<PandoraBoxAdapter<ReplayItem>>(new RealDataSet<ReplayItem>());
+    });
+    replayer.Replay(*replayed);
+    EXPECT_EQ(1, leaves);
+    EXPECT_EQ(Contents(root), Contents(*replayed));
+}
+
+TEST(MutationRecorderTest, RejectsMalformedTraces)
+{
+    EXPECT_THROW(MutationReplayer<ReplayItem>({1, 2, 3, 4, 5}, MakeItem), PandoraException);
+
+    RealDataSet<ReplayItem> root;
+    MutationRecorder<ReplayItem> recorder(&root, IdOf);
+    root.Add(ReplayItem{1, 0});
+    recorder.Stop();
+
+    std::vector<uint8_t> truncated = recorder.GetTrace();
+    truncated.pop_back();
+    MutationReplayer<ReplayItem> replayer(truncated, MakeItem);
+    auto replayed = replayer.BuildTree();
+    EXPECT_THROW(replayer.Replay(*replayed), PandoraException);
+}
@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+#include "pandora/paged_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+// Records requests; the test delivers pages explicitly, as an async source would
+class FakePageSource : public PageSource<int>
+{
+public:
+    void LoadPage(int page_index, int start, int count) override
+    {
+        requests.push_back(page_index);
+        starts.push_back(start);
+        counts.push_back(count);
+    }
+
+    static std::vector<int> Page(int start, int count)
+    {
+        std::vector<int> items;
+        for (int i = 0; i < count; ++i) items.push_back(start + i);
+        return items;
+    }
+
+    std::vector<int> requests;
+    std::vector<int> starts;
+    std::vector<int> counts;
+};
+
+class LogCallback : public ListUpdateCallback
+{
+public:
+    explicit LogCallback(std::vector<std::string>& log) : log_(log) {}
+
+    void OnInserted(int position, int count) override
+    {
+        log_.push_back("I" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+    void OnRemoved(int position, int count) override
+    {
+        log_.push_back("R" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+    void OnMoved(int from_position, int to_position) override
+    {
+        log_.push_back("M" + std::to_string(from_position) + "," + std::to_string(to_position));
+    }
+
+    void OnChanged(int position, int count, void* payload) override
+    {
+        log_.push_back("C" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+private:
+    std::vector<std::string>& log_;
+};
+
+PagedDataSet<int>::Config MakeConfig(int page_size, int prefetch, size_t budget)
+{
+    PagedDataSet<int>::Config config;
+    config.page_size = page_size;
+    config.prefetch_distance = prefetch;
+    config.memory_budget = budget;
+    return config;
+}
+
+} // namespace
+
+class PagedDataSetTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_set_ = std::make_unique<PagedDataSet<int>>(&source_, MakeConfig(10, 15, 1024), -1);
+        data_set_->SetListUpdateCallback(std::make_unique<LogCallback>(log_));
+    }
+
+    FakePageSource source_;
+    std::vector<std::string> log_;
+    std::unique_ptr<PagedDataSet<int>> data_set_;
+};
+
+TEST_F(PagedDataSetTest, ReturnsPlaceholderAndRequestsNearbyPages)
+{
+    data_set_->SetTotalCount(100);
+    EXPECT_EQ(100, data_set_->GetDataCount());
+    EXPECT_EQ(std::vector<std::string>{"I0,100"}, log_);
+
+    int* item = data_set_->GetDataByIndex(42);
+    ASSERT_NE(nullptr, item);
+    EXPECT_EQ(-1, *item);
+    EXPECT_TRUE(data_set_->IsPlaceholder(item));
+    EXPECT_FALSE(data_set_->IsLoaded(42));
+
+    // Index 42 +/- 15 covers pages 2..5, nearest first
+    EXPECT_EQ((std::vector<int>{4, 5, 3, 2}), source_.requests);
+
+    // Pending pages are not requested twice
+    data_set_->GetDataByIndex(43);
+    EXPECT_EQ(4u, source_.requests.size());
+
+    EXPECT_EQ(nullptr, data_set_->GetDataByIndex(100));
+}
+
+TEST_F(PagedDataSetTest, PageArrivalEmitsChanged)
+{
+    data_set_->SetTotalCount(25);
+    data_set_->GetDataByIndex(21);
+    ASSERT_EQ((std::vector<int>{2, 1, 0}), source_.requests);
+    // The last page is short
+    EXPECT_EQ(5, source_.counts[0]);
+    EXPECT_EQ(20, source_.starts[0]);
+
+    log_.clear();
+    data_set_->OnPageLoaded(2, FakePageSource::Page(20, 5));
+    EXPECT_EQ(std::vector<std::string>{"C20,5"}, log_);
+    EXPECT_TRUE(data_set_->IsLoaded(21));
+    EXPECT_EQ(21, *data_set_->GetDataByIndex(21));
+    EXPECT_EQ(1, data_set_->GetLoadedPageCount());
+    EXPECT_EQ(5 * sizeof(int), data_set_->GetLoadedBytes());
+}
+
+TEST_F(PagedDataSetTest, FailedPageIsRequestedAgain)
+{
+    data_set_->SetTotalCount(10);
+    data_set_->GetDataByIndex(0);
+    ASSERT_EQ(std::vector<int>{0}, source_.requests);
+
+    data_set_->OnPageLoadFailed(0);
+    data_set_->GetDataByIndex(0);
+    EXPECT_EQ((std::vector<int>{0, 0}), source_.requests);
+}
+
+TEST_F(PagedDataSetTest, EvictsLeastRecentlyUsedPagesOverBudget)
+{
+    // Budget holds two pages of ten ints
+    data_set_ = std::make_unique<PagedDataSet<int>>(&source_, MakeConfig(10, 0, 20 * sizeof(int)), -1);
+    data_set_->SetListUpdateCallback(std::make_unique<LogCallback>(log_));
+    data_set_->SetTotalCount(50);
+
+    data_set_->OnPageLoaded(0, FakePageSource::Page(0, 10));
+    data_set_->OnPageLoaded(1, FakePageSource::Page(10, 10));
+    // Touch page 0 so page 1 becomes the coldest
+    EXPECT_EQ(5, *data_set_->GetDataByIndex(5));
+
+    log_.clear();
+    data_set_->OnPageLoaded(2, FakePageSource::Page(20, 10));
+    EXPECT_EQ((std::vector<std::string>{"C20,10", "C10,10"}), log_);
+    EXPECT_TRUE(data_set_->IsLoaded(5));
+    EXPECT_FALSE(data_set_->IsLoaded(15));
+    EXPECT_TRUE(data_set_->IsLoaded(25));
+    EXPECT_EQ(20 * sizeof(int), data_set_->GetLoadedBytes());
+
+    // The evicted page reads as placeholder and is requested again
+    source_.requests.clear();
+    EXPECT_EQ(-1, *data_set_->GetDataByIndex(15));
+    EXPECT_EQ(std::vector<int>{1}, source_.requests);
+}
+
+TEST_F(PagedDataSetTest, OversizedPageIsKept)
+{
+    data_set_ = std::make_unique<PagedDataSet<int>>(&source_, MakeConfig(10, 0, sizeof(int)), -1);
+    data_set_->SetTotalCount(20);
+    data_set_->OnPageLoaded(0, FakePageSource::Page(0, 10));
+    EXPECT_TRUE(data_set_->IsLoaded(0));
+    data_set_->OnPageLoaded(1, FakePageSource::Page(10, 10));
+    EXPECT_FALSE(data_set_->IsLoaded(0));
+    EXPECT_TRUE(data_set_->IsLoaded(10));
+}
+
+TEST_F(PagedDataSetTest, ShrinkingDropsPagesAndPendingRequests)
+{
+    data_set_->SetTotalCount(30);
+    data_set_->OnPageLoaded(0, FakePageSource::Page(0, 10));
+    data_set_->OnPageLoaded(2, FakePageSource::Page(20, 10));
+
+    log_.clear();
+    data_set_->SetTotalCount(15);
+    EXPECT_EQ(std::vector<std::string>{"R15,15"}, log_);
+    EXPECT_EQ(1, data_set_->GetLoadedPageCount());
+
+    // A late page beyond the end is dropped
+    data_set_->OnPageLoaded(2, FakePageSource::Page(20, 10));
+    EXPECT_EQ(1, data_set_->GetLoadedPageCount());
+
+    // Page 1 now holds 5 items; a mismatched page is padded with the placeholder
+    data_set_->OnPageLoaded(1, FakePageSource::Page(10, 3));
+    EXPECT_EQ(12, *data_set_->GetDataByIndex(12));
+    EXPECT_EQ(-1, *data_set_->GetDataByIndex(14));
+}
+
+TEST_F(PagedDataSetTest, InvalidateDropsEveryPage)
+{
+    data_set_->SetTotalCount(20);
+    data_set_->OnPageLoaded(0, FakePageSource::Page(0, 10));
+    data_set_->OnPageLoaded(1, FakePageSource::Page(10, 10));
+
+    log_.clear();
+    data_set_->Invalidate();
+    EXPECT_EQ(std::vector<std::string>{"C0,20"}, log_);
+    EXPECT_EQ(0, data_set_->GetLoadedPageCount());
+    EXPECT_EQ(0u, data_set_->GetLoadedBytes());
+}
+
+TEST_F(PagedDataSetTest, LocalEditsAndUnsupportedMutations)
+{
+    data_set_->SetTotalCount(20);
+    data_set_->OnPageLoaded(0, FakePageSource::Page(0, 10));
+
+    log_.clear();
+    EXPECT_TRUE(data_set_->ReplaceAtPosIfExist(3, 300));
+    EXPECT_EQ(std::vector<std::string>{"C3,1"}, log_);
+    EXPECT_EQ(300, *data_set_->GetDataByIndex(3));
+    EXPECT_EQ(3, data_set_->IndexOf(300));
+    EXPECT_EQ(-1, data_set_->IndexOf(15));
+    EXPECT_FALSE(data_set_->ReplaceAtPosIfExist(15, 1));
+
+    log_.clear();
+    data_set_->Add(1);
+    data_set_->RemoveAtPos(0);
+    data_set_->SetData({1, 2, 3});
+    EXPECT_TRUE(log_.empty());
+    EXPECT_EQ(20, data_set_->GetDataCount());
+
+    data_set_->ClearAllData();
+    EXPECT_EQ(std::vector<std::string>{"R0,20"}, log_);
+    EXPECT_EQ(0, data_set_->GetLoadedPageCount());
+}
+
+TEST_F(PagedDataSetTest, TransactionDefersNotifications)
+{
+    data_set_->SetTotalCount(20);
+    log_.clear();
+    data_set_->StartTransaction();
+    data_set_->OnPageLoaded(0, FakePageSource::Page(0, 10));
+    data_set_->SetTotalCount(25);
+    EXPECT_TRUE(log_.empty());
+    data_set_->EndTransaction();
+    EXPECT_TRUE(data_set_->IsLoaded(0));
+    EXPECT_EQ((std::vector<std::string>{"I20,5", "C0,10"}), log_);
+}
+
+TEST_F(PagedDataSetTest, SilentTransactionEndDropsDeferredNotifications)
+{
+    data_set_->SetTotalCount(20);
+    log_.clear();
+    data_set_->StartTransaction();
+    data_set_->OnPageLoaded(1, FakePageSource::Page(10, 10));
+    data_set_->EndTransactionSilently();
+    EXPECT_TRUE(log_.empty());
+
+    data_set_->StartTransaction();
+    data_set_->EndTransaction();
+    EXPECT_TRUE(log_.empty());
+}
+
+TEST(PagedDataSetWrapperTest, ParentDiffDoesNotRequestPages)
+{
+    FakePageSource source;
+    std::vector<std::string> log;
+    WrapperDataSet<int> wrapper;
+    wrapper.SetListUpdateCallback(std::make_unique<LogCallback>(log));
+
+    auto paged = std::make_unique<PagedDataSet<int>>(&source, MakeConfig(10, 0, 1024), -1);
+    PagedDataSet<int>* paged_ptr = paged.get();
+    wrapper.AddChild(std::move(paged));
+
+    log.clear();
+    paged_ptr->SetTotalCount(20);
+    EXPECT_EQ(20, wrapper.GetDataCount());
+    EXPECT_TRUE(source.requests.empty());
+
+    paged_ptr->OnPageLoaded(1, FakePageSource::Page(10, 10));
+    EXPECT_TRUE(source.requests.empty());
+    EXPECT_EQ(15, *wrapper.GetDataByIndex(15));
+    EXPECT_FALSE(log.empty());
+}
@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include "allocation_tracker.h"
+#include "pandora/batching_list_update_callback.h"
+#include "pandora/diff_util.h"
+#include "pandora/field_hashers.h"
+#include "pandora/payload.h"
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct LargePayload
+{
+    std::string text;
+    int counter = 0;
+
+    void Merge(const LargePayload& other) { counter += other.counter; }
+};
+
+struct Update
+{
+    char type;
+    int position;
+    int count;
+    uint64_t mask;
+};
+
+class RecordingCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { updates.push_back({'I', position, count, 0}); }
+    void OnRemoved(int position, int count) override { updates.push_back({'R', position, count, 0}); }
+    void OnMoved(int from_position, int to_position) override { updates.push_back({'M', from_position, to_position, 0}); }
+    void OnChanged(int position, int count, void* payload) override
+    {
+        updates.push_back({'c', position, count, 0});
+        raw_payloads.push_back(payload);
+    }
+    void OnChangedWithPayload(int position, int count, const Payload& payload) override
+    {
+        const auto* mask = payload.Get<FieldChangeMask>();
+        updates.push_back({'C', position, count, mask ? mask->bits : 0});
+    }
+
+    std::vector<Update> updates;
+    std::vector<void*> raw_payloads;
+};
+
+// Reports only the void* overload, as callbacks written before Payload do
+class LegacyCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override {}
+    void OnRemoved(int position, int count) override {}
+    void OnMoved(int from_position, int to_position) override {}
+    void OnChanged(int position, int count, void* payload) override
+    {
+        const auto* mask = static_cast<const FieldChangeMask*>(payload);
+        masks.push_back(mask ? mask->bits : 0);
+    }
+
+    std::vector<uint64_t> masks;
+};
+
+class VersionDiffCallback : public DiffCallback
+{
+public:
+    VersionDiffCallback(std::vector<std::pair<int, int>> old_list, std::vector<std::pair<int, int>> new_list)
+        : old_list_(std::move(old_list)), new_list_(std::move(new_list)) {}
+
+    int GetOldListSize() const override { return static_cast<int>(old_list_.size()); }
+    int GetNewListSize() const override { return static_cast<int>(new_list_.size()); }
+    bool AreItemsTheSame(int old_pos, int new_pos) const override { return old_list_[old_pos].first == new_list_[new_pos].first; }
+    bool AreContentsTheSame(int old_pos, int new_pos) const override { return old_list_[old_pos] == new_list_[new_pos]; }
+    Payload GetTypedChangePayload(int old_pos, int new_pos) const override
+    {
+        return Payload(FieldChangeMask{static_cast<uint64_t>(new_list_[new_pos].second)});
+    }
+
+private:
+    std::vector<std::pair<int, int>> old_list_;
+    std::vector<std::pair<int, int>> new_list_;
+};
+
+} // namespace
+
+TEST(PayloadTest, SmallTrivialPayloadsAreInline)
+{
+    static_assert(sizeof(FieldChangeMask) <= Payload::kInlineSize);
+    Payload payload;
+    EXPECT_TRUE(payload.Empty());
+    EXPECT_EQ(nullptr, payload.Data());
+
+    EXPECT_NO_ALLOCATIONS(payload = Payload(FieldChangeMask{5}));
+    Payload copy;
+    EXPECT_NO_ALLOCATIONS(copy = payload);
+    ASSERT_NE(nullptr, copy.Get<FieldChangeMask>());
+    EXPECT_EQ(5u, copy.Get<FieldChangeMask>()->bits);
+    EXPECT_EQ(nullptr, copy.Get<int>());
+    EXPECT_EQ(copy.Get<FieldChangeMask>(), copy.Data());
+}
+
+TEST(PayloadTest, LargePayloadsReusePooledBlocks)
+{
+    {
+        Payload warm_up(LargePayload{"warm up", 1});
+    }
+    pandora_test::AllocationTracker tracker;
+    {
+        Payload payload(LargePayload{"", 1});
+        Payload copy = payload;
+        ASSERT_NE(nullptr, copy.Get<LargePayload>());
+        EXPECT_NE(payload.Data(), copy.Data());
+        Payload moved = std::move(copy);
+        EXPECT_TRUE(copy.Empty());
+        EXPECT_EQ(1, moved.Get<LargePayload>()->counter);
+    }
+    // The first block came from the warm-up; the copy took one more, now pooled too
+    EXPECT_LE(tracker.GetCount(), 1u);
+    pandora_test::AllocationTracker pooled;
+    {
+        Payload payload(LargePayload{"", 2});
+        Payload copy = payload;
+    }
+    EXPECT_EQ(0u, pooled.GetCount());
+}
+
+TEST(PayloadTest, MergesSameTypesOnly)
+{
+    Payload mask(FieldChangeMask{1});
+    EXPECT_TRUE(mask.Merge(Payload(FieldChangeMask{4})));
+    EXPECT_EQ(5u, mask.Get<FieldChangeMask>()->bits);
+
+    EXPECT_FALSE(mask.Merge(Payload(LargePayload{"", 1})));
+    EXPECT_FALSE(mask.Merge(Payload()));
+    EXPECT_FALSE(mask.Merge(Payload(7)));  // No Merge member
+    EXPECT_EQ(5u, mask.Get<FieldChangeMask>()->bits);
+
+    Payload large(LargePayload{"", 1});
+    EXPECT_TRUE(large.Merge(Payload(LargePayload{"", 2})));
+    EXPECT_EQ(3, large.Get<LargePayload>()->counter);
+
+    Payload empty;
+    EXPECT_TRUE(empty.Merge(Payload()));
+
+    int value = 0;
+    int other = 0;
+    Payload borrowed = Payload::Borrow(&value);
+    EXPECT_EQ(&value, borrowed.Data());
+    EXPECT_EQ(nullptr, borrowed.Get<int>());
+    EXPECT_TRUE(borrowed.Merge(Payload::Borrow(&value)));
+    EXPECT_FALSE(borrowed.Merge(Payload::Borrow(&other)));
+    EXPECT_TRUE(Payload::Borrow(nullptr).Empty());
+}
+
+TEST(PayloadTest, DiffUtilDispatchesTypedPayloads)
+{
+    VersionDiffCallback diff({{1, 0}, {2, 0}, {3, 0}}, {{1, 0}, {2, 2}, {3, 0}});
+    auto result = DiffUtil::CalculateDiff(&diff);
+
+    RecordingCallback typed;
+    result->DispatchUpdatesTo(&typed);
+    ASSERT_EQ(1u, typed.updates.size());
+    EXPECT_EQ('C', typed.updates[0].type);
+    EXPECT_EQ(1, typed.updates[0].position);
+    EXPECT_EQ(2u, typed.updates[0].mask);
+
+    // Callbacks that only know the void* overload receive the inline payload's address
+    LegacyCallback legacy;
+    legacy.masks.reserve(1);
+    EXPECT_NO_ALLOCATIONS(result->DispatchUpdatesTo(&legacy));
+    ASSERT_EQ(1u, legacy.masks.size());
+    EXPECT_EQ(2u, legacy.masks[0]);
+}
+
+TEST(BatchingListUpdateCallbackTest, JoinsAdjacentUpdates)
+{
+    RecordingCallback target;
+    BatchingListUpdateCallback batching(&target);
+
+    batching.OnInserted(3, 1);
+    batching.OnInserted(4, 2);
+    batching.OnInserted(3, 1);
+    batching.OnRemoved(10, 1);
+    batching.OnRemoved(9, 1);
+    batching.OnChangedWithPayload(0, 1, Payload(FieldChangeMask{1}));
+    batching.OnChangedWithPayload(1, 1, Payload(FieldChangeMask{2}));
+    batching.OnChangedWithPayload(2, 1, Payload(LargePayload{"", 1}));  // Does not merge with a mask
+    batching.OnUpdatesDispatched();
+
+    ASSERT_EQ(4u, target.updates.size());
+    EXPECT_EQ('I', target.updates[0].type);
+    EXPECT_EQ(3, target.updates[0].position);
+    EXPECT_EQ(4, target.updates[0].count);
+    EXPECT_EQ('R', target.updates[1].type);
+    EXPECT_EQ(9, target.updates[1].position);
+    EXPECT_EQ(2, target.updates[1].count);
+    EXPECT_EQ('C', target.updates[2].type);
+    EXPECT_EQ(0, target.updates[2].position);
+    EXPECT_EQ(2, target.updates[2].count);
+    EXPECT_EQ(3u, target.updates[2].mask);
+    EXPECT_EQ('C', target.updates[3].type);
+    EXPECT_EQ(2, target.updates[3].position);
+}
+
+TEST(BatchingListUpdateCallbackTest, RawPayloadsJoinOnlyWhenIdentical)
+{
+    RecordingCallback target;
+    BatchingListUpdateCallback batching(&target);
+    int first = 0;
+    int second = 0;
+
+    batching.OnChanged(0, 1, &first);
+    batching.OnChanged(1, 1, &first);
+    batching.OnChanged(2, 1, &second);
+    batching.OnChanged(5, 1, &second);  // Not adjacent
+    batching.DispatchLastEvent();
+
+    ASSERT_EQ(3u, target.updates.size());
+    EXPECT_EQ(2, target.updates[0].count);
+    EXPECT_EQ(2, target.updates[1].position);
+    EXPECT_EQ(5, target.updates[2].position);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "pandora/pandora_rv.h"
+#include <memory>
+
+using namespace pandora::rv;
+
+namespace {
+
+class Counter : public ReactiveData<Counter>
+{
+public:
+    int binds = 0;
+    int unbinds = 0;
+    std::weak_ptr<IReactiveViewHolder<Counter>> bound;
+
+    void SetToViewHolder(std::shared_ptr<IViewHolder<Data>>) override {}
+
+    void BindReactiveVh(std::shared_ptr<IReactiveViewHolder<Counter>> view_holder) override
+    {
+        ++binds;
+        bound = view_holder;
+    }
+
+    void UnbindReactiveVh() override
+    {
+        ++unbinds;
+        bound.reset();
+    }
+};
+
+class CounterViewHolder : public IReactiveViewHolder<Counter>
+{
+public:
+    int set_data_calls = 0;
+
+    void SetData(std::shared_ptr<Counter> data) override
+    {
+        ++set_data_calls;
+        data_ = std::move(data);
+    }
+
+    void OnViewAttachedToWindow() override {}
+    void OnViewDetachedFromWindow() override {}
+    void accept(IViewHolderVisitor&) override {}
+
+    std::shared_ptr<ReactiveData<Counter>> GetReactiveDataIfExist() override
+    {
+        return data_;
+    }
+
+    void OnPropertyChanged(std::shared_ptr<Counter>, int) override {}
+
+private:
+    std::shared_ptr<Counter> data_;
+};
+
+} // namespace
+
+TEST(ReactiveBindTest, StaticBindSwitchesBinding)
+{
+    auto first = std::make_shared<Counter>();
+    auto second = std::make_shared<Counter>();
+    auto vh = std::make_shared<CounterViewHolder>();
+
+    HelpSetToReactiveViewHolderStatic(first, vh);
+    EXPECT_EQ(first->binds, 1);
+    EXPECT_EQ(first->bound.lock(), vh);
+
+    HelpSetToReactiveViewHolderStatic(second, vh);
+    EXPECT_EQ(first->unbinds, 1);
+    EXPECT_TRUE(first->bound.expired());
+    EXPECT_EQ(second->binds, 1);
+    EXPECT_EQ(vh->GetReactiveDataIfExist(), second);
+}
+
+TEST(ReactiveBindTest, StaticRebindOfSameDataRebinds)
+{
+    auto data = std::make_shared<Counter>();
+    auto vh = std::make_shared<CounterViewHolder>();
+
+    HelpSetToReactiveViewHolderStatic(data, vh);
+    HelpSetToReactiveViewHolderStatic(data, vh);
+
+    EXPECT_EQ(vh->set_data_calls, 2);
+    EXPECT_EQ(data->binds, 2);
+    EXPECT_EQ(data->unbinds, 1);
+    EXPECT_EQ(data->bound.lock(), vh);
+}
+
+TEST(ReactiveBindTest, StaticBindMovesSharedDataBackToFirstHolder)
+{
+    auto data = std::make_shared<Counter>();
+    auto first = std::make_shared<CounterViewHolder>();
+    auto second = std::make_shared<CounterViewHolder>();
+
+    HelpSetToReactiveViewHolderStatic(data, first);
+    HelpSetToReactiveViewHolderStatic(data, second);
+    EXPECT_EQ(data->bound.lock(), second);
+
+    // first still shows data, but data now notifies second: it must be bound again
+    HelpSetToReactiveViewHolderStatic(data, first);
+    EXPECT_EQ(data->bound.lock(), first);
+    EXPECT_EQ(data->binds, 3);
+}
+
+TEST(ReactiveBindTest, StaticBindFromReactiveDataAndNull)
+{
+    auto data = std::make_shared<Counter>();
+    auto vh = std::make_shared<CounterViewHolder>();
+
+    std::shared_ptr<ReactiveData<Counter>> base = data;
+    HelpSetToReactiveViewHolderStatic(base, vh);
+    EXPECT_EQ(data->binds, 1);
+
+    // As HelpSetToReactiveViewHolder, null data is not set and the holder stays bound
+    HelpSetToReactiveViewHolderStatic(std::shared_ptr<Counter>(), vh);
+    EXPECT_EQ(vh->set_data_calls, 1);
+    EXPECT_EQ(vh->GetReactiveDataIfExist(), data);
+    EXPECT_EQ(data->bound.lock(), vh);
+
+    HelpSetToReactiveViewHolderStatic(data, std::shared_ptr<CounterViewHolder>());
+    EXPECT_EQ(data->binds, 2);
+}
@@ -2,9 +2,75 @@
 #include "pandora/real_data_set.h"
 #include "pandora/pandora_exception.h"
 #include "Global.h"
+#include <memory>
+#include <string>
+#include <vector>
 
 using namespace pandora;
 
+namespace {
+
+// operator== compares the id only, so contents are told apart by Hash()
+struct Post
+{
+    int id;
+    std::string text;
+
+    bool operator==(const Post& other) const { return id == other.id; }
+    size_t Hash() const { return std::hash<std::string>{}(text); }
+};
+
+struct PodRow
+{
+    int32_t id;
+    int32_t version;
+
+    bool operator==(const PodRow& other) const { return id == other.id && version == other.version; }
+};
+
+} // namespace
+
+template <>
+struct pandora::UseBytewiseEquals<PodRow> : std::true_type {};
+
+namespace {
+
+class CountingCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { ++events; }
+    void OnRemoved(int position, int count) override { ++events; }
+    void OnMoved(int from_position, int to_position) override { ++events; }
+    void OnChanged(int position, int count, void* payload) override
+    {
+        ++events;
+        changed += count;
+    }
+    void OnUpdatesDispatched() override { ++dispatches; }
+
+    int events = 0;
+    int changed = 0;
+    int dispatches = 0;
+};
+
+template <typename T>
+CountingCallback* AttachCounter(RealDataSet<T>& data_set)
+{
+    auto callback = std::make_unique<CountingCallback>();
+    CountingCallback* counter = callback.get();
+    data_set.SetListUpdateCallback(std::move(callback));
+    return counter;
+}
+
+std::vector<Post> MakePosts(int count)
+{
+    std::vector<Post> posts;
+    for (int i = 0; i < count; ++i) posts.push_back(Post{i, "post " + std::to_string(i)});
+    return posts;
+}
+
+} // namespace
+
 TEST(RealDataSetTest, BasicOperations) {
     RealDataSet<TestData> ds;
     EXPECT_EQ(ds.GetDataCount(), 0);
@@ -28,3 +94,89 @@ TEST(RealDataSetTest, ExceptionOnAddChild) {
     EXPECT_THROW(ds.AddChild(nullptr), PandoraException);
 }
 
+
+TEST(RealDataSetTest, SetDataWithSameItemsIsSilent) {
+    RealDataSet<Post> posts;
+    posts.SetData(MakePosts(100));
+    CountingCallback* counter = AttachCounter(posts);
+    posts.SetData(MakePosts(100));
+    EXPECT_EQ(0, counter->events);
+    EXPECT_EQ(0, counter->dispatches);
+
+    RealDataSet<PodRow> rows;
+    rows.SetData({{1, 0}, {2, 0}, {3, 0}});
+    CountingCallback* row_counter = AttachCounter(rows);
+    rows.SetData({{1, 0}, {2, 0}, {3, 0}});
+    EXPECT_EQ(0, row_counter->dispatches);
+    rows.SetData({{1, 0}, {2, 1}, {3, 0}});
+    EXPECT_GT(row_counter->events, 0);
+}
+
+TEST(RealDataSetTest, SetDataDetectsContentAndOrderChanges) {
+    RealDataSet<Post> posts;
+    posts.SetData(MakePosts(10));
+    CountingCallback* counter = AttachCounter(posts);
+
+    // Same ids, one new text: only the content hashes differ
+    std::vector<Post> edited = MakePosts(10);
+    edited[4].text = "edited";
+    posts.SetData(edited);
+    EXPECT_EQ(1, counter->changed);
+    EXPECT_EQ("edited", posts.GetDataByIndex(4)->text);
+
+    std::vector<Post> swapped = edited;
+    std::swap(swapped[0], swapped[9]);
+    posts.SetData(swapped);
+    EXPECT_GT(counter->events, 1);
+    EXPECT_EQ(9, posts.GetDataByIndex(0)->id);
+
+    const int events = counter->events;
+    posts.SetData(swapped);
+    EXPECT_EQ(events, counter->events);
+}
+
+TEST(RealDataSetTest, SetDataAfterMutationsIsSilent) {
+    RealDataSet<Post> posts(MakePosts(5));
+    CountingCallback* counter = AttachCounter(posts);
+
+    posts.Add(Post{5, "post 5"});
+    posts.AddAll({Post{6, "post 6"}, Post{7, "post 7"}});
+    posts.ReplaceAtPosIfExist(2, Post{2, "replaced"});
+    posts.RemoveAtPos(7);
+    posts.Add(1, Post{9, "inserted"});
+    posts.Remove(Post{9, ""});
+    posts.Add(posts.GetDataCount(), Post{7, "post 7"});
+    posts.Remove(Post{7, ""});
+
+    std::vector<Post> expected = MakePosts(7);
+    expected[2].text = "replaced";
+    const int dispatches = counter->dispatches;
+    posts.SetData(expected);
+    EXPECT_EQ(dispatches, counter->dispatches);
+
+    // An item edited in place is overwritten by the next SetData
+    posts.GetDataByIndex(3)->text = "edited in place";
+    posts.SetData(expected);
+    EXPECT_EQ("post 3", posts.GetDataByIndex(3)->text);
+
+    posts.ClearAllData();
+    posts.SetData({});
+    EXPECT_EQ(0, posts.GetDataCount());
+    posts.SetData(expected);
+    EXPECT_EQ(7, posts.GetDataCount());
+}
+
+TEST(RealDataSetTest, SetDataRestoresItemEditedThroughEarlierPointer) {
+    const std::vector<Post> expected = MakePosts(5);
+    RealDataSet<Post> posts(expected);
+    Post* held = posts.GetDataByIndex(2);
+
+    // A same-item SetData in between must not make the later edit invisible
+    posts.SetData(expected);
+    held->text = "edited through a stale pointer";
+
+    CountingCallback* counter = AttachCounter(posts);
+    posts.SetData(expected);
+    EXPECT_EQ("post 2", posts.GetDataByIndex(2)->text);
+    EXPECT_EQ(1, counter->changed);
+}
@@ -0,0 +1,287 @@
+#include <gtest/gtest.h>
+#include "pandora/sorted_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include "pandora/real_data_set.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct Score
+{
+    int id;
+    int points;
+
+    // Identity is the id; points are the sort key and the content
+    bool operator==(const Score& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, id);
+        HashCombine(seed, points);
+        return seed;
+    }
+};
+
+struct ByPointsDesc
+{
+    bool operator()(const Score& a, const Score& b) const { return a.points > b.points; }
+};
+
+// A non-trivial item: a moved-from name is left empty
+struct Player
+{
+    std::string name;
+    int points;
+
+    bool operator==(const Player& other) const { return name == other.name; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, name);
+        HashCombine(seed, points);
+        return seed;
+    }
+};
+
+struct PlayerByPointsDesc
+{
+    bool operator()(const Player& a, const Player& b) const { return a.points > b.points; }
+};
+
+// Applies updates to a mirror of ids; changed/inserted entries are refreshed from the data set
+class MirrorCallback : public ListUpdateCallback
+{
+public:
+    explicit MirrorCallback(std::vector<int>& mirror, std::vector<std::string>& log)
+        : mirror_(mirror), log_(log) {}
+
+    void OnInserted(int position, int count) override
+    {
+        mirror_.insert(mirror_.begin() + position, count, -1);
+        log_.push_back("I" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+    void OnRemoved(int position, int count) override
+    {
+        mirror_.erase(mirror_.begin() + position, mirror_.begin() + position + count);
+        log_.push_back("R" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+    void OnMoved(int from_position, int to_position) override
+    {
+        const int id = mirror_[from_position];
+        mirror_.erase(mirror_.begin() + from_position);
+        mirror_.insert(mirror_.begin() + to_position, id);
+        log_.push_back("M" + std::to_string(from_position) + "," + std::to_string(to_position));
+    }
+
+    void OnChanged(int position, int count, void*) override
+    {
+        log_.push_back("C" + std::to_string(position) + "," + std::to_string(count));
+    }
+
+private:
+    std::vector<int>& mirror_;
+    std::vector<std::string>& log_;
+};
+
+class SortedDataSetTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_set_.SetListUpdateCallback(std::make_unique<MirrorCallback>(mirror_, log_));
+    }
+
+    std::vector<int> Ids()
+    {
+        std::vector<int> ids;
+        for (int i = 0; i < data_set_.GetDataCount(); ++i) ids.push_back(data_set_.GetDataByIndex(i)->id);
+        return ids;
+    }
+
+    void ExpectMirrorMatches()
+    {
+        const std::vector<int> ids = Ids();
+        ASSERT_EQ(mirror_.size(), ids.size());
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (mirror_[i] != -1)
+            {
+                EXPECT_EQ(mirror_[i], ids[i]) << "at " << i;
+            }
+            mirror_[i] = ids[i];
+        }
+    }
+
+    SortedDataSet<Score, ByPointsDesc> data_set_;
+    std::vector<int> mirror_;
+    std::vector<std::string> log_;
+};
+
+} // namespace
+
+TEST_F(SortedDataSetTest, AddInsertsInOrder)
+{
+    data_set_.Add(Score{1, 10});
+    data_set_.Add(Score{2, 30});
+    data_set_.Add(Score{3, 20});
+    data_set_.Add(Score{4, 20});
+
+    EXPECT_EQ(Ids(), (std::vector<int>{2, 3, 4, 1}));
+    EXPECT_EQ(log_, (std::vector<std::string>{"I0,1", "I0,1", "I1,1", "I2,1"}));
+    ExpectMirrorMatches();
+
+    // Same item, same key: replaced in place
+    log_.clear();
+    data_set_.Add(Score{3, 20});
+    EXPECT_TRUE(log_.empty());
+    EXPECT_EQ(data_set_.GetDataCount(), 4);
+}
+
+TEST_F(SortedDataSetTest, UpdateItemAtEmitsMove)
+{
+    data_set_.AddAll({Score{1, 10}, Score{2, 20}, Score{3, 30}, Score{4, 40}});
+    ExpectMirrorMatches();
+    log_.clear();
+
+    EXPECT_EQ(data_set_.UpdateItemAt(3, Score{1, 35}), 1);
+    EXPECT_EQ(Ids(), (std::vector<int>{4, 1, 3, 2}));
+    EXPECT_EQ(log_, (std::vector<std::string>{"M3,1", "C1,1"}));
+    ExpectMirrorMatches();
+
+    log_.clear();
+    EXPECT_EQ(data_set_.UpdateItemAt(0, Score{4, 5}), 3);
+    EXPECT_EQ(Ids(), (std::vector<int>{1, 3, 2, 4}));
+    ExpectMirrorMatches();
+
+    // Content change without a move
+    log_.clear();
+    EXPECT_EQ(data_set_.UpdateItemAt(1, Score{3, 30}), 1);
+    EXPECT_TRUE(log_.empty());
+    EXPECT_EQ(data_set_.UpdateItemAt(1, Score{3, 31}), 1);
+    EXPECT_EQ(log_, (std::vector<std::string>{"C1,1"}));
+}
+
+TEST_F(SortedDataSetTest, AddAllMergesBatch)
+{
+    data_set_.AddAll({Score{1, 50}, Score{2, 30}, Score{3, 10}});
+    ExpectMirrorMatches();
+    log_.clear();
+
+    data_set_.AddAll({Score{6, 5}, Score{4, 40}, Score{5, 35}, Score{2, 30}, Score{3, 10}});
+    EXPECT_EQ(Ids(), (std::vector<int>{1, 4, 5, 2, 3, 6}));
+    EXPECT_EQ(log_, (std::vector<std::string>{"I1,2", "I5,1"}));
+    ExpectMirrorMatches();
+
+    log_.clear();
+    data_set_.AddAll({Score{2, 30}});
+    EXPECT_TRUE(log_.empty());
+    EXPECT_EQ(Ids(), (std::vector<int>{1, 4, 5, 2, 3, 6}));
+}
+
+TEST_F(SortedDataSetTest, AddAllReplacesAcrossEqualGroup)
+{
+    data_set_.AddAll({Score{1, 20}, Score{2, 20}, Score{3, 20}});
+    ExpectMirrorMatches();
+    log_.clear();
+
+    // Both sort equal to every existing item; each must find its own match
+    data_set_.AddAll({Score{3, 20}, Score{2, 20}, Score{4, 20}});
+    EXPECT_EQ(Ids(), (std::vector<int>{1, 2, 3, 4}));
+    EXPECT_EQ(log_, (std::vector<std::string>{"I3,1"}));
+    ExpectMirrorMatches();
+}
+
+TEST_F(SortedDataSetTest, IndexOfAndRemove)
+{
+    data_set_.AddAll({Score{1, 10}, Score{2, 20}, Score{3, 20}, Score{4, 40}});
+    ExpectMirrorMatches();
+
+    EXPECT_EQ(data_set_.IndexOf(Score{3, 20}), 2);
+    EXPECT_EQ(data_set_.IndexOf(Score{3, 99}), -1);
+
+    data_set_.Remove(Score{2, 20});
+    EXPECT_EQ(Ids(), (std::vector<int>{4, 3, 1}));
+    EXPECT_EQ(log_.back(), "R1,1");
+    ExpectMirrorMatches();
+
+    data_set_.ClearAllData();
+    EXPECT_EQ(data_set_.GetDataCount(), 0);
+    ExpectMirrorMatches();
+}
+
+TEST_F(SortedDataSetTest, TransactionFallsBackToDiff)
+{
+    data_set_.AddAll({Score{1, 10}, Score{2, 20}});
+    ExpectMirrorMatches();
+    log_.clear();
+
+    data_set_.StartTransaction();
+    data_set_.Add(Score{3, 15});
+    data_set_.RemoveAtPos(0);
+    EXPECT_TRUE(log_.empty());
+    data_set_.EndTransaction();
+
+    EXPECT_EQ(Ids(), (std::vector<int>{3, 1}));
+    ExpectMirrorMatches();
+
+    data_set_.SetData({Score{9, 1}, Score{8, 2}});
+    EXPECT_EQ(Ids(), (std::vector<int>{8, 9}));
+    ExpectMirrorMatches();
+}
+
+TEST(SortedDataSetWrapperTest, PlugsIntoWrapperDataSet)
+{
+    WrapperDataSet<Score> wrapper;
+    auto header = std::make_unique<RealDataSet<Score>>();
+    auto sorted = std::make_unique<SortedDataSet<Score, ByPointsDesc>>();
+    auto* header_ptr = header.get();
+    auto* sorted_ptr = sorted.get();
+    wrapper.AddChild(std::move(header));
+    wrapper.AddChild(std::move(sorted));
+
+    std::vector<int> mirror;
+    std::vector<std::string> log;
+    wrapper.SetListUpdateCallback(std::make_unique<MirrorCallback>(mirror, log));
+
+    header_ptr->Add(Score{100, 0});
+    sorted_ptr->Add(Score{1, 10});
+    sorted_ptr->Add(Score{2, 20});
+
+    ASSERT_EQ(wrapper.GetDataCount(), 3);
+    EXPECT_EQ(wrapper.GetDataByIndex(1)->id, 2);
+    EXPECT_EQ(wrapper.GetDataByIndex(2)->id, 1);
+    EXPECT_EQ(log.back(), "I1,1");
+    EXPECT_EQ(wrapper.IndexOf(Score{1, 10}), 2);
+}
+
+TEST(SortedDataSetWrapperTest, AddAllReportsOnlyTheInsertToWrapper)
+{
+    WrapperDataSet<Player> wrapper;
+    auto sorted = std::make_unique<SortedDataSet<Player, PlayerByPointsDesc>>();
+    auto* sorted_ptr = sorted.get();
+    wrapper.AddChild(std::move(sorted));
+
+    std::vector<int> mirror;
+    std::vector<std::string> log;
+    wrapper.SetListUpdateCallback(std::make_unique<MirrorCallback>(mirror, log));
+    sorted_ptr->AddAll({Player{"ann", 30}, Player{"bob", 20}, Player{"cid", 10}});
+    log.clear();
+
+    // The wrapper snapshots the child on BeginChange(), before the merge
+    sorted_ptr->AddAll({Player{"dee", 25}});
+    EXPECT_EQ(log, (std::vector<std::string>{"I1,1"}));
+    ASSERT_EQ(wrapper.GetDataCount(), 4);
+    EXPECT_EQ(wrapper.GetDataByIndex(0)->name, "ann");
+    EXPECT_EQ(wrapper.GetDataByIndex(1)->name, "dee");
+    EXPECT_EQ(wrapper.GetDataByIndex(2)->name, "bob");
+
+    log.clear();
+    sorted_ptr->AddAll({Player{"bob", 20}});
+    EXPECT_TRUE(log.empty());
+}
@@ -0,0 +1,192 @@
+// Tracing is compiled in for this file only; its element types are local so
+// the data set instantiations do not collide with other test files.
+#define PANDORA_ENABLE_TRACING 1
+
+#include <gtest/gtest.h>
+#include "pandora/trace.h"
+#include "pandora/real_data_set.h"
+#include "pandora/wrapper_data_set.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct TraceItem
+{
+    int id;
+    int version;
+
+    bool operator==(const TraceItem& other) const { return id == other.id; }
+    size_t Hash() const
+    {
+        size_t seed = 0;
+        HashCombine(seed, id);
+        HashCombine(seed, version);
+        return seed;
+    }
+};
+
+class NullCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override {}
+    void OnRemoved(int position, int count) override {}
+    void OnMoved(int from_position, int to_position) override {}
+    void OnChanged(int position, int count, void* payload) override {}
+};
+
+class TraceTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        GetTraceBuffer().Clear();
+        SetTracingEnabled(true);
+    }
+
+    void TearDown() override
+    {
+        SetTracingEnabled(false);
+        GetTraceBuffer().Clear();
+    }
+
+    static const TraceEvent* Find(const std::vector<TraceEvent>& events, const char* name, const char* alias)
+    {
+        for (const auto& event : events)
+        {
+            if (std::strcmp(event.name, name) == 0 && std::strcmp(event.alias, alias) == 0) return &event;
+        }
+        return nullptr;
+    }
+};
+
+} // namespace
+
+TEST_F(TraceTest, RealDataSetRecordsSpansWithSizesAndEdits)
+{
+    RealDataSet<TraceItem> data_set;
+    data_set.SetAlias("feed");
+    data_set.SetListUpdateCallback(std::make_unique<NullCallback>());
+    data_set.SetData({{1, 0}, {2, 0}});
+    GetTraceBuffer().Clear();
+
+    data_set.Add(TraceItem{3, 0});
+
+    const auto events = GetTraceBuffer().Snapshot();
+    const TraceEvent* snapshot = Find(events, "Snapshot", "feed");
+    ASSERT_NE(nullptr, snapshot);
+    EXPECT_EQ(2, snapshot->old_size);
+    EXPECT_STREQ("pandora", snapshot->category);
+
+    const TraceEvent* diff = Find(events, "CalculateDiff", "feed");
+    ASSERT_NE(nullptr, diff);
+    EXPECT_EQ(2, diff->old_size);
+    EXPECT_EQ(3, diff->new_size);
+    EXPECT_EQ(1, diff->edits);
+
+    const TraceEvent* dispatch = Find(events, "DispatchUpdatesTo", "feed");
+    ASSERT_NE(nullptr, dispatch);
+    EXPECT_EQ(1, dispatch->edits);
+    EXPECT_GE(dispatch->start_nanos, diff->start_nanos + diff->duration_nanos);
+}
+
+TEST_F(TraceTest, TransactionSpansEncloseTheirPhases)
+{
+    WrapperDataSet<TraceItem> wrapper;
+    wrapper.SetAlias("root");
+    wrapper.SetListUpdateCallback(std::make_unique<NullCallback>());
+    auto child = std::make_unique<RealDataSet<TraceItem>>();
+    RealDataSet<TraceItem>* child_ptr = child.get();
+    wrapper.AddChild(std::move(child));
+    GetTraceBuffer().Clear();
+
+    wrapper.StartTransaction();
+    child_ptr->Add(TraceItem{1, 0});
+    child_ptr->Add(TraceItem{2, 0});
+    wrapper.EndTransaction();
+
+    const auto events = GetTraceBuffer().Snapshot();
+    const TraceEvent* end = Find(events, "EndTransaction", "root");
+    const TraceEvent* diff = Find(events, "CalculateDiff", "root");
+    ASSERT_NE(nullptr, Find(events, "StartTransaction", "root"));
+    ASSERT_NE(nullptr, end);
+    ASSERT_NE(nullptr, diff);
+    EXPECT_EQ(0, end->old_size);
+    EXPECT_EQ(2, end->new_size);
+    EXPECT_LE(end->start_nanos, diff->start_nanos);
+    EXPECT_GE(end->start_nanos + end->duration_nanos, diff->start_nanos + diff->duration_nanos);
+}
+
+TEST_F(TraceTest, NothingIsRecordedWhileDisabled)
+{
+    SetTracingEnabled(false);
+    RealDataSet<TraceItem> data_set;
+    data_set.SetListUpdateCallback(std::make_unique<NullCallback>());
+    data_set.Add(TraceItem{1, 0});
+    EXPECT_TRUE(GetTraceBuffer().Snapshot().empty());
+}
+
+TEST_F(TraceTest, ExportsChromeTraceJson)
+{
+    {
+        ScopedTraceSpan span("test", "Quoted", "say \"hi\"");
+        span.SetSizes(1, 2);
+        span.SetEdits(3);
+    }
+
+    const std::string json = ExportChromeTrace();
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":[{\"name\":\"Quoted\",\"cat\":\"test\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"alias\":\"say \\\"hi\\\"\",\"old_size\":1,\"new_size\":2,\"edits\":3}"));
+    EXPECT_NE(std::string::npos, json.find("\"displayTimeUnit\":\"ms\"}"));
+}
+
+TEST(TraceBufferTest, KeepsTheMostRecentEvents)
+{
+    TraceBuffer buffer(5);
+    ASSERT_EQ(8u, buffer.GetCapacity());
+    for (int i = 0; i < 20; ++i)
+    {
+        TraceEvent event;
+        event.edits = i;
+        buffer.Record(event);
+    }
+
+    const auto events = buffer.Snapshot();
+    ASSERT_EQ(8u, events.size());
+    EXPECT_EQ(12, events.front().edits);
+    EXPECT_EQ(19, events.back().edits);
+
+    buffer.Clear();
+    EXPECT_TRUE(buffer.Snapshot().empty());
+}
+
+TEST(TraceBufferTest, ConcurrentWritersDoNotLoseEvents)
+{
+    TraceBuffer buffer(1 << 12);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t)
+    {
+        writers.emplace_back([&buffer, t]
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                TraceEvent event;
+                event.thread_id = static_cast<uint32_t>(t);
+                event.edits = i;
+                buffer.Record(event);
+            }
+        });
+    }
+    for (auto& writer : writers) writer.join();
+
+    const auto events = buffer.Snapshot();
+    ASSERT_EQ(4000u, events.size());
+    std::vector<int> per_thread(4);
+    for (const auto& event : events) per_thread[event.thread_id]++;
+    for (int count : per_thread) EXPECT_EQ(1000, count);
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "pandora/tree_serializer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+struct PodItem
+{
+    int32_t id;
+    int32_t version;
+
+    bool operator==(const PodItem& other) const { return id == other.id; }
+};
+
+// Three bytes of padding after flag: not raw serializable
+struct PaddedItem
+{
+    uint8_t flag;
+    int32_t id;
+};
+
+struct Article
+{
+    uint64_t id;
+    std::string title;
+
+    bool operator==(const Article& other) const { return id == other.id; }
+    size_t Hash() const { return std::hash<std::string>{}(title); }
+};
+
+class CountingCallback : public ListUpdateCallback
+{
+public:
+    void OnInserted(int position, int count) override { inserted += count; }
+    void OnRemoved(int position, int count) override { removed += count; }
+    void OnMoved(int from_position, int to_position) override {}
+    void OnChanged(int position, int count, void* payload) override { changed += count; }
+
+    int inserted = 0;
+    int removed = 0;
+    int changed = 0;
+};
+
+// root -> {header leaf, feed wrapper -> {page 0, page 1}, empty wrapper}
+template <typename T, typename MakeItem>
+std::unique_ptr<WrapperDataSet<T>> MakeTree(MakeItem make_item)
+{
+    auto root = std::make_unique<WrapperDataSet<T>>();
+    root->SetAlias("root");
+    auto header = std::make_unique<RealDataSet<T>>();
+    header->SetData({make_item(0)});
+    header->SetAlias("header");
+    root->AddChild(std::move(header));
+
+    auto feed = std::make_unique<WrapperDataSet<T>>();
+    feed->SetAlias("feed");
+    for (int page = 0; page < 2; ++page)
+    {
+        auto leaf = std::make_unique<RealDataSet<T>>();
+        std::vector<T> items;
+        for (int i = 0; i < 5; ++i) items.push_back(make_item(100 * (page + 1) + i));
+        leaf->SetData(items);
+        feed->AddChild(std::move(leaf));
+    }
+    root->AddChild(std::move(feed));
+    root->AddChild(std::make_unique<WrapperDataSet<T>>());
+    return root;
+}
+
+PodItem MakePod(int id) { return PodItem{id, id % 3}; }
+Article MakeArticle(int id) { return Article{static_cast<uint64_t>(id), "title " + std::to_string(id)}; }
+
+} // namespace
+
+template <>
+struct pandora::Serializer<Article>
+{
+    static void Write(BinaryWriter& writer, const Article& item)
+    {
+        writer.WriteVarint(item.id);
+        writer.WriteString(item.title);
+    }
+
+    static Article Read(BinaryReader& reader)
+    {
+        const uint64_t id = reader.ReadVarint();
+        return Article{id, reader.ReadString()};
+    }
+};
+
+TEST(TreeSerializerTest, RestoresStructureAndRawItems)
+{
+    static_assert(IsRawSerializable<PodItem>::value);
+    static_assert(!IsRawSerializable<Article>::value);
+    static_assert(!IsRawSerializable<PaddedItem>::value);
+
+    auto tree = MakeTree<PodItem>(MakePod);
+    const std::vector<uint8_t> snapshot = TreeSerializer<PodItem>::Save(*tree);
+    auto restored = TreeSerializer<PodItem>::Restore(snapshot);
+
+    ASSERT_EQ(tree->GetDataCount(), restored->GetDataCount());
+    for (int i = 0; i < tree->GetDataCount(); ++i)
+    {
+        EXPECT_EQ(tree->GetDataByIndex(i)->id, restored->GetDataByIndex(i)->id);
+        EXPECT_EQ(tree->GetDataByIndex(i)->version, restored->GetDataByIndex(i)->version);
+    }
+    EXPECT_EQ("root", restored->GetAlias());
+    ASSERT_EQ(3, restored->GetChildCount());
+    EXPECT_EQ(0, restored->GetChild(2)->GetChildCount());
+    EXPECT_NE(nullptr, dynamic_cast<WrapperDataSet<PodItem>*>(restored->GetChild(2)));
+
+    PandoraBoxAdapter<PodItem>* feed = restored->FindByAlias("feed");
+    ASSERT_NE(nullptr, feed);
+    EXPECT_EQ(1, feed->GetGroupIndex());
+    EXPECT_EQ(1, feed->GetChild(1)->GetGroupIndex());
+    EXPECT_EQ(10, feed->GetDataCount());
+    EXPECT_EQ(200, restored->GetDataByIndex(6)->id);
+    EXPECT_FALSE(restored->InTransaction());
+}
+
+TEST(TreeSerializerTest, RestoresItemsThroughSerializer)
+{
+    auto tree = MakeTree<Article>(MakeArticle);
+    std::vector<uint8_t> snapshot;
+    TreeSerializer<Article>::Save(*tree, snapshot);
+    auto restored = TreeSerializer<Article>::Restore(snapshot);
+
+    ASSERT_EQ(11, restored->GetDataCount());
+    EXPECT_EQ("title 104", restored->GetDataByIndex(5)->title);
+    EXPECT_NE(nullptr, restored->FindByAlias("header"));
+}
+
+TEST(TreeSerializerTest, RestoredTreeNotifiesOnlyLaterChanges)
+{
+    auto tree = MakeTree<PodItem>(MakePod);
+    auto restored = TreeSerializer<PodItem>::Restore(TreeSerializer<PodItem>::Save(*tree));
+    auto callback = std::make_unique<CountingCallback>();
+    CountingCallback* counting = callback.get();
+    restored->SetListUpdateCallback(std::move(callback));
+
+    PandoraBoxAdapter<PodItem>* page = restored->FindByAlias("feed")->GetChild(1);
+    page->Add(PodItem{999, 0});
+    page->ReplaceAtPosIfExist(0, PodItem{200, 7});
+    EXPECT_EQ(1, counting->inserted);
+    EXPECT_EQ(1, counting->changed);
+    EXPECT_EQ(0, counting->removed);
+}
+
+TEST(TreeSerializerTest, UsesLeafFactory)
+{
+    auto tree = MakeTree<PodItem>(MakePod);
+    int leaves = 0;
+    auto restored = TreeSerializer<PodItem>::Restore(TreeSerializer<PodItem>::Save(*tree),
+        [&leaves](std::vector<PodItem> items)
+        {
+            ++leaves;
+            return std::unique_ptr<PandoraBoxAdapter<PodItem>>(new RealDataSet<PodItem>(std::move(items)));
+        });
+    EXPECT_EQ(3, leaves);
+    EXPECT_EQ(11, restored->GetDataCount());
+
+    // A bare leaf is a valid tree too
+    RealDataSet<PodItem> leaf;
+    leaf.SetData({PodItem{1, 1}, PodItem{2, 2}});
+    auto restored_leaf = TreeSerializer<PodItem>::Restore(TreeSerializer<PodItem>::Save(leaf));
+    EXPECT_EQ(2, restored_leaf->GetDataCount());
+    EXPECT_EQ(0, restored_leaf->GetChildCount());
+}
+
+TEST(TreeSerializerTest, RejectsMalformedSnapshots)
+{
+    auto tree = MakeTree<PodItem>(MakePod);
+    const std::vector<uint8_t> snapshot = TreeSerializer<PodItem>::Save(*tree);
+
+    std::vector<uint8_t> bad_magic = snapshot;
+    bad_magic[0] ^= 0xff;
+    EXPECT_THROW(TreeSerializer<PodItem>::Restore(bad_magic), PandoraException);
+
+    const std::vector<uint8_t> truncated(snapshot.begin(), snapshot.end() - 3);
+    EXPECT_THROW(TreeSerializer<PodItem>::Restore(truncated), PandoraException);
+
+    std::vector<uint8_t> trailing = snapshot;
+    trailing.push_back(0);
+    EXPECT_THROW(TreeSerializer<PodItem>::Restore(trailing), PandoraException);
+
+    // Saved with raw items, read as serialized ones
+    EXPECT_THROW(TreeSerializer<Article>::Restore(snapshot), PandoraException);
+}
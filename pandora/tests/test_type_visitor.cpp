@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "pandora/type_visitor.h"
+#include "pandora/real_data_set.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+
+namespace {
+
+class Message : public TypeTagged<Message>
+{
+public:
+    explicit Message(int id = 0) : id(id) {}
+    virtual ~Message() = default;
+
+    bool operator==(const Message& other) const { return id == other.id; }
+
+    int id;
+};
+
+class TextMessage : public TypeTagged<TextMessage, Message>
+{
+public:
+    explicit TextMessage(int id, std::string text = "") : TypeTagged(id), text(std::move(text)) {}
+
+    std::string text;
+};
+
+class ImageMessage : public TypeTagged<ImageMessage, Message>
+{
+public:
+    explicit ImageMessage(int id) : TypeTagged(id) {}
+};
+
+class StickerMessage : public TypeTagged<StickerMessage, ImageMessage>
+{
+public:
+    explicit StickerMessage(int id) : TypeTagged(id) {}
+};
+
+class CountingVisitor : public TypeVisitor<ImageMessage>
+{
+public:
+    int hits = 0;
+    int misses = 0;
+
+    void OnHit(ImageMessage*) override { ++hits; }
+    void OnMissed() override { ++misses; }
+};
+
+} // namespace
+
+TEST(TypeVisitorTest, TagsAreStableAndDistinct)
+{
+    TextMessage text(1);
+    StickerMessage sticker(2);
+
+    EXPECT_EQ(text.GetTypeTag(), TypeTagOf<TextMessage>());
+    EXPECT_EQ(sticker.GetTypeTag(), TypeTagOf<StickerMessage>());
+    EXPECT_NE(TypeTagOf<TextMessage>(), TypeTagOf<ImageMessage>());
+    EXPECT_TRUE(TypeTagIsA(sticker.GetTypeTag(), TypeTagOf<ImageMessage>()));
+    EXPECT_TRUE(TypeTagIsA(sticker.GetTypeTag(), TypeTagOf<Message>()));
+    EXPECT_FALSE(TypeTagIsA(text.GetTypeTag(), TypeTagOf<ImageMessage>()));
+
+    // Copies keep the tag of their own type
+    TextMessage copy = text;
+    EXPECT_EQ(copy.GetTypeTag(), TypeTagOf<TextMessage>());
+}
+
+TEST(TypeVisitorTest, VisitMatchesByTag)
+{
+    TextMessage text(1);
+    ImageMessage image(2);
+    StickerMessage sticker(3);
+    CountingVisitor visitor;
+
+    Message* elements[] = {&text, &image, &sticker, nullptr};
+    for (Message* element : elements)
+    {
+        visitor.Visit(element);
+    }
+    EXPECT_EQ(visitor.hits, 2);
+    EXPECT_EQ(visitor.misses, 2);
+    EXPECT_EQ(visitor.Visit(&sticker), &sticker);
+}
+
+TEST(TypeVisitorTest, DispatcherRunsAllArmsInOnePass)
+{
+    RealDataSet<Message*> data_set;
+    std::vector<std::unique_ptr<Message>> storage;
+    storage.push_back(std::make_unique<TextMessage>(1, "a"));
+    storage.push_back(std::make_unique<ImageMessage>(2));
+    storage.push_back(std::make_unique<StickerMessage>(3));
+    storage.push_back(std::make_unique<Message>(4));
+    storage.push_back(std::make_unique<TextMessage>(5, "b"));
+    for (auto& m : storage)
+    {
+        data_set.Add(m.get());
+    }
+
+    std::string texts;
+    std::vector<int> images;
+    std::vector<int> others;
+    TypeTagDispatcher<Message*> dispatcher;
+    dispatcher.On<TextMessage>([&](TextMessage& m) { texts += m.text; })
+        .On<ImageMessage>([&](ImageMessage& m) { images.push_back(m.id); })
+        .Otherwise([&](Message*& m) { others.push_back(m->id); });
+
+    EXPECT_EQ(dispatcher.Run(data_set), 4);
+    EXPECT_EQ(texts, "ab");
+    EXPECT_EQ(images, (std::vector<int>{2, 3}));
+    EXPECT_EQ(others, (std::vector<int>{4}));
+}
+
+TEST(TypeVisitorTest, DispatcherOnSharedPointers)
+{
+    std::vector<std::shared_ptr<Message>> elements = {
+        std::make_shared<StickerMessage>(1), nullptr, std::make_shared<TextMessage>(2)};
+
+    int stickers = 0;
+    int messages = 0;
+    TypeTagDispatcher<std::shared_ptr<Message>> dispatcher;
+    dispatcher.On<StickerMessage>([&](StickerMessage&) { ++stickers; })
+        .On<Message>([&](Message&) { ++messages; });
+
+    for (auto& element : elements)
+    {
+        dispatcher.Dispatch(element);
+    }
+    EXPECT_EQ(stickers, 1);
+    EXPECT_EQ(messages, 1);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "pandora/pandora_rv.h"
+#include <memory>
+#include <string>
+
+using namespace pandora;
+using namespace pandora::rv;
+
+namespace {
+
+struct TextItem
+{
+    std::string text;
+
+    bool operator==(const TextItem& other) const { return text == other.text; }
+    size_t Hash() const { return std::hash<std::string>{}(text); }
+};
+
+struct ImageItem
+{
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const ImageItem& other) const
+    {
+        return width == other.width && height == other.height;
+    }
+    size_t Hash() const { return static_cast<size_t>(width * 31 + height); }
+};
+
+template <typename U>
+class RecordingViewHolder : public IViewHolder<U>
+{
+public:
+    explicit RecordingViewHolder(void*) {}
+
+    void SetData(std::shared_ptr<U> data) override { last = std::move(data); }
+    void OnViewAttachedToWindow() override {}
+    void OnViewDetachedFromWindow() override {}
+    void accept(IViewHolderVisitor&) override {}
+
+    std::shared_ptr<U> last;
+};
+
+using FeedDataSet = VariantDataSet<TextItem, ImageItem>;
+
+template <typename U>
+std::shared_ptr<RecordingViewHolder<U>> Unwrap(const std::shared_ptr<IViewHolderBase>& holder)
+{
+    auto wrapper = std::static_pointer_cast<ViewHolderWrapper<U>>(holder);
+    return std::static_pointer_cast<RecordingViewHolder<U>>(wrapper->GetHolder());
+}
+
+} // namespace
+
+TEST(VariantDataSetTest, ViewTypeIsVariantIndex)
+{
+    FeedDataSet data_set;
+    data_set.Add(TextItem{"a"});
+    data_set.Add(ImageItem{10, 20});
+    data_set.Add(TextItem{"b"});
+
+    EXPECT_EQ(FeedDataSet::ViewTypeOf<TextItem>(), 0);
+    EXPECT_EQ(FeedDataSet::ViewTypeOf<ImageItem>(), 1);
+    EXPECT_EQ(data_set.GetViewTypeCount(), 2);
+    EXPECT_EQ(data_set.GetItemViewType(0), 0);
+    EXPECT_EQ(data_set.GetItemViewType(1), 1);
+    EXPECT_EQ(data_set.GetItemViewType(2), 0);
+    EXPECT_THROW(data_set.GetItemViewType(3), PandoraException);
+}
+
+TEST(VariantDataSetTest, CreateAndBindDispatchesToTypedHolder)
+{
+    FeedDataSet data_set;
+    data_set.RegisterViewHolder<TextItem>(make_typed_creator<TextItem, RecordingViewHolder<TextItem>>())
+        .RegisterViewHolder<ImageItem>(make_typed_creator<ImageItem, RecordingViewHolder<ImageItem>>());
+    data_set.Add(TextItem{"title"});
+    data_set.Add(ImageItem{3, 4});
+
+    auto image_holder = data_set.CreateViewHolder(nullptr, data_set.GetItemViewType(1));
+    data_set.BindViewHolder(1, *image_holder);
+    auto image = Unwrap<ImageItem>(image_holder);
+    ASSERT_TRUE(image->last);
+    EXPECT_EQ(image->last->width, 3);
+
+    // The holder owns its copy, which outlives later mutations
+    data_set.Add(TextItem{"grows the storage"});
+    data_set.RemoveAtPos(1);
+    EXPECT_EQ(image->last->height, 4);
+
+    auto text_holder = data_set.CreateViewHolder(nullptr, data_set.GetItemViewType(0));
+    data_set.BindViewHolder(0, *text_holder);
+    EXPECT_EQ(Unwrap<TextItem>(text_holder)->last->text, "title");
+}
+
+TEST(VariantDataSetTest, BindToHolderOfAnotherViewTypeThrows)
+{
+    FeedDataSet data_set;
+    data_set.RegisterViewHolder<TextItem>(make_typed_creator<TextItem, RecordingViewHolder<TextItem>>())
+        .RegisterViewHolder<ImageItem>(make_typed_creator<ImageItem, RecordingViewHolder<ImageItem>>());
+    data_set.Add(TextItem{"title"});
+    data_set.Add(ImageItem{3, 4});
+
+    auto text_holder = data_set.CreateViewHolder(nullptr, FeedDataSet::ViewTypeOf<TextItem>());
+    EXPECT_THROW(data_set.BindViewHolder(1, *text_holder), PandoraException);
+    EXPECT_FALSE(Unwrap<TextItem>(text_holder)->last);
+}
+
+TEST(VariantDataSetTest, MissingCreatorThrows)
+{
+    FeedDataSet data_set;
+    EXPECT_THROW(data_set.CreateViewHolder(nullptr, 0), PandoraException);
+    EXPECT_THROW(data_set.CreateViewHolder(nullptr, 5), PandoraException);
+}
+
+TEST(VariantDataSetTest, DiffTracksAlternativeChanges)
+{
+    FeedDataSet data_set;
+    data_set.SetData({TextItem{"a"}, ImageItem{1, 1}, TextItem{"c"}});
+
+    int changed = 0;
+    int inserted = 0;
+    int removed = 0;
+    class Counter : public ListUpdateCallback
+    {
+    public:
+        Counter(int& c, int& i, int& r) : c_(c), i_(i), r_(r) {}
+        void OnInserted(int, int count) override { i_ += count; }
+        void OnRemoved(int, int count) override { r_ += count; }
+        void OnMoved(int, int) override {}
+        void OnChanged(int, int count, void*) override { c_ += count; }
+
+    private:
+        int& c_;
+        int& i_;
+        int& r_;
+    };
+    data_set.GetDataSet()->SetListUpdateCallback(std::make_unique<Counter>(changed, inserted, removed));
+
+    data_set.ReplaceAtPosIfExist(1, TextItem{"b"});
+    EXPECT_EQ(inserted, 1);
+    EXPECT_EQ(removed, 1);
+    EXPECT_EQ(data_set.VisitItem(1, [](const auto& item) {
+        return std::is_same_v<std::decay_t<decltype(item)>, TextItem>;
+    }), true);
+    EXPECT_NE(Pandora::Hash(FeedDataSet::ValueType(TextItem{"x"})),
+              Pandora::Hash(FeedDataSet::ValueType(TextItem{"y"})));
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include "pandora/pandora_rv.h"
+#include "Global.h"
+#include <memory>
+#include <vector>
+
+using namespace pandora;
+using namespace pandora::rv;
+
+namespace {
+
+// Records observer callbacks, with single-item callbacks folded into ranges
+class RecordingObserver : public DataObserverBase
+{
+public:
+    struct Event
+    {
+        enum Type { CHANGED, INSERTED, REMOVED, MOVED, RELOAD };
+
+        Type type;
+        int position;
+        int count;
+
+        bool operator==(const Event& other) const
+        {
+            return type == other.type && position == other.position && count == other.count;
+        }
+    };
+
+    std::vector<Event> events;
+
+    void OnDataSetChanged() override { events.push_back({Event::RELOAD, 0, 0}); }
+    void NotifyItemChanged(int position) override { events.push_back({Event::CHANGED, position, 1}); }
+    void NotifyItemRangeChanged(int position_start, int item_count) override
+    {
+        events.push_back({Event::CHANGED, position_start, item_count});
+    }
+    void NotifyItemInserted(int position) override { events.push_back({Event::INSERTED, position, 1}); }
+    void NotifyItemRangeInserted(int position_start, int item_count) override
+    {
+        events.push_back({Event::INSERTED, position_start, item_count});
+    }
+    void NotifyItemRemoved(int position) override { events.push_back({Event::REMOVED, position, 1}); }
+    void NotifyItemRangeRemoved(int position_start, int item_count) override
+    {
+        events.push_back({Event::REMOVED, position_start, item_count});
+    }
+    void NotifyItemMoved(int from_position, int to_position) override
+    {
+        events.push_back({Event::MOVED, from_position, to_position});
+    }
+};
+
+using Event = RecordingObserver::Event;
+
+std::shared_ptr<PandoraRealRvDataSet<TestData>> MakeDataSet(int count)
+{
+    auto real_ds = std::make_shared<RealDataSet<TestData>>();
+    for (int i = 0; i < count; ++i) real_ds->Add(TestData(i));
+    return std::make_shared<PandoraRealRvDataSet<TestData>>(real_ds);
+}
+
+} // namespace
+
+TEST(ViewportTest, WithoutViewportEverythingIsDispatched)
+{
+    auto ds = MakeDataSet(100);
+    auto observer = std::make_shared<RecordingObserver>();
+    ds->AddDataObserver(observer);
+
+    ds->NotifyItemChanged(90);
+    ds->NotifyItemRangeInserted(3, 2);
+
+    std::vector<Event> expected = {{Event::CHANGED, 90, 1}, {Event::INSERTED, 3, 2}};
+    EXPECT_EQ(expected, observer->events);
+    EXPECT_FALSE(ds->HasDeferredUpdates());
+}
+
+TEST(ViewportTest, OffscreenChangesAreCollapsed)
+{
+    auto ds = MakeDataSet(1000);
+    auto observer = std::make_shared<RecordingObserver>();
+    ds->AddDataObserver(observer);
+    ds->SetViewport(100, 109, 2);
+
+    for (int i = 200; i < 900; ++i) ds->NotifyItemChanged(i);
+    for (int i = 0; i < 50; ++i) ds->NotifyItemChanged(i);
+    ds->NotifyItemChanged(105);
+
+    // Only the visible change went out; the before span is flushed first to keep positions aligned
+    std::vector<Event> expected = {{Event::CHANGED, 0, 98}, {Event::CHANGED, 105, 1}};
+    EXPECT_EQ(expected, observer->events);
+    EXPECT_TRUE(ds->HasDeferredUpdates());
+    EXPECT_TRUE(ds->IsDeferred(500));
+    EXPECT_FALSE(ds->IsDeferred(150));
+
+    observer->events.clear();
+    ds->FlushDeferredUpdates();
+    expected = {{Event::CHANGED, 200, 800}};
+    EXPECT_EQ(expected, observer->events);
+    EXPECT_FALSE(ds->HasDeferredUpdates());
+}
+
+TEST(ViewportTest, OffscreenInsertsShiftTheViewport)
+{
+    auto ds = MakeDataSet(1000);
+    auto observer = std::make_shared<RecordingObserver>();
+    ds->AddDataObserver(observer);
+    ds->SetViewport(100, 109);
+
+    ds->NotifyItemRangeInserted(10, 5);
+    ds->NotifyItemRangeRemoved(50, 2);
+    ds->NotifyItemRangeInserted(500, 7);
+    EXPECT_TRUE(observer->events.empty());
+    EXPECT_EQ(103, ds->GetViewport().first_visible);
+    EXPECT_EQ(112, ds->GetViewport().last_visible);
+
+    ds->FlushDeferredUpdates();
+    std::vector<Event> expected = {
+        {Event::INSERTED, 10, 3},
+        {Event::CHANGED, 10, 93},
+        {Event::INSERTED, 500, 7},
+        {Event::CHANGED, 500, 510},
+    };
+    EXPECT_EQ(expected, observer->events);
+}
+
+TEST(ViewportTest, RemovalSpanningTheWindowIsSplit)
+{
+    auto ds = MakeDataSet(100);
+    auto observer = std::make_shared<RecordingObserver>();
+    ds->AddDataObserver(observer);
+    ds->SetViewport(20, 29);
+
+    ds->NotifyItemRangeRemoved(15, 20);
+
+    // Rows 20..29 go out precisely; 15..19 and 30..34 are deferred
+    std::vector<Event> expected = {{Event::REMOVED, 20, 10}};
+    EXPECT_EQ(expected, observer->events);
+
+    observer->events.clear();
+    ds->FlushDeferredUpdates();
+    expected = {{Event::REMOVED, 15, 5}, {Event::REMOVED, 15, 5}, {Event::CHANGED, 15, 65}};
+    EXPECT_EQ(expected, observer->events);
+}
+
+TEST(ViewportTest, DiffUpdatesGoThroughTheFilter)
+{
+    auto real_ds = std::make_shared<RealDataSet<TestData>>();
+    auto ds = std::make_shared<PandoraRealRvDataSet<TestData>>(real_ds);
+    real_ds->SetListUpdateCallback(std::make_unique<DataSetUpdateCallback<TestData>>(ds.get()));
+    for (int i = 0; i < 100; ++i) real_ds->Add(TestData(i));
+
+    auto observer = std::make_shared<RecordingObserver>();
+    ds->AddDataObserver(observer);
+    ds->SetViewport(0, 9);
+
+    real_ds->ReplaceAtPosIfExist(80, TestData(80, "changed"));
+    EXPECT_TRUE(observer->events.empty());
+
+    // A different item at the same position: remove + insert, both visible
+    real_ds->ReplaceAtPosIfExist(3, TestData(3, "changed"));
+    std::vector<Event> expected = {{Event::REMOVED, 3, 1}, {Event::INSERTED, 3, 1}};
+    EXPECT_EQ(expected, observer->events);
+
+    observer->events.clear();
+    ds->SetViewport(75, 85);
+    expected = {{Event::CHANGED, 80, 20}};
+    EXPECT_EQ(expected, observer->events);
+}